@@ -0,0 +1,183 @@
+#include "js_main.h"
+
+#define JS_ARENA_LARGE      JS_ARENA_CLASSES  /* class tag of malloc'ed blocks */
+#define JS_ARENA_CACHE_MAX  16                /* idle chunks kept per thread */
+
+/* block header; 16 bytes keeps payloads 16-byte aligned like malloc */
+typedef struct {
+    size_t  size;   /* usable bytes */
+    size_t  cls;    /* size class, or JS_ARENA_LARGE */
+} js_arena_hdr_t;
+
+struct js_arena_chunk_s {
+    js_arena_chunk_t  *next;
+    size_t             pad;
+};
+
+struct js_arena_large_s {
+    js_arena_large_t  *prev;
+    js_arena_large_t  *next;
+    js_arena_hdr_t     hdr;     /* MUST be last: payload follows */
+};
+
+/* chunks released by destroyed arenas, reused without touching malloc */
+static __thread js_arena_chunk_t *js_arena_cache;
+static __thread int               js_arena_cache_count;
+
+static size_t js_arena_class(size_t size, size_t *csize) {
+    size_t cls;
+
+    if (size <= 256) {
+        cls = size ? (size - 1) / 16 : 0;
+        *csize = (cls + 1) * 16;
+        return cls;
+    }
+
+    cls = 16;
+    *csize = 512;
+    while (*csize < size) {
+        *csize *= 2;
+        cls++;
+    }
+    return cls;
+}
+
+static int js_arena_grow(js_arena_t *arena) {
+    js_arena_chunk_t *chunk = js_arena_cache;
+    if (chunk) {
+        js_arena_cache = chunk->next;
+        js_arena_cache_count--;
+    } else {
+        chunk = malloc(JS_ARENA_CHUNK_SIZE);
+        if (!chunk)
+            return -1;
+    }
+    chunk->next = arena->chunks;
+    arena->chunks = chunk;
+    arena->pos = (char *) (chunk + 1);
+    arena->end = (char *) chunk + JS_ARENA_CHUNK_SIZE;
+    return 0;
+}
+
+void js_arena_init(js_arena_t *arena) {
+    memset(arena, 0, sizeof(*arena));
+}
+
+void *js_arena_alloc(js_arena_t *arena, size_t size) {
+    if (size > JS_ARENA_SMALL_MAX) {
+        js_arena_large_t *l = malloc(sizeof(*l) + size);
+        if (!l)
+            return NULL;
+        l->hdr.size = size;
+        l->hdr.cls = JS_ARENA_LARGE;
+        l->prev = NULL;
+        l->next = arena->large;
+        if (arena->large)
+            arena->large->prev = l;
+        arena->large = l;
+        return &l->hdr + 1;
+    }
+
+    size_t csize;
+    size_t cls = js_arena_class(size, &csize);
+
+    void *p = arena->free_list[cls];
+    if (p) {
+        arena->free_list[cls] = *(void **) p;
+        return p;
+    }
+
+    size_t need = sizeof(js_arena_hdr_t) + csize;
+    if ((size_t) (arena->end - arena->pos) < need && js_arena_grow(arena) < 0)
+        return NULL;
+
+    js_arena_hdr_t *hdr = (js_arena_hdr_t *) arena->pos;
+    arena->pos += need;
+    hdr->size = csize;
+    hdr->cls = cls;
+    return hdr + 1;
+}
+
+void js_arena_free(js_arena_t *arena, void *ptr) {
+    if (!ptr)
+        return;
+
+    js_arena_hdr_t *hdr = (js_arena_hdr_t *) ptr - 1;
+    if (hdr->cls == JS_ARENA_LARGE) {
+        js_arena_large_t *l = js_container_of(hdr, js_arena_large_t, hdr);
+        if (l->prev)
+            l->prev->next = l->next;
+        else
+            arena->large = l->next;
+        if (l->next)
+            l->next->prev = l->prev;
+        free(l);
+        return;
+    }
+
+    /* teardown: everything goes back at once in js_arena_destroy() */
+    if (arena->closing)
+        return;
+
+    *(void **) ptr = arena->free_list[hdr->cls];
+    arena->free_list[hdr->cls] = ptr;
+}
+
+void *js_arena_realloc(js_arena_t *arena, void *ptr, size_t size) {
+    if (!ptr)
+        return js_arena_alloc(arena, size);
+
+    js_arena_hdr_t *hdr = (js_arena_hdr_t *) ptr - 1;
+    if (size <= hdr->size && (hdr->cls != JS_ARENA_LARGE || size > JS_ARENA_SMALL_MAX))
+        return ptr;
+
+    if (hdr->cls == JS_ARENA_LARGE && size > JS_ARENA_SMALL_MAX) {
+        js_arena_large_t *l = js_container_of(hdr, js_arena_large_t, hdr);
+        js_arena_large_t *nl = realloc(l, sizeof(*l) + size);
+        if (!nl)
+            return NULL;
+        nl->hdr.size = size;
+        if (nl->prev)
+            nl->prev->next = nl;
+        else
+            arena->large = nl;
+        if (nl->next)
+            nl->next->prev = nl;
+        return &nl->hdr + 1;
+    }
+
+    void *p = js_arena_alloc(arena, size);
+    if (!p)
+        return NULL;
+    memcpy(p, ptr, hdr->size < size ? hdr->size : size);
+    js_arena_free(arena, ptr);
+    return p;
+}
+
+size_t js_arena_usable_size(const void *ptr) {
+    if (!ptr)
+        return 0;
+    return ((const js_arena_hdr_t *) ptr - 1)->size;
+}
+
+void js_arena_destroy(js_arena_t *arena) {
+    while (arena->large) {
+        js_arena_large_t *next = arena->large->next;
+        free(arena->large);
+        arena->large = next;
+    }
+
+    while (arena->chunks) {
+        js_arena_chunk_t *next = arena->chunks->next;
+        if (js_arena_cache_count < JS_ARENA_CACHE_MAX) {
+            arena->chunks->next = js_arena_cache;
+            js_arena_cache = arena->chunks;
+            js_arena_cache_count++;
+        } else {
+            free(arena->chunks);
+        }
+        arena->chunks = next;
+    }
+
+    js_arena_init(arena);
+}
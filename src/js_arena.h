@@ -0,0 +1,38 @@
+#ifndef JS_ARENA_H
+#define JS_ARENA_H
+
+/*
+ * Thread-local allocation arena for short-lived QuickJS runtimes.
+ * Small blocks are carved from chunks by bump allocation and recycled
+ * through per-size-class free lists; large blocks go to malloc. Destroying
+ * the arena hands every chunk back to a per-thread cache in one step.
+ */
+
+#define JS_ARENA_CHUNK_SIZE   (64 * 1024)
+#define JS_ARENA_CLASSES      20          /* 16..256 by 16, 512..4096 by 2x */
+#define JS_ARENA_SMALL_MAX    4096
+
+/* ---- struct ---- */
+
+typedef struct js_arena_chunk_s  js_arena_chunk_t;
+typedef struct js_arena_large_s  js_arena_large_t;
+
+typedef struct {
+    js_arena_chunk_t  *chunks;      /* chunks owned by this arena */
+    char              *pos;         /* bump pointer in current chunk */
+    char              *end;
+    void              *free_list[JS_ARENA_CLASSES];
+    js_arena_large_t  *large;       /* oversize blocks, freed individually */
+    int                closing;     /* 1 = frees are dropped until destroy */
+} js_arena_t;
+
+/* ---- api ---- */
+
+void    js_arena_init(js_arena_t *arena);
+void   *js_arena_alloc(js_arena_t *arena, size_t size);
+void    js_arena_free(js_arena_t *arena, void *ptr);
+void   *js_arena_realloc(js_arena_t *arena, void *ptr, size_t size);
+size_t  js_arena_usable_size(const void *ptr);
+void    js_arena_destroy(js_arena_t *arena);
+
+#endif
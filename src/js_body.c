@@ -0,0 +1,107 @@
+#include "js_main.h"
+
+js_body_t *js_body_create(size_t spill) {
+    js_body_t *b = calloc(1, sizeof(*b));
+    if (!b)
+        return NULL;
+    js_buf_init(&b->mem);
+    b->fd = -1;
+    b->spill = spill;
+    return b;
+}
+
+/* unlinked file in $TMPDIR: gone as soon as it is closed */
+static int js_body_open_spill(void) {
+    const char *dir = getenv("TMPDIR");
+    if (!dir || !*dir)
+        dir = "/tmp";
+
+    int fd = open(dir, O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+    if (fd >= 0 || (errno != EOPNOTSUPP && errno != EISDIR))
+        return fd;
+
+    /* filesystem or kernel without O_TMPFILE */
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/jsmock-body-XXXXXX", dir);
+    fd = mkostemp(path, O_CLOEXEC);
+    if (fd >= 0)
+        unlink(path);
+    return fd;
+}
+
+/*
+ * Queue bytes. Once anything sits in the spill file, later bytes follow
+ * it there so they are read back in order.
+ */
+int js_body_write(js_body_t *b, const char *data, size_t len) {
+    b->received += len;
+
+    int to_disk = b->wpos > b->rpos
+                  || (b->spill && js_body_queued(b) + len > b->spill);
+    if (!to_disk)
+        return js_buf_append(&b->mem, data, len);
+
+    if (b->fd < 0 && (b->fd = js_body_open_spill()) < 0)
+        return -1;
+    while (len > 0) {
+        ssize_t n = pwrite(b->fd, data, len, b->wpos);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        b->wpos += n;
+        data += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/* returns bytes copied to out, 0 if nothing is queued, -1 on error */
+ssize_t js_body_read(js_body_t *b, char *out, size_t cap) {
+    ssize_t n = 0;
+    size_t queued = js_body_queued(b);
+
+    if (queued > 0) {
+        n = queued < cap ? queued : cap;
+        memcpy(out, b->mem.data + b->off, n);
+        b->off += n;
+        if (b->off == b->mem.len)
+            b->off = b->mem.len = 0;
+
+    } else if (b->wpos > b->rpos) {
+        size_t left = b->wpos - b->rpos;
+        do
+            n = pread(b->fd, out, left < cap ? left : cap, b->rpos);
+        while (n < 0 && errno == EINTR);
+        if (n <= 0)
+            return -1;
+        b->rpos += n;
+
+        /* drained: reuse the file from the start, give the blocks back */
+        if (b->rpos == b->wpos) {
+            b->rpos = b->wpos = 0;
+            if (ftruncate(b->fd, 0) < 0)
+                return -1;
+        }
+    }
+
+    if (b->paused && js_body_queued(b) < JS_BODY_HIGH_WATER / 2
+        && b->on_drain)
+        b->on_drain(b);
+    return n;
+}
+
+/* bytes held in memory; what the writer throttles on */
+size_t js_body_queued(js_body_t *b) {
+    return b->mem.len - b->off;
+}
+
+void js_body_free(js_body_t *b) {
+    if (!b)
+        return;
+    js_buf_free(&b->mem);
+    if (b->fd >= 0)
+        close(b->fd);
+    free(b);
+}
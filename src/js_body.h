@@ -0,0 +1,47 @@
+#ifndef JS_BODY_H
+#define JS_BODY_H
+
+/*
+ * Streamed request body: bytes decoded off the connection are queued here
+ * until JS reads them. The queue lives in memory up to a spill threshold;
+ * past it, bytes go to an unlinked temporary file, so a slow reader costs
+ * disk instead of heap. Without a threshold the HTTP layer stops reading
+ * the socket instead once JS_BODY_HIGH_WATER bytes are queued.
+ */
+
+#define JS_BODY_HIGH_WATER  (256 * 1024)
+#define JS_BODY_CHUNK       (64 * 1024)     /* most bytes per JS read */
+
+struct js_exec_s;
+
+/* ---- struct ---- */
+
+typedef struct js_body_s js_body_t;
+
+typedef void (*js_body_drain_t)(js_body_t *body);
+
+struct js_body_s {
+    js_buf_t           mem;         /* queued bytes start at mem.data + off */
+    size_t             off;
+    int                fd;          /* spill file, -1 = not opened yet */
+    off_t              rpos;        /* spill file read/write offsets */
+    off_t              wpos;
+    size_t             spill;       /* bytes kept in memory, 0 = no spill */
+    size_t             received;
+    int                done;        /* last byte received */
+    int                error;       /* body rejected or connection lost */
+    int                paused;      /* writer stopped until the queue drains */
+    js_body_drain_t    on_drain;    /* called by a read that unpauses */
+    void              *data;        /* for on_drain */
+    struct js_exec_s  *exec;        /* reader to wake on new bytes */
+};
+
+/* ---- api ---- */
+
+js_body_t *js_body_create(size_t spill);
+int        js_body_write(js_body_t *b, const char *data, size_t len);
+ssize_t    js_body_read(js_body_t *b, char *out, size_t cap);
+size_t     js_body_queued(js_body_t *b);
+void       js_body_free(js_body_t *b);
+
+#endif /* JS_BODY_H */
@@ -6,7 +6,8 @@ void js_buf_init(js_buf_t *buf) {
     buf->cap = 0;
 }
 
-int js_buf_append(js_buf_t *buf, const char *data, size_t len) {
+/* room for len more bytes after data + len, e.g. for a read() into it */
+int js_buf_reserve(js_buf_t *buf, size_t len) {
     if (buf->len + len > buf->cap) {
         size_t newcap = buf->cap ? buf->cap * 2 : 1024;
         while (newcap < buf->len + len)
@@ -17,6 +18,12 @@ int js_buf_append(js_buf_t *buf, const char *data, size_t len) {
         buf->data = p;
         buf->cap = newcap;
     }
+    return 0;
+}
+
+int js_buf_append(js_buf_t *buf, const char *data, size_t len) {
+    if (js_buf_reserve(buf, len) < 0)
+        return -1;
     memcpy(buf->data + buf->len, data, len);
     buf->len += len;
     return 0;
@@ -37,3 +44,26 @@ void js_buf_free(js_buf_t *buf) {
     buf->len = 0;
     buf->cap = 0;
 }
+
+/* ---- refcounted ---- */
+
+js_rcbuf_t *js_rcbuf_create(const char *data, size_t len) {
+    js_rcbuf_t *rb = malloc(sizeof(*rb) + len + 1);
+    if (!rb)
+        return NULL;
+    rb->refs = 1;
+    rb->len = len;
+    memcpy(rb->data, data, len);
+    rb->data[len] = '\0';
+    return rb;
+}
+
+js_rcbuf_t *js_rcbuf_ref(js_rcbuf_t *rb) {
+    __atomic_add_fetch(&rb->refs, 1, __ATOMIC_RELAXED);
+    return rb;
+}
+
+void js_rcbuf_release(js_rcbuf_t *rb) {
+    if (rb && __atomic_sub_fetch(&rb->refs, 1, __ATOMIC_ACQ_REL) == 0)
+        free(rb);
+}
@@ -9,11 +9,27 @@ typedef struct {
     size_t cap;
 } js_buf_t;
 
+/*
+ * Immutable bytes shared by reference, between threads too: a response
+ * body goes from the JS Response to the socket without being copied.
+ * Freed with the last reference.
+ */
+typedef struct {
+    int     refs;
+    size_t  len;
+    char    data[];
+} js_rcbuf_t;
+
 /* ---- api ---- */
 
 void js_buf_init(js_buf_t *buf);
+int  js_buf_reserve(js_buf_t *buf, size_t len);
 int  js_buf_append(js_buf_t *buf, const char *data, size_t len);
 void js_buf_consume(js_buf_t *buf, size_t n);
 void js_buf_free(js_buf_t *buf);
 
+js_rcbuf_t *js_rcbuf_create(const char *data, size_t len);
+js_rcbuf_t *js_rcbuf_ref(js_rcbuf_t *rb);
+void        js_rcbuf_release(js_rcbuf_t *rb);
+
 #endif
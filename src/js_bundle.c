@@ -0,0 +1,420 @@
+#include "js_main.h"
+
+#define JS_BUNDLE_MAGIC    "JSMOCKBC"
+#define JS_BUNDLE_VERSION  1
+#define JS_BUNDLE_EXE_MAGIC "JSMOCKEX"
+
+/*
+ * Layout, host byte order (a cache, not an interchange format):
+ *
+ *   magic[8]  version:u32  module_count:u32
+ *   entry record, then module_count module records:
+ *       name_len:u32  name  mtime_ns:i64  size:u64  bc_len:u64  bytecode
+ *   checksum:u64              FNV-1a of everything before it
+ *
+ * QuickJS rejects bytecode from a different engine version on read.
+ *
+ * A standalone executable is the jsmock binary followed by a bundle and a
+ * 16-byte trailer: bundle_len:u64  magic[8] "JSMOCKEX".
+ */
+
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+} js_bundle_reader_t;
+
+static uint64_t js_bundle_hash(const uint8_t *p, size_t len) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static int js_bundle_stat(const char *name, int64_t *mtime, uint64_t *size) {
+    struct stat st;
+    if (stat(name, &st) < 0)
+        return -1;
+    *mtime = (int64_t) st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+    *size = st.st_size;
+    return 0;
+}
+
+static int js_bundle_put_record(js_buf_t *out, const char *name,
+                                const uint8_t *bc, size_t bc_len) {
+    uint32_t name_len = strlen(name);
+    int64_t mtime = 0;
+    uint64_t size = 0, len = bc_len;
+
+    /* a vanished source simply never invalidates */
+    js_bundle_stat(name, &mtime, &size);
+
+    if (js_buf_append(out, (char *) &name_len, sizeof(name_len)) < 0
+        || js_buf_append(out, name, name_len) < 0
+        || js_buf_append(out, (char *) &mtime, sizeof(mtime)) < 0
+        || js_buf_append(out, (char *) &size, sizeof(size)) < 0
+        || js_buf_append(out, (char *) &len, sizeof(len)) < 0
+        || js_buf_append(out, (const char *) bc, bc_len) < 0)
+        return -1;
+    return 0;
+}
+
+int js_bundle_serialize(js_runtime_t *rt, js_buf_t *out) {
+    uint32_t version = JS_BUNDLE_VERSION;
+    uint32_t count = 0;
+    for (js_module_t *mod = rt->modules; mod; mod = mod->next)
+        count++;
+
+    if (js_buf_append(out, JS_BUNDLE_MAGIC, 8) < 0
+        || js_buf_append(out, (char *) &version, sizeof(version)) < 0
+        || js_buf_append(out, (char *) &count, sizeof(count)) < 0
+        || js_bundle_put_record(out, rt->script_path, rt->bytecode,
+                                rt->bytecode_len) < 0)
+        return -1;
+
+    for (js_module_t *mod = rt->modules; mod; mod = mod->next) {
+        if (js_bundle_put_record(out, mod->name, mod->bytecode,
+                                 mod->bytecode_len) < 0)
+            return -1;
+    }
+
+    uint64_t sum = js_bundle_hash((uint8_t *) out->data, out->len);
+    return js_buf_append(out, (char *) &sum, sizeof(sum));
+}
+
+static const void *js_bundle_take(js_bundle_reader_t *r, size_t n) {
+    if ((size_t) (r->end - r->p) < n)
+        return NULL;
+    const void *p = r->p;
+    r->p += n;
+    return p;
+}
+
+/*
+ * One record; *stale is set when its source exists and has changed.
+ * With JS_BUNDLE_BORROW, *bc points into the bundle instead of a copy.
+ */
+static int js_bundle_get_record(js_bundle_reader_t *r, char **name,
+                                uint8_t **bc, size_t *bc_len,
+                                int flags, int *stale) {
+    uint32_t name_len;
+    int64_t mtime;
+    uint64_t size, len;
+    const void *p;
+
+    if (!(p = js_bundle_take(r, sizeof(name_len))))
+        return -1;
+    memcpy(&name_len, p, sizeof(name_len));
+    const char *s = js_bundle_take(r, name_len);
+    if (!s || !(p = js_bundle_take(r, 24)))
+        return -1;
+    memcpy(&mtime, p, 8);
+    memcpy(&size, (const char *) p + 8, 8);
+    memcpy(&len, (const char *) p + 16, 8);
+    const uint8_t *code = js_bundle_take(r, len);
+    if (!code)
+        return -1;
+
+    *name = strndup(s, name_len);
+    if (!*name)
+        return -1;
+    if (flags & JS_BUNDLE_BORROW) {
+        *bc = (uint8_t *) code;
+    } else {
+        *bc = malloc(len ? len : 1);
+        if (!*bc) {
+            free(*name);
+            return -1;
+        }
+        memcpy(*bc, code, len);
+    }
+    *bc_len = len;
+
+    if (flags & JS_BUNDLE_CHECK_SOURCES) {
+        int64_t cur_mtime;
+        uint64_t cur_size;
+        if (js_bundle_stat(*name, &cur_mtime, &cur_size) == 0
+            && (cur_mtime != mtime || cur_size != size))
+            *stale = 1;
+    }
+    return 0;
+}
+
+static void js_bundle_free_modules(js_module_t *mod, int flags) {
+    while (mod) {
+        js_module_t *next = mod->next;
+        free(mod->name);
+        if (!(flags & JS_BUNDLE_BORROW))
+            free(mod->bytecode);
+        free(mod);
+        mod = next;
+    }
+}
+
+int js_bundle_detect(const char *path) {
+    char magic[8];
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return 0;
+    ssize_t n = read(fd, magic, sizeof(magic));
+    close(fd);
+    return n == sizeof(magic) && memcmp(magic, JS_BUNDLE_MAGIC, 8) == 0;
+}
+
+int js_bundle_parse(js_runtime_t *rt, const uint8_t *data, size_t len,
+                    int flags) {
+    js_bundle_reader_t r = { data, data + len };
+    uint32_t version, count;
+    uint64_t sum;
+    int stale = 0;
+
+    if (len < 8 + 8 + 8 || memcmp(data, JS_BUNDLE_MAGIC, 8) != 0)
+        return -1;
+    memcpy(&sum, data + len - 8, 8);
+    if (sum != js_bundle_hash(data, len - 8))
+        return -1;
+    r.end -= 8;
+    r.p += 8;
+
+    memcpy(&version, js_bundle_take(&r, 4), 4);
+    memcpy(&count, js_bundle_take(&r, 4), 4);
+    if (version != JS_BUNDLE_VERSION)
+        return -1;
+
+    char *entry;
+    uint8_t *bc;
+    size_t bc_len;
+    if (js_bundle_get_record(&r, &entry, &bc, &bc_len, flags, &stale) < 0)
+        return -1;
+
+    js_module_t *modules = NULL;
+    for (uint32_t i = 0; i < count; i++) {
+        js_module_t *mod = calloc(1, sizeof(*mod));
+        if (!mod || js_bundle_get_record(&r, &mod->name, &mod->bytecode,
+                                         &mod->bytecode_len, flags,
+                                         &stale) < 0) {
+            free(mod);
+            goto fail;
+        }
+        mod->next = modules;
+        modules = mod;
+    }
+
+    free(rt->script_path);
+    rt->script_path = entry;
+
+    if (stale) {
+        /* caller recompiles from rt->script_path */
+        if (!(flags & JS_BUNDLE_BORROW))
+            free(bc);
+        js_bundle_free_modules(modules, flags);
+        return 1;
+    }
+
+    rt->bytecode = bc;
+    rt->bytecode_len = bc_len;
+    rt->modules = modules;
+    return 0;
+
+fail:
+    free(entry);
+    if (!(flags & JS_BUNDLE_BORROW))
+        free(bc);
+    js_bundle_free_modules(modules, flags);
+    return -1;
+}
+
+int js_bundle_write(js_runtime_t *rt, const char *path) {
+    js_buf_t out;
+    js_buf_init(&out);
+    if (js_bundle_serialize(rt, &out) < 0) {
+        js_buf_free(&out);
+        return -1;
+    }
+
+    /* write beside the target and rename, so readers never see half a file */
+    size_t plen = strlen(path);
+    char *tmp = malloc(plen + 5);
+    if (!tmp) {
+        js_buf_free(&out);
+        return -1;
+    }
+    memcpy(tmp, path, plen);
+    memcpy(tmp + plen, ".tmp", 5);
+
+    int ret = -1;
+    FILE *f = fopen(tmp, "wb");
+    if (f) {
+        size_t n = fwrite(out.data, 1, out.len, f);
+        if (fclose(f) == 0 && n == out.len && rename(tmp, path) == 0)
+            ret = 0;
+        else
+            unlink(tmp);
+    }
+
+    free(tmp);
+    js_buf_free(&out);
+    return ret;
+}
+
+int js_bundle_load(js_runtime_t *rt, const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    uint8_t *data = malloc(st.st_size ? st.st_size : 1);
+    if (!data) {
+        close(fd);
+        return -1;
+    }
+
+    size_t off = 0;
+    while (off < (size_t) st.st_size) {
+        ssize_t n = read(fd, data + off, st.st_size - off);
+        if (n <= 0)
+            break;
+        off += n;
+    }
+    close(fd);
+
+    int ret = -1;
+    if (off == (size_t) st.st_size)
+        ret = js_bundle_parse(rt, data, off, JS_BUNDLE_CHECK_SOURCES);
+    free(data);
+    return ret;
+}
+
+/* size of the jsmock binary itself, without any embedded bundle */
+static off_t js_bundle_exe_base(int fd, off_t size, uint64_t *bundle_len) {
+    char trailer[16];
+    uint64_t len;
+
+    *bundle_len = 0;
+    if (size < 16 || pread(fd, trailer, 16, size - 16) != 16
+        || memcmp(trailer + 8, JS_BUNDLE_EXE_MAGIC, 8) != 0)
+        return size;
+
+    memcpy(&len, trailer, 8);
+    if (len > (uint64_t) size - 16)
+        return -1;
+    *bundle_len = len;
+    return size - 16 - len;
+}
+
+int js_bundle_embed(js_runtime_t *rt, const char *path) {
+    js_buf_t out;
+    js_buf_init(&out);
+    if (js_bundle_serialize(rt, &out) < 0) {
+        js_buf_free(&out);
+        return -1;
+    }
+
+    uint64_t len = out.len;
+    if (js_buf_append(&out, (char *) &len, sizeof(len)) < 0
+        || js_buf_append(&out, JS_BUNDLE_EXE_MAGIC, 8) < 0) {
+        js_buf_free(&out);
+        return -1;
+    }
+
+    int ret = -1, in = -1, fd = -1;
+    char *tmp = malloc(strlen(path) + 5);
+    if (!tmp)
+        goto done;
+    strcpy(tmp, path);
+    strcat(tmp, ".tmp");
+
+    in = open("/proc/self/exe", O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (in < 0 || fstat(in, &st) < 0)
+        goto done;
+
+    /* building from a built binary replaces its bundle */
+    uint64_t old_len;
+    off_t base = js_bundle_exe_base(in, st.st_size, &old_len);
+    if (base < 0)
+        goto done;
+
+    fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0755);
+    if (fd < 0)
+        goto done;
+
+    char buf[65536];
+    off_t off = 0;
+    while (off < base) {
+        size_t want = base - off < (off_t) sizeof(buf) ? (size_t) (base - off)
+                                                        : sizeof(buf);
+        ssize_t n = pread(in, buf, want, off);
+        if (n <= 0 || write(fd, buf, n) != n)
+            goto done;
+        off += n;
+    }
+
+    size_t done_len = 0;
+    while (done_len < out.len) {
+        ssize_t n = write(fd, out.data + done_len, out.len - done_len);
+        if (n <= 0)
+            goto done;
+        done_len += n;
+    }
+
+    if (close(fd) == 0 && rename(tmp, path) == 0)
+        ret = 0;
+    fd = -1;
+
+done:
+    if (fd >= 0)
+        close(fd);
+    if (ret < 0 && tmp)
+        unlink(tmp);
+    if (in >= 0)
+        close(in);
+    free(tmp);
+    js_buf_free(&out);
+    return ret;
+}
+
+int js_bundle_load_embedded(js_runtime_t *rt) {
+    int fd = open("/proc/self/exe", O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return 1;
+
+    struct stat st;
+    uint64_t len;
+    off_t base;
+    if (fstat(fd, &st) < 0
+        || (base = js_bundle_exe_base(fd, st.st_size, &len)) < 0) {
+        close(fd);
+        return -1;
+    }
+    if (len == 0) {
+        close(fd);
+        return 1;
+    }
+
+    /*
+     * Map only the pages holding the bundle. The bytecode is read from
+     * the mapping as is, so it stays mapped until js_runtime_free().
+     */
+    off_t page = sysconf(_SC_PAGESIZE);
+    off_t start = base & ~(page - 1);
+    size_t map_len = (base - start) + len;
+    uint8_t *map = mmap(NULL, map_len, PROT_READ, MAP_PRIVATE, fd, start);
+    close(fd);
+    if (map == MAP_FAILED)
+        return -1;
+
+    if (js_bundle_parse(rt, map + (base - start), len, JS_BUNDLE_BORROW) < 0) {
+        munmap(map, map_len);
+        return -1;
+    }
+    rt->bundle_map = map;
+    rt->bundle_map_len = map_len;
+    return 0;
+}
@@ -0,0 +1,34 @@
+#ifndef JS_BUNDLE_H
+#define JS_BUNDLE_H
+
+/*
+ * Precompiled script bundle (.jsbc): entry bytecode plus every imported
+ * module, each tagged with the mtime and size of the source it came from.
+ * Written by `jsmock compile`, loaded at startup instead of compiling.
+ * `jsmock build` appends one to a copy of the jsmock executable.
+ */
+
+/* forward declarations */
+struct js_runtime_s;
+
+/* js_bundle_parse() flags */
+#define JS_BUNDLE_CHECK_SOURCES  1  /* stale if a source file changed */
+#define JS_BUNDLE_BORROW         2  /* bytecode points into data, no copy */
+
+/* ---- api ---- */
+
+int js_bundle_detect(const char *path);
+int js_bundle_serialize(struct js_runtime_s *rt, js_buf_t *out);
+int js_bundle_parse(struct js_runtime_s *rt, const uint8_t *data, size_t len,
+                    int flags);
+/* returns: 0=loaded, 1=stale (a source file changed), -1=invalid */
+
+int js_bundle_write(struct js_runtime_s *rt, const char *path);
+int js_bundle_load(struct js_runtime_s *rt, const char *path);
+/* returns: same as js_bundle_parse(), with sources checked */
+
+int js_bundle_embed(struct js_runtime_s *rt, const char *path);
+int js_bundle_load_embedded(struct js_runtime_s *rt);
+/* returns: 0=loaded, 1=no bundle in this executable, -1=invalid */
+
+#endif
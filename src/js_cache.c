@@ -0,0 +1,215 @@
+#include "js_main.h"
+
+static unsigned int js_cache_hash(const char *key) {
+    unsigned int h = 5381;
+    while (*key)
+        h = h * 33 + (unsigned char)*key++;
+    return h;
+}
+
+static js_nsec_t js_cache_now(void) {
+    js_monotonic_time_t now;
+    js_monotonic_time(&now);
+    return now.monotonic;
+}
+
+static void js_cache_entry_free(js_cache_entry_t *e) {
+    free(e->key);
+    js_http_static_free(e->resp);
+    free(e);
+}
+
+static void js_cache_lru_unlink(js_cache_t *cache, js_cache_entry_t *e) {
+    if (e->lru_prev)
+        e->lru_prev->lru_next = e->lru_next;
+    else
+        cache->lru_head = e->lru_next;
+    if (e->lru_next)
+        e->lru_next->lru_prev = e->lru_prev;
+    else
+        cache->lru_tail = e->lru_prev;
+    e->lru_prev = e->lru_next = NULL;
+}
+
+static void js_cache_lru_push(js_cache_t *cache, js_cache_entry_t *e) {
+    e->lru_prev = NULL;
+    e->lru_next = cache->lru_head;
+    if (cache->lru_head)
+        cache->lru_head->lru_prev = e;
+    else
+        cache->lru_tail = e;
+    cache->lru_head = e;
+}
+
+/* unlink *pp from its bucket and the LRU list, and free it */
+static void js_cache_remove(js_cache_t *cache, js_cache_entry_t **pp) {
+    js_cache_entry_t *e = *pp;
+    *pp = e->next;
+    js_cache_lru_unlink(cache, e);
+    js_cache_entry_free(e);
+    cache->count--;
+}
+
+/* drop the least recently used entry */
+static void js_cache_evict(js_cache_t *cache) {
+    js_cache_entry_t *e = cache->lru_tail;
+    if (!e)
+        return;
+    unsigned int idx = js_cache_hash(e->key) % cache->bucket_count;
+    js_cache_entry_t **pp = &cache->buckets[idx];
+    while (*pp != e)
+        pp = &(*pp)->next;
+    js_cache_remove(cache, pp);
+}
+
+/* bucket_count: about JS_CACHE_MAX_ENTRIES keeps chains short when full */
+int js_cache_init(js_cache_t *cache, int bucket_count) {
+    memset(cache, 0, sizeof(*cache));
+    cache->bucket_count = bucket_count;
+    cache->buckets = calloc(bucket_count, sizeof(js_cache_entry_t *));
+    if (!cache->buckets)
+        return -1;
+    pthread_mutex_init(&cache->lock, NULL);
+    return 0;
+}
+
+/* first matching startup route decides, mirroring handler dispatch */
+static int js_cache_route_ttl(js_runtime_t *rt, js_http_request_t *req) {
+    js_route_t *route = js_route_lookup(rt->routes, req->method, req->path);
+    return route ? route->cache_ttl : 0;
+}
+
+int js_cache_lookup(js_runtime_t *rt, js_http_request_t *req,
+                    int keep_alive, js_buf_t *out, js_cache_slot_t *slot) {
+    js_cache_t *cache = &rt->cache;
+
+    memset(slot, 0, sizeof(*slot));
+    if (rt->cached_routes == 0)
+        return 0;
+
+    slot->ttl = js_cache_route_ttl(rt, req);
+    if (slot->ttl <= 0)
+        return 0;
+
+    size_t plen = strlen(req->path);
+    size_t qlen = req->query ? strlen(req->query) + 1 : 0;
+    slot->key = malloc(16 + plen + qlen);
+    if (!slot->key)
+        return 0;
+    int n = sprintf(slot->key, "%d %s", (int) req->method, req->path);
+    if (req->query)
+        sprintf(slot->key + n, "?%s", req->query);
+
+    /* read before the handler runs: a write during it makes the entry stale */
+    slot->generation = js_store_generation(&rt->store);
+
+    int hit = 0;
+    pthread_mutex_lock(&cache->lock);
+    unsigned int idx = js_cache_hash(slot->key) % cache->bucket_count;
+    js_cache_entry_t **pp = &cache->buckets[idx];
+    while (*pp) {
+        js_cache_entry_t *e = *pp;
+        if (strcmp(e->key, slot->key) == 0) {
+            if (e->generation == slot->generation
+                && e->expires > js_cache_now()) {
+                hit = js_http_static_write(e->resp, keep_alive, out) == 0;
+                js_cache_lru_unlink(cache, e);
+                js_cache_lru_push(cache, e);
+            } else {
+                js_cache_remove(cache, pp);
+            }
+            break;
+        }
+        pp = &e->next;
+    }
+    if (hit)
+        cache->hits++;
+    else
+        cache->misses++;
+    pthread_mutex_unlock(&cache->lock);
+
+    return hit;
+}
+
+void js_cache_store(js_runtime_t *rt, js_cache_slot_t *slot,
+                    js_http_response_t *resp) {
+    js_cache_t *cache = &rt->cache;
+
+    /* server errors, streamed bodies and stale responses are not memoized */
+    uint64_t generation = js_store_generation(&rt->store);
+    if (!slot->key || resp->status >= 500 || resp->stream
+        || slot->generation != generation)
+        goto done;
+
+    js_cache_entry_t *e = calloc(1, sizeof(*e));
+    if (!e)
+        goto done;
+    e->resp = js_http_static_create(resp);
+    if (!e->resp) {
+        free(e);
+        goto done;
+    }
+    e->key = slot->key;
+    slot->key = NULL;
+    e->expires = js_cache_now() + (js_nsec_t) slot->ttl * 1000000;
+    e->generation = slot->generation;
+
+    js_nsec_t now = js_cache_now();
+
+    pthread_mutex_lock(&cache->lock);
+    unsigned int idx = js_cache_hash(e->key) % cache->bucket_count;
+
+    /*
+     * Drop the bucket's dead entries on the way: expired, stale, or the
+     * one for this key (another thread filled it first; keep the newer).
+     */
+    js_cache_entry_t **pp = &cache->buckets[idx];
+    while (*pp) {
+        js_cache_entry_t *old = *pp;
+        if (old->expires <= now || old->generation != generation
+            || strcmp(old->key, e->key) == 0)
+            js_cache_remove(cache, pp);
+        else
+            pp = &old->next;
+    }
+
+    if (cache->count >= JS_CACHE_MAX_ENTRIES)
+        js_cache_evict(cache);
+    e->next = cache->buckets[idx];
+    cache->buckets[idx] = e;
+    js_cache_lru_push(cache, e);
+    cache->count++;
+    pthread_mutex_unlock(&cache->lock);
+
+done:
+    js_cache_slot_free(slot);
+}
+
+void js_cache_slot_free(js_cache_slot_t *slot) {
+    free(slot->key);
+    slot->key = NULL;
+}
+
+void js_cache_stats(js_cache_t *cache, uint64_t *hits, uint64_t *misses,
+                    int *entries) {
+    pthread_mutex_lock(&cache->lock);
+    *hits = cache->hits;
+    *misses = cache->misses;
+    *entries = cache->count;
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void js_cache_free(js_cache_t *cache) {
+    for (int i = 0; i < cache->bucket_count; i++) {
+        js_cache_entry_t *e = cache->buckets[i];
+        while (e) {
+            js_cache_entry_t *next = e->next;
+            js_cache_entry_free(e);
+            e = next;
+        }
+    }
+    free(cache->buckets);
+    cache->buckets = NULL;
+    cache->lru_head = cache->lru_tail = NULL;
+    pthread_mutex_destroy(&cache->lock);
+}
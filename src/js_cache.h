@@ -0,0 +1,59 @@
+#ifndef JS_CACHE_H
+#define JS_CACHE_H
+
+/*
+ * Process-wide memoization of serialized responses, keyed by method, path
+ * and query. Entries expire after their route's TTL and whenever mock.store
+ * is written to (tracked through the store generation). A full cache makes
+ * room by dropping the least recently used entry.
+ */
+
+/* forward declarations */
+struct js_runtime_s;
+
+#define JS_CACHE_MAX_ENTRIES  10000
+
+/* ---- struct ---- */
+
+typedef struct js_cache_entry_s {
+    char                     *key;          /* "<method> <path>?<query>" */
+    js_http_static_t         *resp;
+    js_nsec_t                 expires;      /* monotonic */
+    uint64_t                  generation;   /* store generation when filled */
+    struct js_cache_entry_s  *next;         /* bucket chain */
+    struct js_cache_entry_s  *lru_prev;     /* toward more recently used */
+    struct js_cache_entry_s  *lru_next;
+} js_cache_entry_t;
+
+typedef struct {
+    js_cache_entry_t **buckets;
+    int                bucket_count;
+    int                count;
+    js_cache_entry_t  *lru_head;   /* most recently used */
+    js_cache_entry_t  *lru_tail;   /* evicted first */
+    uint64_t           hits;
+    uint64_t           misses;
+    pthread_mutex_t    lock;
+} js_cache_t;
+
+/* one request's view of the cache, from lookup to store */
+typedef struct {
+    char      *key;         /* NULL = route is not memoized */
+    int        ttl;         /* ms */
+    uint64_t   generation;
+} js_cache_slot_t;
+
+/* ---- api ---- */
+
+int  js_cache_init(js_cache_t *cache, int bucket_count);
+int  js_cache_lookup(struct js_runtime_s *rt, js_http_request_t *req,
+                     int keep_alive, js_buf_t *out, js_cache_slot_t *slot);
+/* returns: 1=hit (response appended to out), 0=miss */
+void js_cache_store(struct js_runtime_s *rt, js_cache_slot_t *slot,
+                    js_http_response_t *resp);
+void js_cache_slot_free(js_cache_slot_t *slot);
+void js_cache_stats(js_cache_t *cache, uint64_t *hits, uint64_t *misses,
+                    int *entries);
+void js_cache_free(js_cache_t *cache);
+
+#endif
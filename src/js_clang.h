@@ -4,4 +4,6 @@
 #define js_container_of(p, type, field) \
     ((type *) ((char *) (p) - offsetof(type, field)))
 
+#define js_countof(a)  ((int) (sizeof(a) / sizeof((a)[0])))
+
 #endif /* JS_CLANG_H */
@@ -2,38 +2,56 @@
 
 /* ---- listen ---- */
 
-static void js_listen_accept(js_event_t *ev) {
+/* a new connection, from accept4() below or an io_uring accept */
+static void js_listen_conn(js_event_t *ev, int fd) {
     js_listen_t *ls = js_event_data(ev, js_listen_t, event);
-    struct sockaddr_in addr;
-    socklen_t addrlen = sizeof(addr);
-    int fd = accept4(ev->fd, (struct sockaddr *)&addr, &addrlen,
-                     SOCK_NONBLOCK | SOCK_CLOEXEC);
-    if (fd < 0)
-        return;
 
-    js_conn_t *conn = js_conn_create(fd);
+    js_conn_t *conn = js_conn_create(fd, ls->conn_size);
     if (!conn) {
         close(fd);
         return;
     }
+    if (ls->edge)
+        conn->event.flags = EPOLLET | EPOLLRDHUP;
 
     ls->on_conn_init(conn);
 }
 
-int js_listen_start(js_listen_t *ls, int lfd, js_epoll_t *ep,
-                    js_conn_init_t on_conn_init)
+/*
+ * Accept what is queued, up to JS_LISTEN_ACCEPT_MAX: a burst of clients
+ * costs one wakeup per batch, not per connection. The listener stays
+ * level-triggered, so what is left is reported in the next round.
+ */
+static void js_listen_accept(js_event_t *ev) {
+    for (int i = 0; i < JS_LISTEN_ACCEPT_MAX; i++) {
+        struct sockaddr_in addr;
+        socklen_t addrlen = sizeof(addr);
+        int fd = accept4(ev->fd, (struct sockaddr *)&addr, &addrlen,
+                         SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return;
+
+        js_listen_conn(ev, fd);
+    }
+}
+
+int js_listen_start(js_listen_t *ls, int lfd, js_engine_t *eng,
+                    js_conn_init_t on_conn_init, size_t conn_size, int edge)
 {
     ls->event.fd = lfd;
     ls->event.read = js_listen_accept;
     ls->event.write = NULL;
     ls->on_conn_init = on_conn_init;
-    return js_epoll_add(ep, lfd, EPOLLIN | EPOLLEXCLUSIVE, &ls->event);
+    ls->conn_size = conn_size;
+    ls->edge = edge;
+    return js_engine_accept(eng, lfd, &ls->event, js_listen_conn);
 }
 
 /* ---- conn ---- */
 
-js_conn_t *js_conn_create(int fd) {
-    js_conn_t *conn = calloc(1, sizeof(*conn));
+/* size >= sizeof(js_conn_t): room for the upper layer's per-conn state */
+js_conn_t *js_conn_create(int fd, size_t size) {
+    js_conn_t *conn = calloc(1, size);
     if (!conn)
         return NULL;
     conn->event.fd = fd;
@@ -45,32 +63,153 @@ js_conn_t *js_conn_create(int fd) {
     return conn;
 }
 
+/*
+ * Read into rbuf. Edge-triggered, until EAGAIN: no event comes for what
+ * is left. Past JS_CONN_READ_MAX bytes, or on EOF or an error after
+ * data, the read stops early and sets readable; the caller re-arms the
+ * fd and the rest is read in the next round.
+ */
 int js_conn_read(js_conn_t *conn) {
-    char tmp[4096];
-    ssize_t n = read(conn->event.fd, tmp, sizeof(tmp));
-    if (n <= 0)
-        return (int)n; /* 0 = EOF, -1 = error */
+    size_t total = 0;
+
+    conn->readable = 0;
+    for (;;) {
+        if (js_buf_reserve(&conn->rbuf, JS_CONN_READ_SIZE) < 0)
+            return -1;
+        js_buf_t *b = &conn->rbuf;
+        ssize_t n = read(conn->event.fd, b->data + b->len, b->cap - b->len);
+        if (n <= 0) {
+            if (total == 0)
+                return (int)n; /* 0 = EOF, -1 = error */
+            if (n == 0 || errno != EAGAIN)
+                conn->readable = 1;
+            break;
+        }
+        b->len += n;
+        total += n;
+        if (!(conn->event.flags & EPOLLET))
+            break;
+        if (total >= JS_CONN_READ_MAX) {
+            conn->readable = 1;
+            break;
+        }
+    }
     conn->last_active = time(NULL);
-    if (js_buf_append(&conn->rbuf, tmp, n) < 0)
-        return -1;
-    return (int)n; /* positive = bytes read */
+    return (int)total; /* positive = bytes read */
+}
+
+/* queue the part of [p, p+len) not yet sent; *skip counts sent bytes */
+static int js_conn_iov_add(struct iovec *iov, int n, size_t *skip,
+                           char *p, size_t len) {
+    if (*skip >= len) {
+        *skip -= len;
+        return n;
+    }
+    iov[n].iov_base = p + *skip;
+    iov[n].iov_len = len - *skip;
+    *skip = 0;
+    return n + 1;
+}
+
+/* the unsent part of wbuf and the refs between its pieces, in order */
+static int js_conn_iov_fill(js_conn_t *conn, struct iovec *iov,
+                            size_t *want) {
+    size_t skip = conn->woff, pos = 0;
+    int n = 0;
+
+    for (int i = 0; i <= conn->ref_count && n < JS_CONN_IOV_MAX; i++) {
+        size_t end = i < conn->ref_count ? conn->refs[i].at : conn->wbuf.len;
+        n = js_conn_iov_add(iov, n, &skip, conn->wbuf.data + pos, end - pos);
+        pos = end;
+        if (i < conn->ref_count && n < JS_CONN_IOV_MAX)
+            n = js_conn_iov_add(iov, n, &skip, conn->refs[i].data,
+                                conn->refs[i].len);
+    }
+    *want = 0;
+    for (int i = 0; i < n; i++)
+        *want += iov[i].iov_len;
+    return n;
 }
 
+/*
+ * wbuf and the refs between its pieces go out in a single writev(), or
+ * more if they take more than JS_CONN_IOV_MAX iovecs. Writes go on until
+ * the socket takes less than offered: only then is an EPOLLOUT edge sure
+ * to follow.
+ */
 int js_conn_write(js_conn_t *conn) {
-    size_t remaining = conn->wbuf.len - conn->woff;
-    if (remaining == 0)
-        return 0;
-    ssize_t n = write(conn->event.fd, conn->wbuf.data + conn->woff, remaining);
-    if (n < 0)
-        return -1;
-    conn->woff += n;
-    conn->last_active = time(NULL);
-    /* return 1 if fully written, 0 if more to go */
-    return (conn->woff >= conn->wbuf.len) ? 1 : 0;
+    struct iovec iov[JS_CONN_IOV_MAX];
+    size_t want;
+
+    for (;;) {
+        int n = js_conn_iov_fill(conn, iov, &want);
+        if (n == 0)
+            return 1;
+        ssize_t w = writev(conn->event.fd, iov, n);
+        if (w < 0)
+            return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+        conn->woff += w;
+        conn->last_active = time(NULL);
+        if ((size_t) w < want)
+            return 0;   /* more to go once there is room */
+    }
+}
+
+static void js_conn_ref_free(char *data, js_rcbuf_t *shared) {
+    if (shared)
+        js_rcbuf_release(shared);
+    else
+        free(data);
+}
+
+/*
+ * Append len bytes the conn takes ownership of: data itself, or the
+ * caller's reference to shared, which data points into. Large buffers
+ * are sent from where they are; small ones cost less to copy than an
+ * iovec.
+ */
+int js_conn_write_ref(js_conn_t *conn, char *data, size_t len,
+                      js_rcbuf_t *shared) {
+    if (len < JS_CONN_COPY_MAX) {
+        int rc = js_buf_append(&conn->wbuf, data, len);
+        js_conn_ref_free(data, shared);
+        return rc;
+    }
+    if (conn->ref_count == conn->ref_cap) {
+        int cap = conn->ref_cap ? conn->ref_cap * 2 : 4;
+        js_conn_ref_t *refs = realloc(conn->refs, cap * sizeof(*refs));
+        if (!refs) {
+            js_conn_ref_free(data, shared);
+            return -1;
+        }
+        conn->refs = refs;
+        conn->ref_cap = cap;
+    }
+    conn->refs[conn->ref_count++] = (js_conn_ref_t) {
+        .at = conn->wbuf.len, .data = data, .len = len, .shared = shared
+    };
+    return 0;
+}
+
+/* bytes queued and not written yet */
+size_t js_conn_write_pending(js_conn_t *conn) {
+    size_t total = conn->wbuf.len;
+    for (int i = 0; i < conn->ref_count; i++)
+        total += conn->refs[i].len;
+    return total - conn->woff;
+}
+
+/* everything was written: start over with an empty output */
+void js_conn_write_reset(js_conn_t *conn) {
+    for (int i = 0; i < conn->ref_count; i++)
+        js_conn_ref_free(conn->refs[i].data, conn->refs[i].shared);
+    conn->ref_count = 0;
+    conn->wbuf.len = 0;
+    conn->woff = 0;
 }
 
-void js_conn_close(js_conn_t *conn, js_epoll_t *ep) {
-    js_epoll_del(ep, conn->event.fd);
+void js_conn_close(js_conn_t *conn, js_engine_t *eng) {
+    js_engine_del(eng, conn->event.fd);
     close(conn->event.fd);
     conn->state = JS_CONN_CLOSING;
 }
@@ -78,6 +217,8 @@ void js_conn_close(js_conn_t *conn, js_epoll_t *ep) {
 void js_conn_free(js_conn_t *conn) {
     if (!conn)
         return;
+    js_conn_write_reset(conn);
+    free(conn->refs);
     js_buf_free(&conn->rbuf);
     js_buf_free(&conn->wbuf);
     free(conn);
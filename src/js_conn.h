@@ -6,18 +6,40 @@
 typedef enum {
     JS_CONN_READING,
     JS_CONN_WRITING,
-    JS_CONN_PENDING,    /* waiting for async JS handler (setTimeout) */
+    JS_CONN_PENDING,    /* waiting for JS handlers, not reading meanwhile */
     JS_CONN_CLOSING
 } js_conn_state_t;
 
+#define JS_CONN_COPY_MAX      4096          /* smaller bodies are copied into wbuf */
+#define JS_CONN_IOV_MAX       64            /* iovecs per writev() */
+#define JS_CONN_READ_SIZE     4096          /* rbuf room per read() */
+#define JS_CONN_READ_MAX      (256 * 1024)  /* bytes per event, edge-triggered */
+#define JS_LISTEN_ACCEPT_MAX  32            /* connections accepted per wakeup */
+
+/*
+ * A buffer sent in place of being copied into wbuf: it goes out after
+ * the first `at` bytes of wbuf. Owned by the conn and freed once written,
+ * or, if shared, the conn's reference is released then.
+ */
+typedef struct {
+    size_t       at;
+    char        *data;
+    size_t       len;
+    js_rcbuf_t  *shared;    /* data lies in it, NULL = data is malloc'd */
+} js_conn_ref_t;
+
 typedef struct {
     js_event_t       event;
     js_conn_state_t  state;
     js_buf_t         rbuf;
     js_buf_t         wbuf;
-    size_t           woff;          /* write offset (bytes already sent) */
+    js_conn_ref_t   *refs;          /* interleaved with wbuf, in order */
+    int              ref_count;
+    int              ref_cap;
+    size_t           woff;          /* bytes of wbuf and refs already sent */
     time_t           last_active;
     int              keep_alive;    /* HTTP keep-alive flag */
+    int              readable;      /* last read stopped before EAGAIN */
 } js_conn_t;
 
 /* ---- listen api ---- */
@@ -27,17 +49,23 @@ typedef void (*js_conn_init_t)(js_conn_t *conn);
 typedef struct {
     js_event_t      event;
     js_conn_init_t  on_conn_init;   /* upper layer sets conn handlers */
+    size_t          conn_size;      /* upper layer struct, js_conn_t first */
+    int             edge;           /* conns are edge-triggered */
 } js_listen_t;
 
-int js_listen_start(js_listen_t *ls, int lfd, js_epoll_t *ep,
-                    js_conn_init_t on_conn_init);
+int js_listen_start(js_listen_t *ls, int lfd, js_engine_t *eng,
+                    js_conn_init_t on_conn_init, size_t conn_size, int edge);
 
 /* ---- conn api ---- */
 
-js_conn_t *js_conn_create(int fd);
+js_conn_t *js_conn_create(int fd, size_t size);
 int        js_conn_read(js_conn_t *conn);
 int        js_conn_write(js_conn_t *conn);
-void       js_conn_close(js_conn_t *conn, js_epoll_t *ep);
+int        js_conn_write_ref(js_conn_t *conn, char *data, size_t len,
+                             js_rcbuf_t *shared);
+size_t     js_conn_write_pending(js_conn_t *conn);
+void       js_conn_write_reset(js_conn_t *conn);
+void       js_conn_close(js_conn_t *conn, js_engine_t *eng);
 void       js_conn_free(js_conn_t *conn);
 
 #endif
@@ -9,26 +9,176 @@ static js_msec_t js_engine_time(void)
     return (js_msec_t) (ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
 }
 
-int js_engine_init(js_engine_t *eng, int max_events) {
-    if (js_epoll_init(&eng->epoll, max_events) < 0)
-        return -1;
+/* ---- epoll ---- */
+
+static int js_engine_epoll_add(js_engine_t *eng, int fd, uint32_t events,
+    js_event_t *ev)
+{
+    return js_epoll_add(&eng->epoll, fd, events, ev);
+}
+
+static int js_engine_epoll_mod(js_engine_t *eng, int fd, uint32_t events,
+    js_event_t *ev)
+{
+    return js_epoll_mod(&eng->epoll, fd, events, ev);
+}
+
+static int js_engine_epoll_rearm(js_engine_t *eng, int fd, uint32_t events,
+    js_event_t *ev)
+{
+    return js_epoll_rearm(&eng->epoll, fd, events, ev);
+}
+
+static int js_engine_epoll_del(js_engine_t *eng, int fd)
+{
+    return js_epoll_del(&eng->epoll, fd);
+}
+
+/* threads share the listener: EPOLLEXCLUSIVE wakes only one of them */
+static int js_engine_epoll_accept(js_engine_t *eng, int fd, js_event_t *ev,
+    js_accept_handler_t handler)
+{
+    (void) handler;
+    return js_epoll_add(&eng->epoll, fd, EPOLLIN | EPOLLEXCLUSIVE, ev);
+}
+
+static int js_engine_epoll_poll(js_engine_t *eng, int timeout_ms)
+{
+    return js_epoll_poll(&eng->epoll, timeout_ms);
+}
+
+static void js_engine_epoll_free(js_engine_t *eng)
+{
+    js_epoll_free(&eng->epoll);
+}
+
+static const js_engine_ops_t js_engine_epoll = {
+    "epoll",
+    js_engine_epoll_add,
+    js_engine_epoll_mod,
+    js_engine_epoll_rearm,
+    js_engine_epoll_del,
+    js_engine_epoll_accept,
+    js_engine_epoll_poll,
+    js_engine_epoll_free,
+};
+
+/* ---- io_uring ---- */
+
+static int js_engine_uring_add(js_engine_t *eng, int fd, uint32_t events,
+    js_event_t *ev)
+{
+    return js_uring_add(&eng->uring, fd, events, ev);
+}
+
+/* a ready fd is reported by its next poll anyway: rearm is mod */
+static int js_engine_uring_mod(js_engine_t *eng, int fd, uint32_t events,
+    js_event_t *ev)
+{
+    return js_uring_mod(&eng->uring, fd, events, ev);
+}
+
+static int js_engine_uring_del(js_engine_t *eng, int fd)
+{
+    return js_uring_del(&eng->uring, fd);
+}
+
+static int js_engine_uring_accept(js_engine_t *eng, int fd, js_event_t *ev,
+    js_accept_handler_t handler)
+{
+    return js_uring_accept(&eng->uring, fd, ev, handler);
+}
+
+static int js_engine_uring_poll(js_engine_t *eng, int timeout_ms)
+{
+    return js_uring_poll(&eng->uring, timeout_ms);
+}
+
+static void js_engine_uring_free(js_engine_t *eng)
+{
+    js_uring_free(&eng->uring);
+}
+
+static const js_engine_ops_t js_engine_uring = {
+    "io_uring",
+    js_engine_uring_add,
+    js_engine_uring_mod,
+    js_engine_uring_mod,
+    js_engine_uring_del,
+    js_engine_uring_accept,
+    js_engine_uring_poll,
+    js_engine_uring_free,
+};
+
+/* ---- engine ---- */
+
+/* io_uring if asked for and the kernel lets us, epoll otherwise */
+int js_engine_init(js_engine_t *eng, int max_events, int uring) {
+    memset(eng, 0, sizeof(*eng));
+    eng->epoll.fd = -1;
+    eng->uring.fd = -1;
+
+    if (uring && js_uring_init(&eng->uring, max_events) == 0) {
+        eng->ops = &js_engine_uring;
+    } else {
+        if (uring)
+            fprintf(stderr, "warning: io_uring unavailable (%s), "
+                    "using epoll\n", strerror(errno));
+        if (js_epoll_init(&eng->epoll, max_events) < 0)
+            return -1;
+        eng->ops = &js_engine_epoll;
+    }
     js_timers_init(&eng->timers);
+    eng->posted = NULL;
+    eng->posted_tail = &eng->posted;
     return 0;
 }
 
+/*
+ * Call ev->read once the events of the current round are dispatched.
+ * For work that may free connections, e.g. job completions: a later
+ * event of the same epoll_wait() batch could still point at them.
+ */
+void js_engine_post(js_engine_t *eng, js_event_t *ev) {
+    if (ev->posted)
+        return;
+
+    ev->posted = 1;
+    ev->posted_next = NULL;
+    *eng->posted_tail = ev;
+    eng->posted_tail = &ev->posted_next;
+}
+
+static void js_engine_run_posted(js_engine_t *eng) {
+    js_event_t *ev;
+
+    while ((ev = eng->posted) != NULL) {
+        eng->posted = ev->posted_next;
+        if (eng->posted == NULL)
+            eng->posted_tail = &eng->posted;
+
+        ev->posted = 0;
+        ev->read(ev);
+    }
+}
+
 void js_engine_run(js_engine_t *eng) {
     js_msec_t timeout;
 
     for (;;) {
         timeout = js_timer_find(&eng->timers);
+        if (eng->posted)
+            timeout = 0;
 
-        if (js_epoll_poll(&eng->epoll, (int) timeout) < 0)
+        if (eng->ops->poll(eng, (int) timeout) < 0)
             break;
 
+        js_engine_run_posted(eng);
+
         js_timer_expire(&eng->timers, js_engine_time());
     }
 }
 
 void js_engine_free(js_engine_t *eng) {
-    js_epoll_free(&eng->epoll);
+    eng->ops->free(eng);
 }
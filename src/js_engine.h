@@ -3,15 +3,73 @@
 
 /* ---- struct ---- */
 
+typedef struct js_engine_s js_engine_t;
+
+/*
+ * An event backend: how fds are watched and the loop waits for them.
+ * Either way callbacks see js_event_t read/write, level-triggered unless
+ * the event's flags ask for EPOLLET.
+ */
 typedef struct {
-    js_epoll_t   epoll;
-    js_timers_t  timers;
-} js_engine_t;
+    const char  *name;
+    int        (*add)(js_engine_t *eng, int fd, uint32_t events,
+                      js_event_t *ev);
+    int        (*mod)(js_engine_t *eng, int fd, uint32_t events,
+                      js_event_t *ev);
+    int        (*rearm)(js_engine_t *eng, int fd, uint32_t events,
+                        js_event_t *ev);
+    int        (*del)(js_engine_t *eng, int fd);
+    int        (*accept)(js_engine_t *eng, int fd, js_event_t *ev,
+                         js_accept_handler_t handler);
+    int        (*poll)(js_engine_t *eng, int timeout_ms);
+    void       (*free)(js_engine_t *eng);
+} js_engine_ops_t;
+
+struct js_engine_s {
+    const js_engine_ops_t *ops;
+    js_epoll_t             epoll;
+    js_uring_t             uring;
+    js_timers_t            timers;
+    js_event_t            *posted;       /* run after the current round */
+    js_event_t           **posted_tail;
+};
 
 /* ---- api ---- */
 
-int  js_engine_init(js_engine_t *eng, int max_events);
+int  js_engine_init(js_engine_t *eng, int max_events, int uring);
 void js_engine_run(js_engine_t *eng);   /* main event loop */
 void js_engine_free(js_engine_t *eng);
+void js_engine_post(js_engine_t *eng, js_event_t *ev);
+
+static inline int js_engine_add(js_engine_t *eng, int fd, uint32_t events,
+                                js_event_t *ev)
+{
+    return eng->ops->add(eng, fd, events, ev);
+}
+
+static inline int js_engine_mod(js_engine_t *eng, int fd, uint32_t events,
+                                js_event_t *ev)
+{
+    return eng->ops->mod(eng, fd, events, ev);
+}
+
+/* js_engine_mod(), and have the fd reported again if it is ready now */
+static inline int js_engine_rearm(js_engine_t *eng, int fd, uint32_t events,
+                                  js_event_t *ev)
+{
+    return eng->ops->rearm(eng, fd, events, ev);
+}
+
+static inline int js_engine_del(js_engine_t *eng, int fd)
+{
+    return eng->ops->del(eng, fd);
+}
+
+/* watch listener fd: connections go to handler, or ev->read accepts */
+static inline int js_engine_accept(js_engine_t *eng, int fd, js_event_t *ev,
+                                   js_accept_handler_t handler)
+{
+    return eng->ops->accept(eng, fd, ev, handler);
+}
 
 #endif
@@ -13,14 +13,36 @@ int js_epoll_init(js_epoll_t *ep, int max_events) {
     return 0;
 }
 
-int js_epoll_add(js_epoll_t *ep, int fd, uint32_t events, void *ptr) {
-    struct epoll_event ev = { .events = events, .data.ptr = ptr };
-    return epoll_ctl(ep->fd, EPOLL_CTL_ADD, fd, &ev);
+int js_epoll_add(js_epoll_t *ep, int fd, uint32_t events, js_event_t *ev) {
+    struct epoll_event ee = { .events = events | ev->flags, .data.ptr = ev };
+    if (epoll_ctl(ep->fd, EPOLL_CTL_ADD, fd, &ee) < 0)
+        return -1;
+    ev->mask = events;
+    return 0;
 }
 
-int js_epoll_mod(js_epoll_t *ep, int fd, uint32_t events, void *ptr) {
-    struct epoll_event ev = { .events = events, .data.ptr = ptr };
-    return epoll_ctl(ep->fd, EPOLL_CTL_MOD, fd, &ev);
+/* interest changes back and forth per request: skip the ones that do not */
+int js_epoll_mod(js_epoll_t *ep, int fd, uint32_t events, js_event_t *ev) {
+    struct epoll_event ee = { .events = events | ev->flags, .data.ptr = ev };
+    if (ev->mask == events)
+        return 0;
+    if (epoll_ctl(ep->fd, EPOLL_CTL_MOD, fd, &ee) < 0)
+        return -1;
+    ev->mask = events;
+    return 0;
+}
+
+/*
+ * js_epoll_mod(), and have the fd reported again if it is ready now.
+ * Level-triggered it is anyway; edge-triggered only new input or room
+ * makes an edge, unless the interest is registered again, which has
+ * the kernel check the fd.
+ */
+int js_epoll_rearm(js_epoll_t *ep, int fd, uint32_t events, js_event_t *ev) {
+    struct epoll_event ee = { .events = events | ev->flags, .data.ptr = ev };
+    if (ev->mask != events || !(ev->flags & EPOLLET))
+        return js_epoll_mod(ep, fd, events, ev);
+    return epoll_ctl(ep->fd, EPOLL_CTL_MOD, fd, &ee);
 }
 
 int js_epoll_del(js_epoll_t *ep, int fd) {
@@ -37,14 +59,25 @@ int js_epoll_poll(js_epoll_t *ep, int timeout_ms) {
         return (errno == EINTR) ? 0 : -1;
     }
 
+    /*
+     * One callback per event: a connection waits for either input or
+     * room, never both, so nothing is lost, and the callback may have
+     * freed it.
+     */
     for (i = 0; i < n; i++) {
         event = &ep->events[i];
         ev = event->data.ptr;
+        ev->revents = event->events;
 
         if ((event->events & EPOLLIN) && ev->read) {
             ev->read(ev);
         } else if ((event->events & EPOLLOUT) && ev->write) {
             ev->write(ev);
+        } else if ((event->events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP))
+                   && ev->read)
+        {
+            /* no interest set (paused), but the peer is gone or done */
+            ev->read(ev);
         }
     }
 
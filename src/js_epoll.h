@@ -7,10 +7,18 @@ typedef struct js_event_s js_event_t;
 
 typedef void (*js_event_handler_t)(js_event_t *ev);
 
+/* a connection the engine accepted on the listener ev */
+typedef void (*js_accept_handler_t)(js_event_t *ev, int fd);
+
 struct js_event_s {
     int                  fd;
     js_event_handler_t   read;
     js_event_handler_t   write;
+    uint32_t             mask;   /* interest registered with epoll */
+    uint32_t             flags;  /* added to every interest: EPOLLET... */
+    uint32_t             revents; /* reported with the current callback */
+    js_event_t          *posted_next; /* js_engine_post() list */
+    int                  posted;
 };
 
 #define js_event_data(ev, type, field) \
@@ -27,8 +35,9 @@ typedef struct {
 /* ---- api ---- */
 
 int  js_epoll_init(js_epoll_t *ep, int max_events);
-int  js_epoll_add(js_epoll_t *ep, int fd, uint32_t events, void *ptr);
-int  js_epoll_mod(js_epoll_t *ep, int fd, uint32_t events, void *ptr);
+int  js_epoll_add(js_epoll_t *ep, int fd, uint32_t events, js_event_t *ev);
+int  js_epoll_mod(js_epoll_t *ep, int fd, uint32_t events, js_event_t *ev);
+int  js_epoll_rearm(js_epoll_t *ep, int fd, uint32_t events, js_event_t *ev);
 int  js_epoll_del(js_epoll_t *ep, int fd);
 int  js_epoll_poll(js_epoll_t *ep, int timeout_ms);
 void js_epoll_free(js_epoll_t *ep);
@@ -2,97 +2,784 @@
 
 /* ---- conn event handlers ---- */
 
-static void js_http_process(js_engine_t *eng, js_conn_t *conn) {
+/* the request's bytes are no longer referenced: drop them from rbuf */
+static void js_http_request_done(js_conn_t *conn) {
+    js_http_conn_t *hc = js_container_of(conn, js_http_conn_t, conn);
+
+    js_buf_consume(&conn->rbuf, hc->parser.total);
+    js_http_parser_init(&hc->parser, js_thread_current->rt->body_limit);
+}
+
+/* ---- reply queue ---- */
+
+static void js_http_out_start(js_conn_t *conn, js_exec_t *exec);
+
+/* a place for the next request's answer, behind those taken before it */
+static js_http_reply_t *js_http_reply_new(js_http_conn_t *hc) {
+    js_http_reply_t *r = calloc(1, sizeof(*r));
+    if (!r)
+        return NULL;
+    r->conn = &hc->conn;
+    r->keep_alive = hc->conn.keep_alive;
+    js_buf_init(&r->raw);
+    if (hc->replies_tail)
+        hc->replies_tail->next = r;
+    else
+        hc->replies = r;
+    hc->replies_tail = r;
+    hc->reply_count++;
+    return r;
+}
+
+static void js_http_reply_unlink(js_http_conn_t *hc, js_http_reply_t *r) {
+    js_http_reply_t **pp = &hc->replies, *prev = NULL;
+
+    while (*pp != r) {
+        prev = *pp;
+        pp = &(*pp)->next;
+    }
+    *pp = r->next;
+    if (hc->replies_tail == r)
+        hc->replies_tail = prev;
+    hc->reply_count--;
+}
+
+static void js_http_reply_free(js_http_reply_t *r) {
+    if (r->resp.stream)
+        js_qjs_stream_abort(r->resp.stream);
+    js_http_response_free(&r->resp);
+    js_buf_free(&r->raw);
+    free(r);
+}
+
+/*
+ * Move the answers at the front of the queue that are in to wbuf, in
+ * request order. A streamed body holds back everything behind it until
+ * js_http_stream_end(); a broken one, for good.
+ */
+static void js_http_drain(js_http_conn_t *hc) {
+    js_conn_t *conn = &hc->conn;
+    js_http_reply_t *r;
+
+    while (!hc->out && !hc->cut && (r = hc->replies) && r->done) {
+        js_http_reply_unlink(hc, r);
+        if (r->serialized) {
+            js_buf_append(&conn->wbuf, r->raw.data, r->raw.len);
+        } else {
+            js_exec_t *out = r->resp.stream;
+            r->resp.stream = NULL;
+            js_http_write_response(conn, &r->resp, r->keep_alive);
+            if (out)
+                js_http_out_start(conn, out);
+        }
+        js_http_reply_free(r);
+    }
+}
+
+/* where an answer ready now goes: wbuf, or a reply behind pending ones */
+static js_buf_t *js_http_out(js_http_conn_t *hc) {
+    if (!hc->replies)
+        return &hc->conn.wbuf;
+    js_http_reply_t *r = js_http_reply_new(hc);
+    if (!r)
+        return NULL;
+    r->serialized = 1;
+    r->done = 1;
+    return &r->raw;
+}
+
+/*
+ * The client is gone: free the conn now, or once the last handler still
+ * running for it has replied.
+ */
+static void js_http_close(js_engine_t *eng, js_conn_t *conn) {
+    js_http_conn_t *hc = js_container_of(conn, js_http_conn_t, conn);
+    js_body_t *body = hc->body;
+
+    if (hc->out) {
+        js_qjs_stream_abort(hc->out);
+        hc->out = NULL;
+    }
+    js_conn_close(conn, eng);
+
+    for (js_http_reply_t *r = hc->replies, *next; r; r = next) {
+        next = r->next;
+        if (r->done) {
+            js_http_reply_unlink(hc, r);
+            js_http_reply_free(r);
+        }
+    }
+
+    /* a handler still reads the body: js_http_reply() frees the conn */
+    if (body && body->exec) {
+        body->error = 1;
+        js_qjs_body_wake(body->exec);
+        return;
+    }
+    hc->body = NULL;
+    js_body_free(body);
+    if (!hc->replies)
+        js_conn_free(conn);
+}
+
+/* requests may start: nothing that has to finish alone is in the way */
+static int js_http_accepting(js_http_conn_t *hc) {
+    if (hc->last || hc->cut || hc->out || hc->body
+        || hc->reply_count >= JS_HTTP_PIPELINE_MAX)
+        return 0;
+    /* a streamed request runs alone: once those before it are out */
+    return !hc->held || hc->reply_count == 0;
+}
+
+/*
+ * Something changed (a reply came in, output went out): write, read on,
+ * wait for pending replies or close, whichever applies now.
+ *
+ * Output is written right away: the socket buffer usually has room, and
+ * EPOLLOUT is only armed for what did not fit. It is also armed when a
+ * streamed body wants its next chunk or a batch left requests in rbuf,
+ * so those go on from js_http_on_write() in the next round.
+ */
+static void js_http_resume(js_engine_t *eng, js_conn_t *conn) {
+    js_http_conn_t *hc = js_container_of(conn, js_http_conn_t, conn);
     js_event_t *ev = &conn->event;
 
+    /* a streamed request body switches EPOLLIN itself */
+    if (conn->state == JS_CONN_CLOSING || hc->body)
+        return;
+
+    if (js_conn_write_pending(conn) > 0) {
+        int rc = js_conn_write(conn);
+        if (rc < 0) {
+            js_http_close(eng, conn);
+            return;
+        }
+        if (rc == 0) {
+            conn->state = JS_CONN_WRITING;
+            hc->out_idle = 0;
+            js_engine_mod(eng, ev->fd, EPOLLOUT, ev);
+            return;
+        }
+        if (hc->out) {
+            conn->state = JS_CONN_WRITING;
+            hc->out_idle = 0;
+            js_engine_rearm(eng, ev->fd, EPOLLOUT, ev);
+            return;
+        }
+    }
+    if (hc->out)
+        return;     /* idle until the next chunk, see js_http_out_wake() */
+    js_conn_write_reset(conn);
+
+    if (hc->more && js_http_accepting(hc)) {
+        conn->state = JS_CONN_WRITING;
+        js_engine_rearm(eng, ev->fd, EPOLLOUT, ev);
+        return;
+    }
+    if (hc->cut || (!hc->replies && (hc->last || hc->eof))) {
+        js_http_close(eng, conn);
+        return;
+    }
+    if (js_http_accepting(hc) && !hc->eof) {
+        conn->state = JS_CONN_READING;
+        js_engine_mod(eng, ev->fd, EPOLLIN, ev);
+    } else {
+        conn->state = JS_CONN_PENDING;
+        js_engine_mod(eng, ev->fd, 0, ev);
+    }
+}
+
+/* answer with a bare status, then close: the rest of rbuf cannot be framed */
+static void js_http_reject(js_conn_t *conn, int status) {
+    js_http_conn_t *hc = js_container_of(conn, js_http_conn_t, conn);
+    js_http_response_t resp = { .status = status };
+
+    conn->keep_alive = 0;
+    hc->last = 1;
+    js_buf_t *out = js_http_out(hc);
+    if (out)
+        js_http_serialize_response(&resp, out, 0);
+}
+
+/*
+ * Hand the request to a JS worker; the reply arrives in js_http_job_done().
+ * A buffered request is copied out of rbuf first, so the conn goes on
+ * with the next one meanwhile. A streamed one keeps its head in rbuf:
+ * the conn stops reading until the reply.
+ */
+static int js_http_submit(js_engine_t *eng, js_conn_t *conn,
+                          js_http_request_t *req, js_cache_slot_t *slot) {
+    js_http_conn_t *hc = js_container_of(conn, js_http_conn_t, conn);
+    js_job_t *job = calloc(1, sizeof(*job));
+    if (!job)
+        return -1;
+    job->conn = conn;
+    job->req = *req;
+    job->slot = *slot;
+
+    if (!req->stream) {
+        size_t total = hc->parser.total;
+        job->detached = malloc(total);
+        if (!job->detached) {
+            free(job);
+            return -1;
+        }
+        memcpy(job->detached, conn->rbuf.data, total);
+        js_http_request_rebase(&job->req, conn->rbuf.data, job->detached);
+    } else {
+        conn->state = JS_CONN_PENDING;
+        js_engine_mod(eng, conn->event.fd, 0, &conn->event);
+    }
+    js_worker_submit(js_thread_current->rt, job);
+    return 0;
+}
+
+/* ---- streamed request bodies ---- */
+
+/* js_body_t on_drain: JS caught up with the queue, read the socket again */
+static void js_http_stream_drain(js_body_t *body) {
+    js_conn_t *conn = body->data;
+
+    if (conn->state == JS_CONN_CLOSING || body->done || body->error)
+        return;
+    body->paused = 0;
+    js_engine_mod(&js_thread_current->engine, conn->event.fd, EPOLLIN,
+                 &conn->event);
+}
+
+/*
+ * Move the body bytes in rbuf to the stream. Reading stops when the body
+ * is over, or when JS is behind and there is no spill file to absorb it.
+ * Returns: 1 = body complete, 0 = more to come, -1 = body rejected.
+ */
+static int js_http_stream_feed(js_engine_t *eng, js_http_conn_t *hc) {
+    js_conn_t *conn = &hc->conn;
+    js_body_t *body = hc->body;
+
+    if (body->done || body->error)
+        return body->done ? 1 : -1;     /* rbuf holds the next request */
+
+    int rc = js_http_parse_stream(&hc->parser, &conn->rbuf, body);
+    if (rc < 0)
+        body->error = 1;
+    else if (rc == 1)
+        body->done = 1;
+
+    if (!body->paused
+        && (rc != 0
+            || (!body->spill && js_body_queued(body) >= JS_BODY_HIGH_WATER)))
+    {
+        body->paused = 1;
+        js_engine_mod(eng, conn->event.fd, 0, &conn->event);
+    }
+    return rc;
+}
+
+/* bytes arrived for a streamed body */
+static void js_http_stream_input(js_engine_t *eng, js_http_conn_t *hc) {
+    js_conn_t *conn = &hc->conn;
+    js_body_t *body = hc->body;
+    size_t received = body->received;
+
+    int rc = js_http_stream_feed(eng, hc);
+
+    /* inline: wake the handler waiting for the body */
+    if (js_thread_current->rt->worker_count == 0) {
+        if (body->exec && (body->received != received || rc != 0))
+            js_qjs_body_wake(body->exec);
+        return;
+    }
+
+    /* worker: the handler runs once the whole body is here */
+    if (rc == 0)
+        return;
+
+    hc->body = NULL;
+    if (rc < 0) {
+        js_body_free(body);
+        if (hc->parser.error) {
+            js_http_reject(conn, hc->parser.error);
+            js_http_resume(eng, conn);
+            return;
+        }
+        js_http_close(eng, conn);
+        return;
+    }
+
+    js_http_request_t req;
+    js_cache_slot_t slot = {0};
+    js_http_request_fill(&hc->parser, &conn->rbuf, &req);
+    req.stream = body;
+    req.reply = js_http_reply_new(hc);
+    body->on_drain = NULL;
+    if (!req.reply || js_http_submit(eng, conn, &req, &slot) < 0) {
+        if (req.reply) {
+            js_http_reply_unlink(hc, req.reply);
+            js_http_reply_free(req.reply);
+        }
+        js_body_free(body);
+        js_http_close(eng, conn);
+        return;
+    }
+    /* its head stays in rbuf for the worker: nothing may follow yet */
+    hc->held = 1;
+}
+
+/*
+ * The head is parsed: a route with { stream } takes its body as it
+ * arrives instead of it piling up in rbuf. Inline, the handler starts
+ * now and reads the body as it comes; a worker gets the request once the
+ * body is complete, the excess spilled to disk meanwhile.
+ * Returns: 1 = streaming, 0 = buffer the body as usual, -1 = rejected,
+ * 2 = held until the replies queued before it are out.
+ */
+static int js_http_stream_start(js_engine_t *eng, js_http_conn_t *hc) {
+    js_runtime_t *rt = js_thread_current->rt;
+    js_http_parser_t *p = &hc->parser;
+    js_conn_t *conn = &hc->conn;
+    char *base = conn->rbuf.data;
+
+    if (rt->stream_routes == 0 || (!p->chunked && p->content_length <= 0))
+        return 0;
+
+    /* first matching startup route decides, mirroring handler dispatch */
+    js_route_t *route = js_route_lookup(rt->routes, p->method, base + p->path);
+    if (!route || !route->stream)
+        return 0;
+
+    /* its replies go out while it streams, those before it first */
+    hc->held = (hc->replies != NULL);
+    if (hc->held)
+        return 2;
+
+    /* limits.body, unless the route sets its own */
+    if (route->stream_limit_set)
+        p->body_limit = route->stream_limit;
+    if (p->body_limit && p->content_length > 0
+        && (uint64_t) p->content_length > p->body_limit)
+    {
+        p->error = 413;
+        return -1;
+    }
+
+    size_t spill = route->stream_spill;
+    if (rt->worker_count > 0 && spill == 0)
+        spill = JS_BODY_HIGH_WATER;     /* nobody reads before the end */
+    js_body_t *body = js_body_create(spill);
+    if (!body)
+        return 0;
+    body->on_drain = js_http_stream_drain;
+    body->data = conn;
+    hc->body = body;
+
+    conn->keep_alive = !(p->connection >= 0
+                         && strcasecmp(base + p->fields[p->connection].value,
+                                       "close") == 0);
+    if (!conn->keep_alive)
+        hc->last = 1;
+
+    if (rt->worker_count > 0) {
+        js_http_stream_input(eng, hc);
+        return 1;
+    }
+
+    /* queue what came with the head, then run the handler */
+    js_http_stream_feed(eng, hc);
+
+    js_http_request_t req;
+    js_http_response_t resp = {0};
+    js_http_request_fill(p, &conn->rbuf, &req);
+    req.stream = body;
+    req.reply = js_http_reply_new(hc);
+    if (!req.reply) {
+        hc->body = NULL;
+        js_body_free(body);
+        return -1;
+    }
+    if (js_qjs_handle_request(rt, &req, &resp, conn, NULL) == 0)
+        js_http_reply(req.reply, &resp);
+    return 1;
+}
+
+/* ---- streamed responses ---- */
+
+/* a chunk or the end arrived while EPOLLOUT was off: write again */
+static void js_http_out_wake(js_http_conn_t *hc) {
+    js_conn_t *conn = &hc->conn;
+
+    if (!hc->out_idle)
+        return;
+    hc->out_idle = 0;
+    js_engine_mod(&js_thread_current->engine, conn->event.fd, EPOLLOUT,
+                 &conn->event);
+}
+
+/* the head is queued: the exec supplies the body from here on */
+static void js_http_out_start(js_conn_t *conn, js_exec_t *exec) {
+    js_http_conn_t *hc = js_container_of(conn, js_http_conn_t, conn);
+
+    hc->out = exec;
+    hc->out_idle = 0;
+    js_qjs_stream_pull(exec);
+}
+
+/*
+ * One chunk of a streamed body. Returns 1 if the stream may go on,
+ * 0 once JS_HTTP_OUT_HIGH_WATER bytes wait to be written, -1 on error.
+ */
+int js_http_stream_send(js_conn_t *conn, const char *data, size_t len) {
+    js_http_conn_t *hc = js_container_of(conn, js_http_conn_t, conn);
+    char line[32];
+
+    if (len == 0)
+        return 1;   /* a zero-size chunk would end the body */
+    int n = snprintf(line, sizeof(line), "%zx\r\n", len);
+    if (js_buf_append(&conn->wbuf, line, n) < 0
+        || js_buf_append(&conn->wbuf, data, len) < 0
+        || js_buf_append(&conn->wbuf, "\r\n", 2) < 0)
+        return -1;
+
+    js_http_out_wake(hc);
+    return js_conn_write_pending(conn) < JS_HTTP_OUT_HIGH_WATER;
+}
+
+/*
+ * The body is complete (ok), or broken: then the client sees it cut
+ * short. A stream still queued behind other replies can only break (the
+ * budget ran out before its first pull); its head has not gone out, so
+ * it is answered with a 500 instead.
+ */
+void js_http_stream_end(js_conn_t *conn, js_exec_t *exec, int ok) {
+    js_http_conn_t *hc = js_container_of(conn, js_http_conn_t, conn);
+
+    if (hc->out != exec) {
+        for (js_http_reply_t *r = hc->replies; r; r = r->next) {
+            if (r->resp.stream != exec)
+                continue;
+            js_http_response_free(&r->resp);
+            r->resp.status = 500;
+        }
+        return;
+    }
+
+    hc->out = NULL;
+    if (!ok || js_buf_append(&conn->wbuf, "0\r\n\r\n", 5) < 0)
+        hc->cut = 1;
+    js_http_out_wake(hc);
+    js_http_drain(hc);
+}
+
+/* ---- requests ---- */
+
+/*
+ * Handle the request at the front of rbuf. Returns 1 once it has its
+ * place in the reply queue (answered or running) or is held back, 0 if
+ * it is incomplete, -1 if the conn is taken care of elsewhere (streaming
+ * or freed).
+ */
+static int js_http_process_one(js_engine_t *eng, js_conn_t *conn) {
+    js_http_conn_t *hc = js_container_of(conn, js_http_conn_t, conn);
+
     /* try to parse a complete HTTP request */
-    js_http_request_t req = {0};
-    int parsed = js_http_parse_request(&conn->rbuf, &req);
+    js_http_request_t req;
+    int fresh = (hc->parser.state == JS_HTTP_PARSE_HEAD);
+    int parsed = js_http_parse_head(&hc->parser, &conn->rbuf);
+
+    /* a new head: its route may want the body streamed */
+    if (parsed > 0 && (fresh || hc->held)) {
+        int rc = js_http_stream_start(eng, hc);
+        if (rc == 2)
+            return 1;
+        if (rc > 0)
+            return -1;
+        if (rc < 0)
+            parsed = -1;
+    }
+    if (parsed > 0)
+        parsed = js_http_parse_request(&hc->parser, &conn->rbuf, &req);
+    if (parsed < 0 && hc->parser.error) {
+        js_http_reject(conn, hc->parser.error);
+        return 1;
+    }
     if (parsed < 0) {
-        js_conn_close(conn, &eng->epoll);
-        js_conn_free(conn);
-        return;
+        js_http_close(eng, conn);
+        return -1;
     }
     if (parsed == 0)
-        return; /* need more data */
+        return 0; /* need more data */
 
     /* determine keep-alive (HTTP/1.1 default is keep-alive) */
-    conn->keep_alive = 1;
-    for (int i = 0; i < req.header_count; i++) {
-        if (strcasecmp(req.headers[i].name, "Connection") == 0) {
-            if (strcasecmp(req.headers[i].value, "close") == 0)
-                conn->keep_alive = 0;
-            break;
+    conn->keep_alive = !(req.connection
+                         && strcasecmp(req.connection, "close") == 0);
+    if (!conn->keep_alive)
+        hc->last = 1;
+
+    js_runtime_t *rt = js_thread_current->rt;
+
+    /* behind pending replies, even an answer ready now waits its turn */
+    js_http_reply_t *reply = NULL;
+    js_buf_t *out = &conn->wbuf;
+    if (hc->replies) {
+        reply = js_http_reply_new(hc);
+        if (!reply) {
+            js_http_close(eng, conn);
+            return -1;
+        }
+        out = &reply->raw;
+    }
+
+    /* constant responses are written without entering JS */
+    js_route_match_t match;
+    if (js_route_match(rt->static_routes, req.method, req.path, &match)) {
+        js_http_static_write(match.route->static_resp, conn->keep_alive, out);
+        js_route_match_free(&match);
+        js_http_request_done(conn);
+        if (reply)
+            reply->serialized = reply->done = 1;
+        return 1;
+    }
+
+    /* memoized responses of routes with { cache: { ttl } } */
+    js_cache_slot_t slot;
+    if (js_cache_lookup(rt, &req, conn->keep_alive, out, &slot)) {
+        js_cache_slot_free(&slot);
+        js_http_request_done(conn);
+        if (reply)
+            reply->serialized = reply->done = 1;
+        return 1;
+    }
+
+    /* JS answers it: possibly later, while the requests after it go on */
+    if (!reply && !(reply = js_http_reply_new(hc))) {
+        js_cache_slot_free(&slot);
+        js_http_close(eng, conn);
+        return -1;
+    }
+    req.reply = reply;
+
+    /* hand the request to a JS worker */
+    if (rt->worker_count > 0) {
+        if (js_http_submit(eng, conn, &req, &slot) < 0) {
+            js_cache_slot_free(&slot);
+            js_http_reply_unlink(hc, reply);
+            js_http_reply_free(reply);
+            js_http_close(eng, conn);
+            return -1;
         }
+        js_http_request_done(conn);
+        return 1;
     }
 
     /* execute JS handler */
     js_http_response_t resp = {0};
-    js_runtime_t *rt = js_thread_current->rt;
-    int handle_rc = js_qjs_handle_request(rt, &req, &resp, conn);
-    js_http_request_free(&req);
+    int handle_rc = js_qjs_handle_request(rt, &req, &resp, conn, NULL);
+
+    /* JS has its own copy of everything it needs */
+    js_http_request_done(conn);
 
     if (handle_rc == 1) {
-        /* async: handler will complete later via timer callback */
-        conn->state = JS_CONN_PENDING;
-        js_epoll_del(&eng->epoll, ev->fd);
-        return;
+        /* async: js_http_reply() fills its place when it completes */
+        js_cache_slot_free(&slot);
+        return 1;
     }
 
-    /* serialize response into write buffer */
-    js_http_serialize_response(&resp, &conn->wbuf, conn->keep_alive);
-    js_http_response_free(&resp);
+    /* the cache copies the body before it moves on to the conn */
+    js_cache_store(rt, &slot, &resp);
+    reply->resp = resp;
+    reply->done = 1;
+    js_http_drain(hc);
+    return 1;
+}
+
+/*
+ * Run every complete request in rbuf, up to JS_HTTP_BATCH_MAX, and flush
+ * their responses together: one EPOLLOUT switch and one writev() for a
+ * pipelined batch instead of one per request. The batch also ends once
+ * JS_HTTP_OUT_HIGH_WATER bytes are queued; the rest of rbuf is handled
+ * after the flush, so a pipelining client cannot starve the others.
+ * Async handlers do not end it: their replies keep their place in the
+ * queue while the requests behind them run.
+ */
+static void js_http_process(js_engine_t *eng, js_conn_t *conn) {
+    js_http_conn_t *hc = js_container_of(conn, js_http_conn_t, conn);
+    int queued = 0, rc = 0;
+
+    /* everything read while a body streams belongs to it */
+    if (hc->body) {
+        js_http_stream_input(eng, hc);
+        return;
+    }
 
-    conn->state = JS_CONN_WRITING;
-    js_epoll_mod(&eng->epoll, ev->fd, EPOLLOUT, ev);
+    hc->more = 0;
+    for ( ;; ) {
+        /* held back, e.g. by a full queue: go on once it drains */
+        if (!js_http_accepting(hc)) {
+            hc->more = !hc->body && conn->rbuf.len > 0;
+            break;
+        }
+        if ((rc = js_http_process_one(eng, conn)) <= 0)
+            break;
+        if (conn->rbuf.len == 0)
+            break;
+        if (++queued == JS_HTTP_BATCH_MAX
+            || js_conn_write_pending(conn) >= JS_HTTP_OUT_HIGH_WATER)
+        {
+            hc->more = 1;
+            break;
+        }
+    }
+    if (rc >= 0)
+        js_http_resume(eng, conn);
 }
 
 static void js_http_on_read(js_event_t *ev) {
     js_engine_t *eng = &js_thread_current->engine;
     js_conn_t *conn = js_event_data(ev, js_conn_t, event);
+    js_http_conn_t *hc = js_container_of(conn, js_http_conn_t, conn);
+
+    /* not reading (paused or waiting): only a lost peer matters */
+    if (conn->state == JS_CONN_PENDING || !(ev->mask & EPOLLIN)) {
+        if (ev->revents & (EPOLLERR | EPOLLHUP))
+            js_http_close(eng, conn);
+        return;
+    }
 
     int rc = js_conn_read(conn);
+    if (rc < 0 && (errno == EAGAIN || errno == EINTR))
+        return;
     if (rc <= 0) {
-        js_conn_close(conn, &eng->epoll);
-        js_conn_free(conn);
+        /* half-closed: answer what was asked, then close */
+        if (rc == 0 && hc->replies && !hc->body && !hc->eof) {
+            hc->eof = 1;
+            js_http_resume(eng, conn);
+            return;
+        }
+        js_http_close(eng, conn);
         return;
     }
 
+    /* what the read left is reported in the next round */
+    if (conn->readable)
+        js_engine_rearm(eng, ev->fd, ev->mask, ev);
     js_http_process(eng, conn);
 }
 
 static void js_http_on_write(js_event_t *ev) {
     js_engine_t *eng = &js_thread_current->engine;
     js_conn_t *conn = js_event_data(ev, js_conn_t, event);
+    js_http_conn_t *hc = js_container_of(conn, js_http_conn_t, conn);
 
     int rc = js_conn_write(conn);
     if (rc < 0) {
-        js_conn_close(conn, &eng->epoll);
-        js_conn_free(conn);
+        js_http_close(eng, conn);
+        return;
+    }
+    if (rc == 0)
         return;
+
+    /* a streamed body: ask for more once what we have is out */
+    if (hc->out) {
+        js_conn_write_reset(conn);
+        js_qjs_stream_pull(hc->out);
+        if (js_conn_write_pending(conn) > 0) {
+            js_engine_rearm(eng, ev->fd, EPOLLOUT, ev);
+            return;
+        }
+        if (hc->out) {
+            hc->out_idle = 1;
+            js_engine_mod(eng, ev->fd, 0, ev);
+            return;
+        }
     }
-    if (rc == 1) {
-        if (conn->keep_alive) {
-            /* reuse connection for next request */
-            conn->wbuf.len = 0;
-            conn->woff = 0;
-            conn->state = JS_CONN_READING;
-            js_epoll_mod(&eng->epoll, ev->fd, EPOLLIN, ev);
-            /* process pipelined request already in read buffer */
-            if (conn->rbuf.len > 0)
-                js_http_process(eng, conn);
+
+    /* all out: go on with the requests already in rbuf, or wait */
+    js_conn_write_reset(conn);
+    if (js_http_accepting(hc) && conn->rbuf.len > 0)
+        js_http_process(eng, conn);
+    else
+        js_http_resume(eng, conn);
+}
+
+/* I/O thread: js_jobq_t handler for jobs coming back from a worker */
+void js_http_job_done(js_job_t *job) {
+    js_runtime_t *rt = js_thread_current->rt;
+    js_http_conn_t *hc = js_container_of(job->conn, js_http_conn_t, conn);
+
+    js_cache_store(rt, &job->slot, &job->resp);
+    if (job->detached) {
+        free(job->detached);
+    } else {
+        /* a streamed body: the head stayed in rbuf until now */
+        js_body_free(job->req.stream);
+        js_http_request_done(job->conn);
+        hc->held = 0;
+        /* requests pipelined behind it wait in rbuf, not on the socket */
+        hc->more = job->conn->rbuf.len > 0;
+    }
+    js_http_reply(job->req.reply, &job->resp);
+    free(job);
+}
+
+/*
+ * The response to a request, from a handler that ran inline or on a
+ * worker, sync or async. It takes its place in the queue and is written
+ * once those before it are. A streamed request body ends with it; if
+ * part of the body never arrived, the connection cannot be reused.
+ */
+void js_http_reply(js_http_reply_t *reply, js_http_response_t *resp) {
+    js_engine_t *eng = &js_thread_current->engine;
+    js_conn_t *conn = reply->conn;
+    js_http_conn_t *hc = js_container_of(conn, js_http_conn_t, conn);
+    js_body_t *body = hc->body;
+
+    if (body) {
+        if (body->done) {
+            js_http_request_done(conn);
+            hc->more = conn->rbuf.len > 0;
         } else {
-            js_conn_close(conn, &eng->epoll);
-            js_conn_free(conn);
+            reply->keep_alive = 0;
+            hc->last = 1;
         }
+        hc->body = NULL;
+        js_body_free(body);
+    }
+
+    reply->resp = *resp;
+    memset(resp, 0, sizeof(*resp));
+    reply->done = 1;
+
+    /* the client went away while the handler ran */
+    if (conn->state == JS_CONN_CLOSING) {
+        js_http_reply_unlink(hc, reply);
+        js_http_reply_free(reply);
+        if (!hc->replies)
+            js_conn_free(conn);
+        return;
     }
+
+    js_http_drain(hc);
+    js_http_resume(eng, conn);
 }
 
 void js_http_conn_init(js_conn_t *conn) {
     js_engine_t *eng = &js_thread_current->engine;
+    js_http_conn_t *hc = js_container_of(conn, js_http_conn_t, conn);
+
+    js_http_parser_init(&hc->parser, js_thread_current->rt->body_limit);
+    hc->body = NULL;
+    hc->out = NULL;
+    hc->out_idle = 0;
+    hc->replies = NULL;
+    hc->replies_tail = NULL;
+    hc->reply_count = 0;
+    hc->last = 0;
+    hc->eof = 0;
+    hc->cut = 0;
+    hc->more = 0;
+    hc->held = 0;
     conn->event.read  = js_http_on_read;
     conn->event.write = js_http_on_write;
-    js_epoll_add(&eng->epoll, conn->event.fd, EPOLLIN, &conn->event);
+    js_engine_add(eng, conn->event.fd, EPOLLIN, &conn->event);
 }
 
 /* ---- http ---- */
@@ -106,168 +793,652 @@ js_http_method_t js_http_method_from_str(const char *str, int len) {
     return JS_HTTP_ALL;
 }
 
-const char *js_http_status_text(int code) {
-    switch (code) {
-    case 200: return "OK";
-    case 201: return "Created";
-    case 204: return "No Content";
-    case 301: return "Moved Permanently";
-    case 302: return "Found";
-    case 304: return "Not Modified";
-    case 400: return "Bad Request";
-    case 401: return "Unauthorized";
-    case 403: return "Forbidden";
-    case 404: return "Not Found";
-    case 405: return "Method Not Allowed";
-    case 500: return "Internal Server Error";
-    default:  return "Unknown";
+void js_http_parser_init(js_http_parser_t *p, size_t body_limit) {
+    p->state = JS_HTTP_PARSE_HEAD;
+    p->scanned = 0;
+    p->head_len = 0;
+    p->total = 0;
+    p->body_limit = body_limit;
+    p->body_len = 0;
+    p->streamed = 0;
+    p->pos = 0;
+    p->chunk_left = 0;
+    p->chunked = 0;
+    p->error = 0;
+    p->query = 0;
+    p->content_length = -1;
+    p->field_count = 0;
+    p->host = -1;
+    p->content_type = -1;
+    p->connection = -1;
+    p->transfer_encoding = -1;
+}
+
+/*
+ * Content-Length: digits only, optional trailing whitespace. Anything
+ * else, an overflow, or a repeat with another value is a 400; a lenient
+ * parse would frame the body differently from a proxy in front of us.
+ */
+static int js_http_parse_length(js_http_parser_t *p, const char *value) {
+    const char *d = value;
+    uint64_t n = 0;
+
+    for (; *d >= '0' && *d <= '9'; d++) {
+        if (n > (uint64_t) (INT64_MAX - (*d - '0')) / 10)
+            return -1;
+        n = n * 10 + (*d - '0');
     }
+    if (d == value)
+        return -1;
+    while (*d == ' ' || *d == '\t')
+        d++;
+    if (*d != '\0')
+        return -1;
+    if (p->content_length >= 0 && (uint64_t) p->content_length != n)
+        return -1;
+    p->content_length = (int64_t) n;
+    return 0;
+}
+
+/* pre-classify the headers the server itself looks at */
+static int js_http_classify(js_http_parser_t *p, const char *name,
+                            size_t len, const char *value) {
+    int idx = p->field_count;
+
+    switch (len) {
+    case 4:
+        if (js_scan_ieq(name, "host", 4))
+            p->host = idx;
+        break;
+    case 10:
+        if (js_scan_ieq(name, "connection", 10))
+            p->connection = idx;
+        break;
+    case 12:
+        if (js_scan_ieq(name, "content-type", 12))
+            p->content_type = idx;
+        break;
+    case 14:
+        if (js_scan_ieq(name, "content-length", 14)
+            && js_http_parse_length(p, value) < 0)
+        {
+            p->error = 400;
+            return -1;
+        }
+        break;
+    case 17:
+        if (js_scan_ieq(name, "transfer-encoding", 17))
+            p->transfer_encoding = idx;
+        break;
+    }
+    return 0;
 }
 
 /*
- * Parse HTTP/1.1 request from buffer.
- * Returns: 1 = complete request parsed, 0 = need more data, -1 = error.
+ * A field name is a token (RFC 9110 tchar). Whitespace before the colon
+ * or a line without one must not pass: a name we fail to recognize, such
+ * as "Content-Length ", would frame the body differently than a proxy.
  */
-int js_http_parse_request(js_buf_t *buf, js_http_request_t *req) {
-    /* find end of headers */
-    char *end = memmem(buf->data, buf->len, "\r\n\r\n", 4);
-    if (!end)
-        return 0; /* incomplete */
+static int js_http_is_token(const char *s, size_t n) {
+    static const char punct[] = "!#$%&'*+-.^_`|~";
 
-    char *p = buf->data;
+    if (n == 0)
+        return 0;
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = s[i];
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+              || (c >= '0' && c <= '9') || (c && strchr(punct, c))))
+            return 0;
+    }
+    return 1;
+}
+
+/*
+ * Parse the request line and headers in [base, end), end pointing at the
+ * CRLFCRLF. Delimiters are overwritten with NULs so every string can be
+ * used in place.
+ */
+static const js_scan_set_t js_http_sp = js_scan_set(" ");
+static const js_scan_set_t js_http_sp_query = js_scan_set(" ?");
+static const js_scan_set_t js_http_colon_cr = js_scan_set(":\r");
+static const js_scan_set_t js_http_cr = js_scan_set("\r");
 
+static int js_http_parse_lines(js_http_parser_t *p, char *base, char *end) {
     /* request line: METHOD PATH HTTP/1.1\r\n */
-    char *sp1 = memchr(p, ' ', end - p);
+    char *sp1 = (char *) js_scan_any(base, end, &js_http_sp);
     if (!sp1) return -1;
-    req->method = js_http_method_from_str(p, sp1 - p);
-
-    char *sp2 = memchr(sp1 + 1, ' ', end - sp1 - 1);
-    if (!sp2) return -1;
+    p->method = js_http_method_from_str(base, sp1 - base);
 
     /* split path and query */
-    char *q = memchr(sp1 + 1, '?', sp2 - sp1 - 1);
-    if (q) {
-        req->path = strndup(sp1 + 1, q - sp1 - 1);
-        req->query = strndup(q + 1, sp2 - q - 1);
-    } else {
-        req->path = strndup(sp1 + 1, sp2 - sp1 - 1);
-        req->query = NULL;
+    p->path = sp1 + 1 - base;
+    char *sp2 = (char *) js_scan_any(sp1 + 1, end, &js_http_sp_query);
+    if (sp2 && *sp2 == '?') {
+        *sp2 = '\0';
+        p->query = sp2 + 1 - base;
+        sp2 = (char *) js_scan_any(sp2 + 1, end, &js_http_sp);
     }
+    if (!sp2) return -1;
+    *sp2 = '\0';
 
-    /* skip past request line */
-    char *line = memchr(sp2, '\n', end - sp2);
+    /* headers: the last one ends with the first CRLF of CRLFCRLF */
+    char *header_end = end + 2;
+    char *line = (char *) js_scan_any(sp2 + 1, header_end, &js_http_cr);
     if (!line) return -1;
-    line++;
-
-    /* parse headers — end points to first \r of \r\n\r\n, so include +2
-       to cover the last header's \r\n which starts at end itself */
-    req->headers = NULL;
-    req->header_count = 0;
-    req->content_length = -1;
+    line += 2;
 
-    char *header_end = end + 2;
     while (line < header_end) {
-        char *crlf = memmem(line, header_end - line, "\r\n", 2);
-        if (!crlf || crlf == line)
+        /* one pass finds the colon, or the line end if there is none */
+        char *colon = (char *) js_scan_any(line, header_end, &js_http_colon_cr);
+        if (!colon)
             break;
+        if (*colon == '\r' || !js_http_is_token(line, colon - line)) {
+            p->error = 400;
+            return -1;
+        }
 
-        char *colon = memchr(line, ':', crlf - line);
-        if (!colon) {
-            line = crlf + 2;
-            continue;
+        char *crlf = (char *) js_scan_any(colon + 1, header_end, &js_http_cr);
+        if (!crlf) return -1;
+        if (p->field_count == JS_HTTP_MAX_HEADERS) {
+            p->error = 431;
+            return -1;
         }
 
-        /* grow headers array */
-        req->headers = realloc(req->headers,
-                               sizeof(js_header_t) * (req->header_count + 1));
-        js_header_t *h = &req->headers[req->header_count++];
-        h->name = strndup(line, colon - line);
+        *colon = '\0';
+        char *value = colon + 1;
+        while (value < crlf && *value == ' ')
+            value++;
+        *crlf = '\0';
 
-        /* skip ": " */
-        colon++;
-        while (colon < crlf && *colon == ' ')
-            colon++;
-        h->value = strndup(colon, crlf - colon);
+        if (js_http_classify(p, line, colon - line, value) < 0)
+            return -1;
 
-        /* check Content-Length */
-        if (strcasecmp(h->name, "Content-Length") == 0)
-            req->content_length = atoi(h->value);
+        js_http_field_t *f = &p->fields[p->field_count++];
+        f->name = line - base;
+        f->value = value - base;
 
         line = crlf + 2;
     }
+    return 0;
+}
+
+/* after the head: decide how the body is framed */
+static int js_http_parse_framing(js_http_parser_t *p, char *base) {
+    if (p->transfer_encoding >= 0) {
+        /* chunked is the only transfer coding understood */
+        const char *te = base + p->fields[p->transfer_encoding].value;
+        if (strlen(te) != 7 || !js_scan_ieq(te, "chunked", 7)) {
+            p->error = 501;
+            return -1;
+        }
+        /* Transfer-Encoding overrides Content-Length (RFC 9112 6.3) */
+        p->content_length = -1;
+        p->chunked = 1;
+        p->pos = p->head_len;
+        p->state = JS_HTTP_PARSE_CHUNK_SIZE;
+        return 0;
+    }
+
+    /* checked against the limit once a streamed route may have set it */
+    p->body_len = p->content_length > 0 ? (size_t) p->content_length : 0;
+    p->pos = p->head_len;
+    p->state = JS_HTTP_PARSE_BODY;
+    return 0;
+}
+
+static const js_scan_set_t js_http_lf = js_scan_set("\n");
+
+/*
+ * Decode as much of a chunked body as has arrived, moving chunk data down
+ * to head_len + body_len. Returns 1 when the last chunk and the trailer
+ * have been read, 0 for more data, -1 on a framing error or oversize body.
+ */
+static int js_http_parse_chunks(js_http_parser_t *p, js_buf_t *buf) {
+    char *base = buf->data;
+    char *end = base + buf->len;
+
+    for ( ;; ) {
+        char *pos = base + p->pos;
+
+        switch (p->state) {
+        case JS_HTTP_PARSE_CHUNK_SIZE: {
+            char *lf = (char *) js_scan_any(pos, end, &js_http_lf);
+            if (!lf)
+                return end - pos > 1024 ? -1 : 0;
+
+            /* hex size; chunk extensions after ';' are ignored */
+            size_t size = 0;
+            char *d = pos;
+            for (; d < lf; d++) {
+                int v;
+                if (*d >= '0' && *d <= '9') v = *d - '0';
+                else if ((*d | 0x20) >= 'a' && (*d | 0x20) <= 'f')
+                    v = (*d | 0x20) - 'a' + 10;
+                else break;
+                if (size > (SIZE_MAX >> 4))
+                    return -1;
+                size = (size << 4) | v;
+            }
+            if (d == pos || (*d != ';' && *d != '\r' && *d != ' '))
+                return -1;
+
+            if (p->body_limit
+                && size > p->body_limit - p->streamed - p->body_len) {
+                p->error = 413;
+                return -1;
+            }
+            p->pos = lf + 1 - base;
+            p->chunk_left = size;
+            p->state = size ? JS_HTTP_PARSE_CHUNK_DATA
+                            : JS_HTTP_PARSE_CHUNK_TRAILER;
+            break;
+        }
+
+        case JS_HTTP_PARSE_CHUNK_DATA: {
+            size_t n = end - pos;
+            if (n == 0)
+                return 0;
+            if (n > p->chunk_left)
+                n = p->chunk_left;
+            memmove(base + p->head_len + p->body_len, pos, n);
+            p->body_len += n;
+            p->pos += n;
+            p->chunk_left -= n;
+            if (p->chunk_left == 0)
+                p->state = JS_HTTP_PARSE_CHUNK_CRLF;
+            break;
+        }
+
+        case JS_HTTP_PARSE_CHUNK_CRLF:
+            if (end - pos < 2)
+                return 0;
+            if (pos[0] != '\r' || pos[1] != '\n')
+                return -1;
+            p->pos += 2;
+            p->state = JS_HTTP_PARSE_CHUNK_SIZE;
+            break;
+
+        case JS_HTTP_PARSE_CHUNK_TRAILER: {
+            /* trailer fields are read and dropped */
+            char *lf = (char *) js_scan_any(pos, end, &js_http_lf);
+            if (!lf)
+                return end - pos > JS_HTTP_MAX_HEAD ? -1 : 0;
+            p->pos = lf + 1 - base;
+            if (lf == pos || (lf == pos + 1 && *pos == '\r'))
+                return 1;
+            break;
+        }
+
+        default:
+            return -1;
+        }
+    }
+}
+
+/*
+ * Parse the request line and headers once they have all arrived, and
+ * work out how the body is framed.
+ * Returns: 1 = head parsed, 0 = need more data, -1 = error.
+ */
+int js_http_parse_head(js_http_parser_t *p, js_buf_t *buf) {
+    if (p->state != JS_HTTP_PARSE_HEAD)
+        return 1;
+
+    /* only new bytes are searched; 3 back in case CRLFCRLF straddles */
+    size_t from = p->scanned > 3 ? p->scanned - 3 : 0;
+    char *end = (char *) js_scan_head_end(buf->data + from,
+                                          buf->data + buf->len);
+    if (!end)
+        p->scanned = buf->len;
+    if ((end ? (size_t) (end - buf->data) : buf->len) > JS_HTTP_MAX_HEAD) {
+        p->error = 431;
+        return -1;
+    }
+    if (!end)
+        return 0;
+
+    if (js_http_parse_lines(p, buf->data, end) < 0)
+        return -1;
+    p->head_len = end + 4 - buf->data;
+    if (js_http_parse_framing(p, buf->data) < 0)
+        return -1;
+    return 1;
+}
+
+/*
+ * Parse an HTTP/1.1 request at the start of buf, resuming from the state
+ * left by earlier calls. On success req borrows buf; the caller drops
+ * p->total bytes from buf once the request is handled. On error p->error
+ * is the status to answer with before closing, or 0 to just close.
+ * Returns: 1 = complete request parsed, 0 = need more data, -1 = error.
+ */
+int js_http_parse_request(js_http_parser_t *p, js_buf_t *buf,
+                          js_http_request_t *req) {
+    int rc = js_http_parse_head(p, buf);
+    if (rc <= 0)
+        return rc;
 
     /* body */
-    size_t header_size = (end + 4) - buf->data;
-    if (req->content_length > 0) {
-        size_t total = header_size + req->content_length;
-        if (buf->len < total)
-            return 0; /* need more body data */
-        req->body = strndup(end + 4, req->content_length);
-        req->body_len = req->content_length;
-        js_buf_consume(buf, total);
+    if (p->chunked) {
+        rc = js_http_parse_chunks(p, buf);
+        if (rc <= 0)
+            return rc;
+        p->total = p->pos;
     } else {
-        req->body = NULL;
-        req->body_len = 0;
-        js_buf_consume(buf, header_size);
+        if (p->body_limit && p->body_len > p->body_limit) {
+            p->error = 413;
+            return -1;
+        }
+        if (buf->len < p->head_len + p->body_len)
+            return 0; /* need more body data */
+        p->total = p->head_len + p->body_len;
     }
 
+    js_http_request_fill(p, buf, req);
     return 1;
 }
 
-int js_http_serialize_response(js_http_response_t *resp, js_buf_t *out,
-                               int keep_alive) {
-    char line[256];
+/*
+ * Streaming body: move the body bytes that have arrived into body and cut
+ * them out of buf, leaving the head in place for the request. When the
+ * body is complete, p->total covers the head alone.
+ * Returns: 1 = body complete, 0 = need more data, -1 = error.
+ */
+int js_http_parse_stream(js_http_parser_t *p, js_buf_t *buf,
+                         js_body_t *body) {
+    int rc;
+
+    if (p->chunked) {
+        rc = js_http_parse_chunks(p, buf);
+        if (rc < 0)
+            return -1;
+    } else {
+        size_t want = (size_t) p->content_length - p->streamed;
+        size_t have = buf->len - p->head_len;
+        if (p->body_limit && (uint64_t) p->content_length > p->body_limit) {
+            p->error = 413;
+            return -1;
+        }
+        p->body_len = have < want ? have : want;
+        p->pos = p->head_len + p->body_len;
+        rc = (p->body_len == want);
+    }
+
+    /* decoded bytes sit right after the head, the dead framing up to pos */
+    char *base = buf->data;
+    if (p->body_len && js_body_write(body, base + p->head_len, p->body_len) < 0)
+        return -1;
+    p->streamed += p->body_len;
+    memmove(base + p->head_len, base + p->pos, buf->len - p->pos);
+    buf->len -= p->pos - p->head_len;
+    p->pos = p->head_len;
+    p->body_len = 0;
+
+    if (rc == 1)
+        p->total = p->head_len;
+    return rc;
+}
+
+/* the request as parsed so far; strings point into buf */
+void js_http_request_fill(js_http_parser_t *p, js_buf_t *buf,
+                          js_http_request_t *req) {
+    char *base = buf->data;
+    req->method = p->method;
+    req->path = base + p->path;
+    req->query = p->query ? base + p->query : NULL;
+    req->header_count = p->field_count;
+    for (int i = 0; i < p->field_count; i++) {
+        req->headers[i].name = base + p->fields[i].name;
+        req->headers[i].value = base + p->fields[i].value;
+    }
+    req->host = p->host >= 0 ? req->headers[p->host].value : NULL;
+    req->content_type = p->content_type >= 0
+                        ? req->headers[p->content_type].value : NULL;
+    req->connection = p->connection >= 0
+                      ? req->headers[p->connection].value : NULL;
+    req->content_length = p->content_length;
+    req->body = p->body_len ? base + p->head_len : NULL;
+    req->body_len = p->body_len;
+    req->stream = NULL;
+    req->reply = NULL;
+}
+
+static char *js_http_rebase(const char *p, const char *from, char *to) {
+    return p ? to + (p - from) : NULL;
+}
+
+/* the request's bytes were copied from `from` to `to`: follow them */
+void js_http_request_rebase(js_http_request_t *req, const char *from,
+                            char *to) {
+    req->path = js_http_rebase(req->path, from, to);
+    req->query = js_http_rebase(req->query, from, to);
+    for (int i = 0; i < req->header_count; i++) {
+        req->headers[i].name = js_http_rebase(req->headers[i].name, from, to);
+        req->headers[i].value = js_http_rebase(req->headers[i].value,
+                                               from, to);
+    }
+    req->host = js_http_rebase(req->host, from, to);
+    req->content_type = js_http_rebase(req->content_type, from, to);
+    req->connection = js_http_rebase(req->connection, from, to);
+    req->body = js_http_rebase(req->body, from, to);
+}
+
+/* ---- serialize ---- */
+
+/*
+ * Status lines are preformatted, indexed by code - 100. Codes missing
+ * here are still sent, with "Unknown" as the reason phrase.
+ */
+typedef struct {
+    const char *line;   /* "HTTP/1.1 <code> <text>\r\n" */
+    size_t      len;
+    const char *text;
+} js_http_status_t;
+
+#define JS_HTTP_STATUS(code, t)                                            \
+    [code - 100] = { "HTTP/1.1 " #code " " t "\r\n",                       \
+                     sizeof("HTTP/1.1 " #code " " t "\r\n") - 1, t }
+
+static const js_http_status_t js_http_statuses[500] = {
+    JS_HTTP_STATUS(100, "Continue"),
+    JS_HTTP_STATUS(101, "Switching Protocols"),
+    JS_HTTP_STATUS(200, "OK"),
+    JS_HTTP_STATUS(201, "Created"),
+    JS_HTTP_STATUS(202, "Accepted"),
+    JS_HTTP_STATUS(203, "Non-Authoritative Information"),
+    JS_HTTP_STATUS(204, "No Content"),
+    JS_HTTP_STATUS(205, "Reset Content"),
+    JS_HTTP_STATUS(206, "Partial Content"),
+    JS_HTTP_STATUS(300, "Multiple Choices"),
+    JS_HTTP_STATUS(301, "Moved Permanently"),
+    JS_HTTP_STATUS(302, "Found"),
+    JS_HTTP_STATUS(303, "See Other"),
+    JS_HTTP_STATUS(304, "Not Modified"),
+    JS_HTTP_STATUS(307, "Temporary Redirect"),
+    JS_HTTP_STATUS(308, "Permanent Redirect"),
+    JS_HTTP_STATUS(400, "Bad Request"),
+    JS_HTTP_STATUS(401, "Unauthorized"),
+    JS_HTTP_STATUS(402, "Payment Required"),
+    JS_HTTP_STATUS(403, "Forbidden"),
+    JS_HTTP_STATUS(404, "Not Found"),
+    JS_HTTP_STATUS(405, "Method Not Allowed"),
+    JS_HTTP_STATUS(406, "Not Acceptable"),
+    JS_HTTP_STATUS(407, "Proxy Authentication Required"),
+    JS_HTTP_STATUS(408, "Request Timeout"),
+    JS_HTTP_STATUS(409, "Conflict"),
+    JS_HTTP_STATUS(410, "Gone"),
+    JS_HTTP_STATUS(411, "Length Required"),
+    JS_HTTP_STATUS(412, "Precondition Failed"),
+    JS_HTTP_STATUS(413, "Content Too Large"),
+    JS_HTTP_STATUS(414, "URI Too Long"),
+    JS_HTTP_STATUS(415, "Unsupported Media Type"),
+    JS_HTTP_STATUS(416, "Range Not Satisfiable"),
+    JS_HTTP_STATUS(417, "Expectation Failed"),
+    JS_HTTP_STATUS(418, "I'm a teapot"),
+    JS_HTTP_STATUS(421, "Misdirected Request"),
+    JS_HTTP_STATUS(422, "Unprocessable Content"),
+    JS_HTTP_STATUS(423, "Locked"),
+    JS_HTTP_STATUS(424, "Failed Dependency"),
+    JS_HTTP_STATUS(425, "Too Early"),
+    JS_HTTP_STATUS(426, "Upgrade Required"),
+    JS_HTTP_STATUS(428, "Precondition Required"),
+    JS_HTTP_STATUS(429, "Too Many Requests"),
+    JS_HTTP_STATUS(431, "Request Header Fields Too Large"),
+    JS_HTTP_STATUS(451, "Unavailable For Legal Reasons"),
+    JS_HTTP_STATUS(500, "Internal Server Error"),
+    JS_HTTP_STATUS(501, "Not Implemented"),
+    JS_HTTP_STATUS(502, "Bad Gateway"),
+    JS_HTTP_STATUS(503, "Service Unavailable"),
+    JS_HTTP_STATUS(504, "Gateway Timeout"),
+    JS_HTTP_STATUS(505, "HTTP Version Not Supported"),
+    JS_HTTP_STATUS(506, "Variant Also Negotiates"),
+    JS_HTTP_STATUS(507, "Insufficient Storage"),
+    JS_HTTP_STATUS(508, "Loop Detected"),
+    JS_HTTP_STATUS(510, "Not Extended"),
+    JS_HTTP_STATUS(511, "Network Authentication Required"),
+};
+
+static const js_http_status_t *js_http_status(int code) {
+    if (code < 100 || code > 599 || !js_http_statuses[code - 100].line)
+        return NULL;
+    return &js_http_statuses[code - 100];
+}
+
+const char *js_http_status_text(int code) {
+    const js_http_status_t *st = js_http_status(code);
+    return st ? st->text : "Unknown";
+}
+
+/* "Date: ...\r\n" of this thread, formatted again once the second changes */
+static __thread time_t js_http_date_sec;
+static __thread size_t js_http_date_len;
+static __thread char   js_http_date[48];
+
+static int js_http_append_date(js_buf_t *out) {
+    time_t now = time(NULL);
+
+    if (now != js_http_date_sec || js_http_date_len == 0) {
+        struct tm tm;
+        gmtime_r(&now, &tm);
+        js_http_date_len = strftime(js_http_date, sizeof(js_http_date),
+                                    "Date: %a, %d %b %Y %H:%M:%S GMT\r\n",
+                                    &tm);
+        js_http_date_sec = now;
+    }
+    return js_buf_append(out, js_http_date, js_http_date_len);
+}
+
+/* status line, Date if date is set, headers and the blank line */
+static int js_http_serialize_head(js_http_response_t *resp, js_buf_t *out,
+                                  int keep_alive, int date) {
+    const js_http_status_t *st = js_http_status(resp->status);
+    char line[64];
     int n;
 
     /* status line */
-    n = snprintf(line, sizeof(line), "HTTP/1.1 %d %s\r\n",
-                 resp->status, js_http_status_text(resp->status));
-    if (js_buf_append(out, line, n) < 0)
+    if (st) {
+        if (js_buf_append(out, st->line, st->len) < 0)
+            return -1;
+    } else {
+        n = snprintf(line, sizeof(line), "HTTP/1.1 %d Unknown\r\n",
+                     resp->status);
+        if (js_buf_append(out, line, n) < 0)
+            return -1;
+    }
+    if (date && js_http_append_date(out) < 0)
         return -1;
 
-    /* headers */
+    /* headers, appended piecewise: no length limit */
     for (int i = 0; i < resp->header_count; i++) {
-        n = snprintf(line, sizeof(line), "%s: %s\r\n",
-                     resp->headers[i].name, resp->headers[i].value);
+        js_header_t *h = &resp->headers[i];
+        if (js_buf_append(out, h->name, strlen(h->name)) < 0
+            || js_buf_append(out, ": ", 2) < 0
+            || js_buf_append(out, h->value, strlen(h->value)) < 0
+            || js_buf_append(out, "\r\n", 2) < 0)
+            return -1;
+    }
+
+    /* Content-Length (always required for keep-alive), unless streamed */
+    if (resp->stream) {
+        static const char te[] = "Transfer-Encoding: chunked\r\n";
+        if (js_buf_append(out, te, sizeof(te) - 1) < 0)
+            return -1;
+    } else {
+        n = snprintf(line, sizeof(line), "Content-Length: %zu\r\n",
+                     resp->body ? resp->body_len : (size_t)0);
         if (js_buf_append(out, line, n) < 0)
             return -1;
     }
 
-    /* Content-Length (always required for keep-alive) */
-    n = snprintf(line, sizeof(line), "Content-Length: %zu\r\n",
-                 resp->body ? resp->body_len : (size_t)0);
-    if (js_buf_append(out, line, n) < 0)
-        return -1;
+    /* Connection header and end of headers */
+    static const char ka[] = "Connection: keep-alive\r\n\r\n";
+    static const char cl[] = "Connection: close\r\n\r\n";
+    return keep_alive ? js_buf_append(out, ka, sizeof(ka) - 1)
+                      : js_buf_append(out, cl, sizeof(cl) - 1);
+}
 
-    /* Connection header */
-    n = snprintf(line, sizeof(line), "Connection: %s\r\n",
-                 keep_alive ? "keep-alive" : "close");
-    if (js_buf_append(out, line, n) < 0)
+int js_http_serialize_response(js_http_response_t *resp, js_buf_t *out,
+                               int keep_alive) {
+    if (js_http_serialize_head(resp, out, keep_alive, 1) < 0)
         return -1;
+    if (resp->body && resp->body_len > 0)
+        return js_buf_append(out, resp->body, resp->body_len);
+    return 0;
+}
 
-    /* end of headers */
-    if (js_buf_append(out, "\r\n", 2) < 0)
+/*
+ * Queue a response on the conn. The body is not copied: it moves to the
+ * conn, with its reference if shared, and is written from its own
+ * buffer, so resp no longer has it.
+ */
+int js_http_write_response(js_conn_t *conn, js_http_response_t *resp,
+                           int keep_alive) {
+    if (js_http_serialize_head(resp, &conn->wbuf, keep_alive, 1) < 0)
         return -1;
+    if (!resp->body || resp->body_len == 0)
+        return 0;
 
-    /* body */
-    if (resp->body && resp->body_len > 0) {
-        if (js_buf_append(out, resp->body, resp->body_len) < 0)
-            return -1;
+    char *body = resp->body;
+    js_rcbuf_t *shared = resp->body_ref;
+    resp->body = NULL;
+    resp->body_ref = NULL;
+    return js_conn_write_ref(conn, body, resp->body_len, shared);
+}
+
+/* serialized without Date, which js_http_static_write() puts in */
+js_http_static_t *js_http_static_create(js_http_response_t *resp) {
+    js_http_static_t *st = calloc(1, sizeof(*st));
+    if (!st)
+        return NULL;
+
+    if (js_http_serialize_head(resp, &st->keep_alive, 1, 0) < 0
+        || js_http_serialize_head(resp, &st->close, 0, 0) < 0
+        || (resp->body
+            && (js_buf_append(&st->keep_alive, resp->body, resp->body_len) < 0
+                || js_buf_append(&st->close, resp->body, resp->body_len) < 0))) {
+        js_http_static_free(st);
+        return NULL;
     }
+    /* Date goes right after the status line */
+    st->date_at = (char *) memchr(st->keep_alive.data, '\n',
+                                  st->keep_alive.len) - st->keep_alive.data + 1;
+    return st;
+}
+
+int js_http_static_write(js_http_static_t *st, int keep_alive, js_buf_t *out) {
+    js_buf_t *src = keep_alive ? &st->keep_alive : &st->close;
 
+    if (js_buf_append(out, src->data, st->date_at) < 0
+        || js_http_append_date(out) < 0
+        || js_buf_append(out, src->data + st->date_at,
+                         src->len - st->date_at) < 0)
+        return -1;
     return 0;
 }
 
-void js_http_request_free(js_http_request_t *req) {
-    free(req->path);
-    free(req->query);
-    for (int i = 0; i < req->header_count; i++) {
-        free(req->headers[i].name);
-        free(req->headers[i].value);
-    }
-    free(req->headers);
-    free(req->body);
-    memset(req, 0, sizeof(*req));
+void js_http_static_free(js_http_static_t *st) {
+    js_buf_free(&st->keep_alive);
+    js_buf_free(&st->close);
+    free(st);
 }
 
 void js_http_response_free(js_http_response_t *resp) {
@@ -276,6 +1447,9 @@ void js_http_response_free(js_http_response_t *resp) {
         free(resp->headers[i].value);
     }
     free(resp->headers);
-    free(resp->body);
+    if (resp->body_ref)
+        js_rcbuf_release(resp->body_ref);
+    else
+        free(resp->body);
     memset(resp, 0, sizeof(*resp));
 }
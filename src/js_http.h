@@ -1,6 +1,17 @@
 #ifndef JS_HTTP_H
 #define JS_HTTP_H
 
+/* forward declarations */
+struct js_job_s;
+struct js_exec_s;
+struct js_http_reply_s;
+
+#define JS_HTTP_MAX_HEADERS   64
+#define JS_HTTP_MAX_HEAD      (64 * 1024)   /* request line + headers */
+#define JS_HTTP_OUT_HIGH_WATER (64 * 1024)  /* streamed body bytes unsent */
+#define JS_HTTP_BATCH_MAX     32            /* pipelined requests per flush */
+#define JS_HTTP_PIPELINE_MAX  16            /* replies pending per conn */
+
 /* ---- enum ---- */
 
 typedef enum {
@@ -19,15 +30,92 @@ typedef struct {
     char *value;
 } js_header_t;
 
+typedef enum {
+    JS_HTTP_PARSE_HEAD,         /* looking for the blank line */
+    JS_HTTP_PARSE_BODY,         /* head parsed, waiting for the body */
+    JS_HTTP_PARSE_CHUNK_SIZE,   /* chunked: hex size line */
+    JS_HTTP_PARSE_CHUNK_DATA,   /* chunked: chunk_left bytes of data */
+    JS_HTTP_PARSE_CHUNK_CRLF,   /* chunked: CRLF after the data */
+    JS_HTTP_PARSE_CHUNK_TRAILER /* chunked: trailer lines up to a blank one */
+} js_http_parse_state_t;
+
+typedef struct {
+    uint32_t  name;         /* offsets into rbuf */
+    uint32_t  value;
+} js_http_field_t;
+
+/*
+ * Resumable parser state, kept across reads. The head is parsed once, in
+ * place: strings are NUL-terminated inside rbuf and recorded as offsets,
+ * since rbuf may move while the body is still arriving.
+ *
+ * A chunked body is decoded in place as well: chunk data is moved down to
+ * follow the head directly, so the body ends up contiguous at head_len
+ * and the framing bytes between body_len and pos are dead.
+ */
+typedef struct {
+    js_http_parse_state_t  state;
+    size_t                 scanned;     /* rbuf bytes searched for CRLFCRLF */
+    size_t                 head_len;    /* up to and including CRLFCRLF */
+    size_t                 total;       /* head + body, consumed when done */
+    size_t                 body_limit;  /* max body bytes, 0 = unlimited */
+    size_t                 body_len;    /* body bytes (decoded so far) */
+    size_t                 streamed;    /* body bytes handed to a js_body_t */
+    size_t                 pos;         /* chunked: next undecoded byte */
+    size_t                 chunk_left;  /* chunked: data left in the chunk */
+    int                    chunked;
+    int                    error;       /* status to reject with, 0 = close */
+    js_http_method_t       method;
+    uint32_t               path;
+    uint32_t               query;       /* 0 = no query string */
+    int64_t                content_length;  /* -1 = absent */
+    int                    field_count;
+    js_http_field_t        fields[JS_HTTP_MAX_HEADERS];
+    int                    host;        /* index into fields, -1 = absent */
+    int                    content_type;
+    int                    connection;
+    int                    transfer_encoding;
+} js_http_parser_t;
+
+/*
+ * HTTP connection: per-conn protocol state follows the generic conn.
+ * Pipelined requests run concurrently; their replies queue up in request
+ * order and are written from the front as they complete.
+ */
+typedef struct {
+    js_conn_t               conn;       /* MUST be first */
+    js_http_parser_t        parser;
+    js_body_t              *body;       /* request body being streamed to JS */
+    struct js_exec_s       *out;        /* exec streaming the response body */
+    int                     out_idle;   /* EPOLLOUT off until the next chunk */
+    struct js_http_reply_s *replies;    /* oldest first */
+    struct js_http_reply_s *replies_tail;
+    int                     reply_count;
+    int                     last;       /* no requests after the current ones */
+    int                     eof;        /* the client sent all it will */
+    int                     cut;        /* a streamed body broke off */
+    int                     more;       /* a batch left requests in rbuf */
+    int                     held;       /* a streamed request holds the queue */
+} js_http_conn_t;
+
+/*
+ * A parsed request borrows the connection's rbuf: every string is a slice
+ * of it and stays valid until the request is consumed.
+ */
 typedef struct {
     js_http_method_t  method;
     char             *path;
     char             *query;
-    js_header_t      *headers;
+    js_header_t       headers[JS_HTTP_MAX_HEADERS];
     int               header_count;
-    char             *body;
+    const char       *host;             /* known headers, NULL if absent */
+    const char       *content_type;
+    const char       *connection;
+    char             *body;             /* not NUL-terminated, decoded */
     size_t            body_len;
-    int               content_length;  /* -1 if absent */
+    js_body_t        *stream;           /* instead of body, see js_body.h */
+    int64_t           content_length;   /* -1 if absent or chunked */
+    struct js_http_reply_s *reply;      /* where the response goes */
 } js_http_request_t;
 
 typedef struct {
@@ -36,20 +124,63 @@ typedef struct {
     int           header_count;
     char         *body;
     size_t        body_len;
+    js_rcbuf_t   *body_ref;     /* body lies in it: shared, not owned */
+    struct js_exec_s *stream;   /* body follows in chunks, see js_qjs.h */
 } js_http_response_t;
 
+/*
+ * A place in the conn's reply queue, taken when the request is. Either
+ * resp is filled, or serialized is set and the answer is the bytes in raw.
+ */
+typedef struct js_http_reply_s {
+    struct js_http_reply_s *next;
+    js_conn_t              *conn;
+    js_http_response_t      resp;
+    js_buf_t                raw;
+    int                     serialized; /* the answer is raw, not resp */
+    int                     keep_alive; /* of its request */
+    int                     done;
+} js_http_reply_t;
+
+/* response serialized once, in both Connection variants, without Date */
+typedef struct {
+    js_buf_t  keep_alive;
+    js_buf_t  close;
+    size_t    date_at;      /* end of the status line, where Date goes */
+} js_http_static_t;
+
 /* ---- conn init ---- */
 
 void js_http_conn_init(js_conn_t *conn);
+void js_http_job_done(struct js_job_s *job);
+void js_http_reply(js_http_reply_t *reply, js_http_response_t *resp);
+int  js_http_stream_send(js_conn_t *conn, const char *data, size_t len);
+void js_http_stream_end(js_conn_t *conn, struct js_exec_s *exec, int ok);
 
 /* ---- api ---- */
 
-int              js_http_parse_request(js_buf_t *buf, js_http_request_t *req);
+void             js_http_parser_init(js_http_parser_t *p, size_t body_limit);
+int              js_http_parse_head(js_http_parser_t *p, js_buf_t *buf);
+int              js_http_parse_request(js_http_parser_t *p, js_buf_t *buf,
+                                       js_http_request_t *req);
+int              js_http_parse_stream(js_http_parser_t *p, js_buf_t *buf,
+                                      js_body_t *body);
+void             js_http_request_fill(js_http_parser_t *p, js_buf_t *buf,
+                                      js_http_request_t *req);
+void             js_http_request_rebase(js_http_request_t *req,
+                                        const char *from, char *to);
 int              js_http_serialize_response(js_http_response_t *resp, js_buf_t *out,
                                             int keep_alive);
+int              js_http_write_response(js_conn_t *conn,
+                                        js_http_response_t *resp,
+                                        int keep_alive);
 const char      *js_http_status_text(int code);
 js_http_method_t js_http_method_from_str(const char *str, int len);
-void             js_http_request_free(js_http_request_t *req);
 void             js_http_response_free(js_http_response_t *resp);
 
+js_http_static_t *js_http_static_create(js_http_response_t *resp);
+int               js_http_static_write(js_http_static_t *st, int keep_alive,
+                                       js_buf_t *out);
+void              js_http_static_free(js_http_static_t *st);
+
 #endif
@@ -1,55 +1,150 @@
 #include "js_main.h"
 
 static void js_usage(const char *prog) {
-    fprintf(stderr, "Usage: %s <script.js>\n", prog);
+    fprintf(stderr, "Usage: %s <script.js|script.jsbc>\n"
+                    "       %s compile <script.js> [-o <script.jsbc>]\n"
+                    "       %s build <script.js> [-o <executable>]\n",
+            prog, prog, prog);
     exit(1);
 }
 
-int main(int argc, char **argv) {
-    if (argc < 2)
+/* "mock.js" + ext -> "mock<ext>"; ".jsbc" for bundles, "" for executables */
+static char *js_output_path(const char *script, const char *ext) {
+    size_t len = strlen(script);
+    size_t elen = strlen(ext);
+    if (len > 3 && strcmp(script + len - 3, ".js") == 0)
+        len -= 3;
+    char *path = malloc(len + elen + 1);
+    if (path) {
+        memcpy(path, script, len);
+        memcpy(path + len, ext, elen + 1);
+    }
+    return path;
+}
+
+/*
+ * jsmock compile <script.js> [-o <script.jsbc>]
+ * jsmock build <script.js> [-o <executable>]
+ */
+static int js_compile_main(int argc, char **argv, int build) {
+    const char *script = NULL;
+    const char *out = NULL;
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            out = argv[++i];
+        else if (!script)
+            script = argv[i];
+        else
+            js_usage(argv[0]);
+    }
+    if (!script)
         js_usage(argv[0]);
 
-    const char *script = argv[1];
+    js_runtime_t rt;
+    if (js_runtime_init(&rt) < 0) {
+        fprintf(stderr, "error: runtime init failed\n");
+        return 1;
+    }
+    rt.script_path = strdup(script);
 
-    /* 1. compile script to bytecode */
-    uint8_t *bytecode = NULL;
-    size_t bytecode_len = 0;
-    if (js_qjs_compile(script, &bytecode, &bytecode_len) < 0) {
+    if (js_qjs_compile(&rt) < 0) {
         fprintf(stderr, "error: failed to compile %s\n", script);
+        js_runtime_free(&rt);
         return 1;
     }
 
-    /* 2. read config: export default { listen } */
-    char *host = NULL;
-    int port = 3000; /* default port */
-    js_qjs_read_config(script, bytecode, bytecode_len, &host, &port);
+    char *path = out ? strdup(out) : js_output_path(script, build ? "" : ".jsbc");
+    int ret = -1;
+    if (!path)
+        errno = ENOMEM;
+    else if (strcmp(path, script) == 0)
+        errno = EEXIST;     /* never overwrite the source */
+    else if (build)
+        ret = js_bundle_embed(&rt, path);
+    else
+        ret = js_bundle_write(&rt, path);
+
+    if (ret < 0)
+        fprintf(stderr, "error: failed to write %s (%s)\n",
+                path ? path : script, strerror(errno));
+
+    free(path);
+    js_runtime_free(&rt);
+    return ret < 0 ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 2 && strcmp(argv[1], "compile") == 0)
+        return js_compile_main(argc, argv, 0);
+    if (argc >= 2 && strcmp(argv[1], "build") == 0)
+        return js_compile_main(argc, argv, 1);
 
-    /* 3. init runtime */
+    /* 1. init runtime */
     js_runtime_t rt;
     if (js_runtime_init(&rt) < 0) {
         fprintf(stderr, "error: runtime init failed\n");
         return 1;
     }
-    rt.bytecode = bytecode;
-    rt.bytecode_len = bytecode_len;
-    rt.script_path = strdup(script);
-    rt.host = host;
-    rt.port = port;
+    js_web_global_init();
+    js_scan_init();
+
+    /* 2. embedded bundle, precompiled bundle, or compile the script */
+    int rc = argc < 2 ? js_bundle_load_embedded(&rt) : 1;
+    if (rc < 0) {
+        fprintf(stderr, "error: invalid embedded bundle\n");
+        js_runtime_free(&rt);
+        return 1;
+    }
+    if (rc == 1 && argc < 2)
+        js_usage(argv[0]);
+
+    const char *script = argv[1];
+    int stale = 0;
+    if (rc == 0) {
+        /* standalone executable: nothing to read from disk */
+    } else if (js_bundle_detect(script)) {
+        rc = js_bundle_load(&rt, script);
+        if (rc < 0) {
+            fprintf(stderr, "error: invalid bundle %s\n", script);
+            js_runtime_free(&rt);
+            return 1;
+        }
+        stale = (rc == 1);
+        if (stale)
+            fprintf(stderr, "%s: sources changed, recompiling %s\n",
+                    script, rt.script_path);
+    } else {
+        rt.script_path = strdup(script);
+    }
+
+    if (rc != 0) {
+        if (js_qjs_compile(&rt) < 0) {
+            fprintf(stderr, "error: failed to compile %s\n", rt.script_path);
+            js_runtime_free(&rt);
+            return 1;
+        }
+        /* refresh a stale bundle so the next start is fast again */
+        if (stale && js_bundle_write(&rt, script) < 0)
+            fprintf(stderr, "warning: failed to update %s\n", script);
+    }
+
+    /* 3. read config: export default { listen, isolation, pool, ... } */
+    js_qjs_read_config(&rt);
 
     /* 4. create listen socket */
     if (js_runtime_listen(&rt) < 0) {
         fprintf(stderr, "error: failed to listen on %s:%d (%s)\n",
-                host ? host : "0.0.0.0", port, strerror(errno));
+                rt.host ? rt.host : "0.0.0.0", rt.port, strerror(errno));
         js_runtime_free(&rt);
         return 1;
     }
 
     fprintf(stderr, "jsmock listening on %s:%d\n",
-            host ? host : "0.0.0.0", port);
+            rt.host ? rt.host : "0.0.0.0", rt.port);
 
-    /* 5. spawn worker threads */
-    int nthreads = 4; /* TODO: make configurable */
-    if (js_thread_spawn_all(&rt, nthreads) < 0) {
+    /* 5. spawn I/O threads and JS workers */
+    if (js_thread_spawn_all(&rt, rt.thread_count) < 0) {
         fprintf(stderr, "error: failed to spawn threads\n");
         js_runtime_free(&rt);
         return 1;
@@ -15,15 +15,23 @@
 #include "js_time.h"
 #include "js_rbtree.h"
 #include "js_epoll.h"
+#include "js_uring.h"
 #include "js_timer.h"
 #include "js_engine.h"
 #include "js_buf.h"
+#include "js_scan.h"
+#include "js_arena.h"
 #include "js_conn.h"
+#include "js_body.h"
 #include "js_http.h"
 #include "js_route.h"
 #include "js_store.h"
+#include "js_cache.h"
 #include "js_qjs.h"
 #include "js_web.h"
+#include "js_pool.h"
+#include "js_bundle.h"
+#include "js_worker.h"
 #include "js_tls.h"
 #include "js_thread.h"
 #include "js_runtime.h"
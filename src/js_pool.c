@@ -0,0 +1,84 @@
+#include "js_main.h"
+
+/*
+ * Per-thread pool of execs. An exec owns a QuickJS runtime and context with
+ * the Web APIs registered and the module already evaluated, so checking one
+ * out leaves only route matching and the handler call on the request path.
+ *
+ * With JS_ISOLATION_REQUEST an exec is never recycled: every request still
+ * sees a pristine module, exactly as before pooling existed.
+ */
+
+void js_pool_init(js_pool_t *pool, int max_idle) {
+    pool->idle = NULL;
+    pool->idle_count = 0;
+    pool->max_idle = max_idle;
+}
+
+/*
+ * Evaluate the module once at thread startup, so top-level code (fixture
+ * data, route registration) never runs on the request path. Any top-level
+ * timers stay attached to the exec; the first request to check it out
+ * waits for them, as it would have if evaluation happened on demand.
+ */
+int js_pool_prewarm(js_pool_t *pool, js_runtime_t *rt) {
+    js_exec_t *exec = js_exec_create(rt);
+    if (!exec)
+        return -1;
+    exec->next = pool->idle;
+    pool->idle = exec;
+    pool->idle_count++;
+    return 0;
+}
+
+js_exec_t *js_pool_get(js_pool_t *pool, js_runtime_t *rt) {
+    js_exec_t *exec;
+    while ((exec = pool->idle) != NULL) {
+        pool->idle = exec->next;
+        pool->idle_count--;
+        exec->next = NULL;
+        /* a top-level timer ran over a limit while the exec sat idle */
+        if (exec->interrupted || exec->oom) {
+            js_exec_free(exec);
+            continue;
+        }
+        return exec;
+    }
+    return js_exec_create(rt);
+}
+
+void js_pool_put(js_pool_t *pool, js_exec_t *exec) {
+    if (exec->rt->isolation == JS_ISOLATION_REQUEST
+        || exec->timeouts != NULL
+        || exec->interrupted
+        || exec->oom
+        || pool->idle_count >= pool->max_idle)
+    {
+        js_exec_free(exec);
+        return;
+    }
+
+    /* reset per-request state, keep the evaluated module */
+    exec->conn = NULL;
+    exec->reply = NULL;
+    exec->job = NULL;
+    memset(&exec->resp, 0, sizeof(exec->resp));
+    exec->resolved = 0;
+    exec->used = 0;
+    exec->route = NULL;
+    exec->out_state = JS_OUT_NONE;
+    exec->out_conn = NULL;
+
+    exec->next = pool->idle;
+    pool->idle = exec;
+    pool->idle_count++;
+}
+
+void js_pool_free(js_pool_t *pool) {
+    while (pool->idle) {
+        js_exec_t *next = pool->idle->next;
+        js_exec_free(pool->idle);
+        pool->idle = next;
+    }
+    pool->idle_count = 0;
+}
@@ -0,0 +1,23 @@
+#ifndef JS_POOL_H
+#define JS_POOL_H
+
+/* forward declaration */
+struct js_runtime_s;
+
+/* ---- struct ---- */
+
+typedef struct {
+    js_exec_t  *idle;         /* recycled execs, ready for checkout */
+    int         idle_count;
+    int         max_idle;
+} js_pool_t;
+
+/* ---- api ---- */
+
+void       js_pool_init(js_pool_t *pool, int max_idle);
+int        js_pool_prewarm(js_pool_t *pool, struct js_runtime_s *rt);
+js_exec_t *js_pool_get(js_pool_t *pool, struct js_runtime_s *rt);
+void       js_pool_put(js_pool_t *pool, js_exec_t *exec);
+void       js_pool_free(js_pool_t *pool);
+
+#endif
@@ -42,18 +42,78 @@ static char *js_module_normalize(JSContext *ctx, const char *base_name,
     return resolved;
 }
 
-static JSModuleDef *js_module_loader(JSContext *ctx, const char *module_name,
-                                     void *opaque) {
-    (void)opaque;
+static js_module_t *js_module_find(js_runtime_t *rt, const char *name) {
+    for (js_module_t *mod = rt->modules; mod; mod = mod->next) {
+        if (strcmp(mod->name, name) == 0)
+            return mod;
+    }
+    return NULL;
+}
+
+static JSValue js_module_compile_file(JSContext *ctx, const char *module_name) {
     size_t buf_len;
     char *buf = js_qjs_read_file(module_name, &buf_len);
-    if (!buf) {
-        JS_ThrowReferenceError(ctx, "could not load module '%s'", module_name);
-        return NULL;
-    }
+    if (!buf)
+        return JS_ThrowReferenceError(ctx, "could not load module '%s'",
+                                      module_name);
     JSValue func_val = JS_Eval(ctx, buf, buf_len, module_name,
                                JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY);
     free(buf);
+    return func_val;
+}
+
+/*
+ * Startup loader: compile each imported module from disk once and keep
+ * its bytecode in rt->modules, keyed by resolved path. JS_Eval() resolves
+ * nested imports itself, so the whole graph is visited.
+ */
+static JSModuleDef *js_module_compile_loader(JSContext *ctx,
+                                             const char *module_name,
+                                             void *opaque) {
+    js_runtime_t *rt = opaque;
+    JSValue func_val = js_module_compile_file(ctx, module_name);
+    if (JS_IsException(func_val))
+        return NULL;
+
+    js_module_t *mod = calloc(1, sizeof(*mod));
+    if (!mod) {
+        JS_FreeValue(ctx, func_val);
+        JS_ThrowOutOfMemory(ctx);
+        return NULL;
+    }
+    mod->bytecode = JS_WriteObject(ctx, &mod->bytecode_len, func_val,
+                                   JS_WRITE_OBJ_BYTECODE);
+    mod->name = strdup(module_name);
+    if (!mod->bytecode || !mod->name) {
+        if (mod->bytecode)
+            js_free(ctx, mod->bytecode);
+        free(mod->name);
+        free(mod);
+        JS_FreeValue(ctx, func_val);
+        return NULL;
+    }
+    mod->next = rt->modules;
+    rt->modules = mod;
+
+    JSModuleDef *m = JS_VALUE_GET_PTR(func_val);
+    JS_FreeValue(ctx, func_val);
+    return m;
+}
+
+/* request-time loader: serve imports from the startup bytecode cache */
+static JSModuleDef *js_module_loader(JSContext *ctx, const char *module_name,
+                                     void *opaque) {
+    js_runtime_t *rt = opaque;
+    js_module_t *mod = js_module_find(rt, module_name);
+    JSValue func_val;
+
+    if (mod) {
+        func_val = JS_ReadObject(ctx, mod->bytecode, mod->bytecode_len,
+                                 JS_READ_OBJ_BYTECODE);
+    } else {
+        /* outside the startup graph, e.g. a computed dynamic import() */
+        func_val = js_module_compile_file(ctx, module_name);
+    }
     if (JS_IsException(func_val))
         return NULL;
     JSModuleDef *m = JS_VALUE_GET_PTR(func_val);
@@ -69,14 +129,130 @@ static JSValue js_stub_noop(JSContext *ctx, JSValueConst this_val,
     return JS_UNDEFINED;
 }
 
+/* register a constant Response as a static route (context opaque: rt) */
+static JSValue js_stub_add_static(JSContext *ctx, js_http_method_t method,
+                                  JSValueConst path_val, JSValueConst resp_val) {
+    js_runtime_t *rt = JS_GetContextOpaque(ctx);
+    js_http_response_t resp = {0};
+
+    if (js_web_read_response(ctx, resp_val, &resp) < 0)
+        return JS_EXCEPTION;
+
+    const char *path = JS_ToCString(ctx, path_val);
+    if (!path) {
+        js_http_response_free(&resp);
+        return JS_EXCEPTION;
+    }
+
+    js_http_static_t *st = js_http_static_create(&resp);
+    js_http_response_free(&resp);
+    js_route_t *r = NULL;
+    if (st)
+        r = js_route_add(&rt->static_routes, method, path, JS_UNDEFINED);
+    JS_FreeCString(ctx, path);
+
+    if (!r) {
+        if (st)
+            js_http_static_free(st);
+        return JS_ThrowOutOfMemory(ctx);
+    }
+    r->static_resp = st;
+    return JS_UNDEFINED;
+}
+
+/*
+ * mock.get(path, handler, opts): a constant Response becomes a static
+ * route; a handler is recorded with its options (the function itself
+ * lives in each exec) so C can see e.g. cache settings before JS runs.
+ */
+static JSValue js_stub_route(JSContext *ctx, JSValueConst this_val,
+                             int argc, JSValueConst *argv, int magic) {
+    (void)this_val;
+    js_runtime_t *rt = JS_GetContextOpaque(ctx);
+
+    if (argc < 2)
+        return JS_UNDEFINED;
+    if (js_web_is_response(argv[1]))
+        return js_stub_add_static(ctx, magic, argv[0], argv[1]);
+    if (!JS_IsFunction(ctx, argv[1]))
+        return JS_UNDEFINED;
+
+    const char *path = JS_ToCString(ctx, argv[0]);
+    if (!path)
+        return JS_EXCEPTION;
+    js_route_t *r = js_route_add(&rt->routes, magic, path, JS_UNDEFINED);
+    JS_FreeCString(ctx, path);
+    if (!r)
+        return JS_ThrowOutOfMemory(ctx);
+
+    if (argc > 2)
+        js_web_route_options(ctx, argv[2], r);
+    if (r->cache_ttl > 0)
+        rt->cached_routes++;
+    if (r->stream)
+        rt->stream_routes++;
+    return JS_UNDEFINED;
+}
+
+/* mock.static(method, path, body, init) */
+static JSValue js_stub_static(JSContext *ctx, JSValueConst this_val,
+                              int argc, JSValueConst *argv) {
+    (void)this_val;
+    if (argc < 2)
+        return JS_ThrowTypeError(ctx, "mock.static: method and path required");
+
+    size_t len;
+    const char *name = JS_ToCStringLen(ctx, &len, argv[0]);
+    if (!name)
+        return JS_EXCEPTION;
+    js_http_method_t method = js_http_method_from_str(name, len);
+    int known = method != JS_HTTP_ALL || strcmp(name, "ALL") == 0
+                || strcmp(name, "*") == 0;
+    JS_FreeCString(ctx, name);
+    if (!known)
+        return JS_ThrowTypeError(ctx, "mock.static: unknown method");
+
+    JSValue global = JS_GetGlobalObject(ctx);
+    JSValue ctor = JS_GetPropertyStr(ctx, global, "Response");
+    JSValueConst args[2] = {
+        argc > 2 ? argv[2] : JS_UNDEFINED,
+        argc > 3 ? argv[3] : JS_UNDEFINED,
+    };
+    JSValue resp = JS_CallConstructor(ctx, ctor, 2, args);
+    JS_FreeValue(ctx, ctor);
+    JS_FreeValue(ctx, global);
+    if (JS_IsException(resp))
+        return resp;
+
+    JSValue ret = js_stub_add_static(ctx, method, argv[1], resp);
+    JS_FreeValue(ctx, resp);
+    return ret;
+}
+
 static void js_qjs_register_stubs(JSContext *ctx) {
     JSValue global = JS_GetGlobalObject(ctx);
 
     JSValue mock = JS_NewObject(ctx);
-    const char *methods[] = {"get","post","put","patch","delete","all","env",NULL};
-    for (int i = 0; methods[i]; i++)
-        JS_SetPropertyStr(ctx, mock, methods[i],
-                          JS_NewCFunction(ctx, js_stub_noop, methods[i], 2));
+    static const struct {
+        const char        *name;
+        js_http_method_t   method;
+    } methods[] = {
+        { "get", JS_HTTP_GET },       { "post", JS_HTTP_POST },
+        { "put", JS_HTTP_PUT },       { "patch", JS_HTTP_PATCH },
+        { "delete", JS_HTTP_DELETE }, { "all", JS_HTTP_ALL },
+    };
+    for (int i = 0; i < js_countof(methods); i++)
+        JS_SetPropertyStr(ctx, mock, methods[i].name,
+                          JS_NewCFunctionMagic(ctx, js_stub_route,
+                                               methods[i].name, 2,
+                                               JS_CFUNC_generic_magic,
+                                               methods[i].method));
+    JS_SetPropertyStr(ctx, mock, "env",
+                      JS_NewCFunction(ctx, js_web_env, "env", 1));
+    JS_SetPropertyStr(ctx, mock, "stats",
+                      JS_NewCFunction(ctx, js_stub_noop, "stats", 0));
+    JS_SetPropertyStr(ctx, mock, "static",
+                      JS_NewCFunction(ctx, js_stub_static, "static", 4));
 
     JSValue store = JS_NewObject(ctx);
     const char *smethods[] = {"get","set","del","incr","clear",NULL};
@@ -86,8 +262,8 @@ static void js_qjs_register_stubs(JSContext *ctx) {
     JS_SetPropertyStr(ctx, mock, "store", store);
     JS_SetPropertyStr(ctx, global, "mock", mock);
 
-    JS_SetPropertyStr(ctx, global, "Response",
-                      JS_NewCFunction(ctx, js_stub_noop, "Response", 2));
+    /* the real Response, so module-level constants can be captured */
+    js_web_init_response(ctx);
     JS_SetPropertyStr(ctx, global, "Headers",
                       JS_NewCFunction(ctx, js_stub_noop, "Headers", 0));
     JS_SetPropertyStr(ctx, global, "URL",
@@ -110,14 +286,16 @@ static void js_qjs_register_stubs(JSContext *ctx) {
 
 /* ---- public API ---- */
 
-int js_qjs_compile(const char *filename, uint8_t **out_buf, size_t *out_len) {
+int js_qjs_compile(js_runtime_t *rt) {
+    const char *filename = rt->script_path;
     size_t fsize;
     char *src = js_qjs_read_file(filename, &fsize);
     if (!src) return -1;
 
-    JSRuntime *rt = JS_NewRuntime();
-    JSContext *ctx = JS_NewContext(rt);
-    JS_SetModuleLoaderFunc(rt, js_module_normalize, js_module_loader, NULL);
+    JSRuntime *qrt = JS_NewRuntime();
+    JSContext *ctx = JS_NewContext(qrt);
+    JS_SetModuleLoaderFunc(qrt, js_module_normalize, js_module_compile_loader,
+                           rt);
 
     int flags = JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY;
     JSValue obj = JS_Eval(ctx, src, fsize, filename, flags);
@@ -126,47 +304,46 @@ int js_qjs_compile(const char *filename, uint8_t **out_buf, size_t *out_len) {
     if (JS_IsException(obj)) {
         JS_FreeValue(ctx, obj);
         JS_FreeContext(ctx);
-        JS_FreeRuntime(rt);
+        JS_FreeRuntime(qrt);
         return -1;
     }
 
-    *out_buf = JS_WriteObject(ctx, out_len, obj, JS_WRITE_OBJ_BYTECODE);
+    rt->bytecode = JS_WriteObject(ctx, &rt->bytecode_len, obj,
+                                  JS_WRITE_OBJ_BYTECODE);
     JS_FreeValue(ctx, obj);
     JS_FreeContext(ctx);
-    JS_FreeRuntime(rt);
+    JS_FreeRuntime(qrt);
 
-    return *out_buf ? 0 : -1;
+    return rt->bytecode ? 0 : -1;
 }
 
-int js_qjs_read_config(const char *script_path, uint8_t *bytecode, size_t len,
-                       char **host, int *port) {
-    (void)bytecode; (void)len;
-
-    JSRuntime *rt = JS_NewRuntime();
-    JSContext *ctx = JS_NewContext(rt);
-    JS_SetModuleLoaderFunc(rt, js_module_normalize, js_module_loader, NULL);
+int js_qjs_read_config(js_runtime_t *rt) {
+    JSRuntime *qrt = JS_NewRuntime();
+    JSContext *ctx = JS_NewContext(qrt);
+    JS_SetModuleLoaderFunc(qrt, js_module_normalize, js_module_loader, rt);
+    JS_SetContextOpaque(ctx, rt);
     js_qjs_register_stubs(ctx);
 
-    /* compile and evaluate from source */
-    size_t slen;
-    char *src = js_qjs_read_file(script_path, &slen);
-    if (!src) goto fail;
-
-    JSValue obj = JS_Eval(ctx, src, slen, script_path,
-                          JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY);
-    free(src);
+    /* evaluate the startup bytecode; the source is never parsed twice */
+    JSValue obj = JS_ReadObject(ctx, rt->bytecode, rt->bytecode_len,
+                                JS_READ_OBJ_BYTECODE);
     if (JS_IsException(obj)) goto fail;
 
     JSModuleDef *m = NULL;
     if (JS_VALUE_GET_TAG(obj) == JS_TAG_MODULE)
         m = JS_VALUE_GET_PTR(obj);
 
+    if (JS_ResolveModule(ctx, obj) < 0) {
+        JS_FreeValue(ctx, obj);
+        goto fail;
+    }
+
     JSValue result = JS_EvalFunction(ctx, obj);
     if (JS_IsException(result)) goto fail;
     JS_FreeValue(ctx, result);
 
     JSContext *ctx1;
-    while (JS_ExecutePendingJob(rt, &ctx1) > 0)
+    while (JS_ExecutePendingJob(qrt, &ctx1) > 0)
         ;
 
     if (!m) goto fail;
@@ -179,46 +356,148 @@ int js_qjs_read_config(const char *script_path, uint8_t *bytecode, size_t len,
     if (JS_IsUndefined(def) || JS_IsException(def)) goto fail;
 
     JSValue listen_val = JS_GetPropertyStr(ctx, def, "listen");
-    JS_FreeValue(ctx, def);
 
     if (JS_IsNumber(listen_val)) {
         int32_t p;
         JS_ToInt32(ctx, &p, listen_val);
-        *port = p;
-        *host = NULL;
+        rt->port = p;
+        rt->host = NULL;
     } else if (JS_IsString(listen_val)) {
         const char *str = JS_ToCString(ctx, listen_val);
         const char *colon = strrchr(str, ':');
         if (colon) {
-            *host = strndup(str, colon - str);
-            *port = atoi(colon + 1);
+            rt->host = strndup(str, colon - str);
+            rt->port = atoi(colon + 1);
         } else {
-            *port = atoi(str);
-            *host = NULL;
+            rt->port = atoi(str);
+            rt->host = NULL;
         }
         JS_FreeCString(ctx, str);
     }
     JS_FreeValue(ctx, listen_val);
 
+    /* isolation: "request" (default) | "thread" */
+    JSValue iso_val = JS_GetPropertyStr(ctx, def, "isolation");
+    if (JS_IsString(iso_val)) {
+        const char *str = JS_ToCString(ctx, iso_val);
+        if (strcmp(str, "thread") == 0)
+            rt->isolation = JS_ISOLATION_THREAD;
+        else if (strcmp(str, "request") == 0)
+            rt->isolation = JS_ISOLATION_REQUEST;
+        else
+            fprintf(stderr, "warning: unknown isolation \"%s\", "
+                    "using \"request\"\n", str);
+        JS_FreeCString(ctx, str);
+    }
+    JS_FreeValue(ctx, iso_val);
+
+    /* pool: max idle execs kept per thread */
+    JSValue pool_val = JS_GetPropertyStr(ctx, def, "pool");
+    if (JS_IsNumber(pool_val)) {
+        int32_t n;
+        JS_ToInt32(ctx, &n, pool_val);
+        if (n > 0)
+            rt->pool_size = n;
+    }
+    JS_FreeValue(ctx, pool_val);
+
+    /* threads: I/O event loops; workers: JS executors (0 = inline JS) */
+    JSValue threads_val = JS_GetPropertyStr(ctx, def, "threads");
+    if (JS_IsNumber(threads_val)) {
+        int32_t n;
+        JS_ToInt32(ctx, &n, threads_val);
+        if (n > 0)
+            rt->thread_count = n;
+    }
+    JS_FreeValue(ctx, threads_val);
+
+    JSValue workers_val = JS_GetPropertyStr(ctx, def, "workers");
+    if (JS_IsNumber(workers_val)) {
+        int32_t n;
+        JS_ToInt32(ctx, &n, workers_val);
+        if (n >= 0)
+            rt->worker_count = n;
+    }
+    JS_FreeValue(ctx, workers_val);
+
+    /* events: "level" (default) | "edge", how connections are polled */
+    JSValue events_val = JS_GetPropertyStr(ctx, def, "events");
+    if (JS_IsString(events_val)) {
+        const char *str = JS_ToCString(ctx, events_val);
+        if (strcmp(str, "edge") == 0)
+            rt->edge = 1;
+        else if (strcmp(str, "level") == 0)
+            rt->edge = 0;
+        else
+            fprintf(stderr, "warning: unknown events \"%s\", "
+                    "using \"level\"\n", str);
+        JS_FreeCString(ctx, str);
+    }
+    JS_FreeValue(ctx, events_val);
+
+    /* engine: "epoll" (default) | "io_uring", the event backend */
+    JSValue engine_val = JS_GetPropertyStr(ctx, def, "engine");
+    if (JS_IsString(engine_val)) {
+        const char *str = JS_ToCString(ctx, engine_val);
+        if (strcmp(str, "io_uring") == 0)
+            rt->io_uring = 1;
+        else if (strcmp(str, "epoll") == 0)
+            rt->io_uring = 0;
+        else
+            fprintf(stderr, "warning: unknown engine \"%s\", "
+                    "using \"epoll\"\n", str);
+        JS_FreeCString(ctx, str);
+    }
+    JS_FreeValue(ctx, engine_val);
+
+    /* budget: ms of JS time per request (0 = off) | { ms, status } */
+    JSValue budget_val = JS_GetPropertyStr(ctx, def, "budget");
+    js_web_read_budget(ctx, budget_val, &rt->budget, &rt->budget_status);
+    JS_FreeValue(ctx, budget_val);
+
+    /* limits: { memory, gcThreshold } per exec runtime, { body } per request */
+    JSValue limits_val = JS_GetPropertyStr(ctx, def, "limits");
+    if (JS_IsObject(limits_val)) {
+        int64_t n;
+        JSValue v = JS_GetPropertyStr(ctx, limits_val, "memory");
+        if (JS_IsNumber(v) && JS_ToInt64(ctx, &n, v) == 0 && n >= 0)
+            rt->memory_limit = n;
+        JS_FreeValue(ctx, v);
+
+        v = JS_GetPropertyStr(ctx, limits_val, "gcThreshold");
+        if (JS_IsNumber(v) && JS_ToInt64(ctx, &n, v) == 0 && n >= 0)
+            rt->gc_threshold = n;
+        JS_FreeValue(ctx, v);
+
+        v = JS_GetPropertyStr(ctx, limits_val, "body");
+        if (JS_IsNumber(v) && JS_ToInt64(ctx, &n, v) == 0 && n >= 0)
+            rt->body_limit = n;
+        JS_FreeValue(ctx, v);
+    }
+    JS_FreeValue(ctx, limits_val);
+
+    JS_FreeValue(ctx, def);
     JS_FreeContext(ctx);
-    JS_FreeRuntime(rt);
+    JS_FreeRuntime(qrt);
     return 0;
 
 fail:
     JS_FreeContext(ctx);
-    JS_FreeRuntime(rt);
+    JS_FreeRuntime(qrt);
     return -1;
 }
 
 /* ---- Promise resolve/reject callbacks ---- */
 
+static void js_qjs_take_response(js_exec_t *exec, JSValueConst val);
+
 static JSValue js_promise_on_resolve(JSContext *ctx, JSValueConst this_val,
                                      int argc, JSValueConst *argv) {
     (void)this_val;
     js_exec_t *exec = JS_GetContextOpaque(ctx);
 
     if (argc >= 1)
-        js_web_read_response(ctx, argv[0], &exec->resp);
+        js_qjs_take_response(exec, argv[0]);
     else {
         exec->resp.status = 500;
         exec->resp.body = strdup("Internal Server Error");
@@ -239,14 +518,230 @@ static JSValue js_promise_on_reject(JSContext *ctx, JSValueConst this_val,
     return JS_UNDEFINED;
 }
 
-/* ---- async lifecycle ---- */
+/* ---- exec lifecycle ---- */
 
-void js_pending_finish(js_exec_t *exec) {
-    js_engine_t *eng = &js_thread_current->engine;
-    js_conn_t *conn = exec->conn;
+static void js_qjs_dump_error(JSContext *ctx) {
+    JSValue exc = JS_GetException(ctx);
+    const char *str = JS_ToCString(ctx, exc);
+    if (str) {
+        fprintf(stderr, "error: %s\n", str);
+        JS_FreeCString(ctx, str);
+    }
+    if (JS_IsError(ctx, exc)) {
+        JSValue stack = JS_GetPropertyStr(ctx, exc, "stack");
+        if (JS_IsString(stack)) {
+            str = JS_ToCString(ctx, stack);
+            if (str) {
+                fputs(str, stderr);
+                JS_FreeCString(ctx, str);
+            }
+        }
+        JS_FreeValue(ctx, stack);
+    }
+    JS_FreeValue(ctx, exc);
+}
 
-    /* cancel any outstanding timers */
+/* ---- allocators ---- */
+
+/*
+ * JSMallocFunctions for exec runtimes (opaque: exec). Accounting mirrors
+ * QuickJS's default allocator so JS_SetMemoryLimit() and
+ * JS_ComputeMemoryUsage() keep working; on top of that the exec tracks
+ * its heap peak and notices when the limit refuses an allocation.
+ */
+static int js_qjs_mem_reserve(JSMallocState *s, size_t size) {
+    js_exec_t *exec = s->opaque;
+
+    if (s->malloc_size + size <= s->malloc_limit)
+        return 0;
+
+    if (!exec->oom) {
+        exec->oom = 1;
+        __atomic_add_fetch(&exec->rt->memory_exceeded, 1, __ATOMIC_RELAXED);
+    }
+    return -1;
+}
+
+static void js_qjs_mem_update(JSMallocState *s) {
+    js_exec_t *exec = s->opaque;
+
+    exec->heap = s->malloc_size;
+    if (exec->heap > exec->heap_peak)
+        exec->heap_peak = exec->heap;
+}
+
+/* request isolation: js_arena_t, torn down in one step */
+
+static void *js_qjs_arena_malloc(JSMallocState *s, size_t size) {
+    js_exec_t *exec = s->opaque;
+
+    if (js_qjs_mem_reserve(s, size) < 0)
+        return NULL;
+
+    void *ptr = js_arena_alloc(&exec->arena, size);
+    if (!ptr)
+        return NULL;
+
+    s->malloc_count++;
+    s->malloc_size += js_arena_usable_size(ptr);
+    js_qjs_mem_update(s);
+    return ptr;
+}
+
+static void js_qjs_arena_free(JSMallocState *s, void *ptr) {
+    js_exec_t *exec = s->opaque;
+
+    if (!ptr)
+        return;
+
+    s->malloc_count--;
+    s->malloc_size -= js_arena_usable_size(ptr);
+    js_qjs_mem_update(s);
+    js_arena_free(&exec->arena, ptr);
+}
+
+static void *js_qjs_arena_realloc(JSMallocState *s, void *ptr, size_t size) {
+    js_exec_t *exec = s->opaque;
+
+    if (!ptr)
+        return size ? js_qjs_arena_malloc(s, size) : NULL;
+
+    if (size == 0) {
+        js_qjs_arena_free(s, ptr);
+        return NULL;
+    }
+
+    size_t old_size = js_arena_usable_size(ptr);
+    if (size > old_size && js_qjs_mem_reserve(s, size - old_size) < 0)
+        return NULL;
+
+    ptr = js_arena_realloc(&exec->arena, ptr, size);
+    if (!ptr)
+        return NULL;
+
+    s->malloc_size += js_arena_usable_size(ptr) - old_size;
+    js_qjs_mem_update(s);
+    return ptr;
+}
+
+static const JSMallocFunctions js_qjs_arena_mf = {
+    js_qjs_arena_malloc,
+    js_qjs_arena_free,
+    js_qjs_arena_realloc,
+    js_arena_usable_size,
+};
+
+/* thread isolation: the system allocator, as JS_NewRuntime() would use */
+
+static size_t js_qjs_sys_usable_size(const void *ptr) {
+    return malloc_usable_size((void *) ptr);
+}
+
+static void *js_qjs_sys_malloc(JSMallocState *s, size_t size) {
+    if (js_qjs_mem_reserve(s, size) < 0)
+        return NULL;
+
+    void *ptr = malloc(size);
+    if (!ptr)
+        return NULL;
+
+    s->malloc_count++;
+    s->malloc_size += js_qjs_sys_usable_size(ptr);
+    js_qjs_mem_update(s);
+    return ptr;
+}
+
+static void js_qjs_sys_free(JSMallocState *s, void *ptr) {
+    if (!ptr)
+        return;
+
+    s->malloc_count--;
+    s->malloc_size -= js_qjs_sys_usable_size(ptr);
+    js_qjs_mem_update(s);
+    free(ptr);
+}
+
+static void *js_qjs_sys_realloc(JSMallocState *s, void *ptr, size_t size) {
+    if (!ptr)
+        return size ? js_qjs_sys_malloc(s, size) : NULL;
+
+    if (size == 0) {
+        js_qjs_sys_free(s, ptr);
+        return NULL;
+    }
+
+    size_t old_size = js_qjs_sys_usable_size(ptr);
+    if (size > old_size && js_qjs_mem_reserve(s, size - old_size) < 0)
+        return NULL;
+
+    ptr = realloc(ptr, size);
+    if (!ptr)
+        return NULL;
+
+    s->malloc_size += js_qjs_sys_usable_size(ptr) - old_size;
+    js_qjs_mem_update(s);
+    return ptr;
+}
+
+static const JSMallocFunctions js_qjs_sys_mf = {
+    js_qjs_sys_malloc,
+    js_qjs_sys_free,
+    js_qjs_sys_realloc,
+    js_qjs_sys_usable_size,
+};
+
+/* ---- JS time budget ---- */
+
+static js_nsec_t js_qjs_now(void) {
+    js_monotonic_time_t now;
+    js_monotonic_time(&now);
+    return now.monotonic;
+}
+
+/*
+ * Polled by QuickJS every few thousand bytecode instructions. Returning 1
+ * throws an uncatchable error, so a runaway handler unwinds back to C
+ * instead of holding the worker thread.
+ */
+static int js_qjs_interrupt(JSRuntime *qrt, void *opaque) {
+    (void)qrt;
+    js_exec_t *exec = opaque;
+
+    if (exec->deadline == 0 || js_qjs_now() < exec->deadline)
+        return 0;
+
+    if (!exec->interrupted) {
+        exec->interrupted = 1;
+        __atomic_add_fetch(&exec->rt->budget_exceeded, 1, __ATOMIC_RELAXED);
+    }
+    return 1;
+}
+
+/*
+ * Bracket every call into JS made on behalf of a request. Time spent
+ * waiting on timers is not charged; only the calls themselves add up
+ * against exec->budget.
+ */
+void js_exec_enter(js_exec_t *exec) {
+    if (exec->budget == 0)
+        return;
+    exec->entered = js_qjs_now();
+    exec->deadline = exec->entered;
+    if (exec->used < exec->budget)
+        exec->deadline += exec->budget - exec->used;
+}
+
+void js_exec_leave(js_exec_t *exec) {
+    if (exec->deadline == 0)
+        return;
+    exec->used += js_qjs_now() - exec->entered;
+    exec->deadline = 0;
+}
+
+static void js_exec_cancel_timeouts(js_exec_t *exec) {
+    js_engine_t *eng = &js_thread_current->engine;
     js_timeout_t *to = exec->timeouts;
+
     while (to) {
         js_timeout_t *next = to->next;
         js_timer_delete(&eng->timers, &to->timer);
@@ -255,77 +750,502 @@ void js_pending_finish(js_exec_t *exec) {
         to = next;
     }
     exec->timeouts = NULL;
+}
 
-    /* serialize response into conn write buffer */
-    js_http_serialize_response(&exec->resp, &conn->wbuf, conn->keep_alive);
+/* drop the request's timers and answer for it */
+static void js_exec_abort(js_exec_t *exec, int status) {
+    const char *text = js_http_status_text(status);
+
+    js_exec_cancel_timeouts(exec);
     js_http_response_free(&exec->resp);
+    exec->resp.status = status;
+    exec->resp.body = strdup(text);
+    exec->resp.body_len = strlen(text);
+    exec->resolved = 1;
+}
 
-    /* resume the connection for writing */
-    conn->state = JS_CONN_WRITING;
-    js_epoll_add(&eng->epoll, conn->event.fd, EPOLLOUT, &conn->event);
+/*
+ * A request that ran out of JS time or memory is answered by C, whatever
+ * JS returned or caught. Returns 1 if the request was aborted.
+ */
+int js_exec_enforce_limits(js_exec_t *exec) {
+    if (exec->interrupted)
+        js_exec_abort(exec, exec->budget_status);
+    else if (exec->oom)
+        js_exec_abort(exec, 500);
+    else
+        return 0;
+    return 1;
+}
 
-    /* cleanup JS state */
-    js_route_free_all(exec->routes, exec->qctx);
-    JS_FreeContext(exec->qctx);
-    JS_FreeRuntime(exec->qrt);
-    free(exec);
+/* fold the request's heap peak into its route's mock.stats() figures */
+static void js_exec_account(js_exec_t *exec) {
+    js_route_t *r = exec->route;
+    if (!r)
+        return;
+    if (!r->shared)
+        r->shared = js_route_find(exec->rt->routes, r->method, r->pattern);
+    if (!r->shared)
+        return;     /* registered outside startup evaluation */
+
+    js_route_stats_t *st = &r->shared->stats;
+    uint64_t peak = exec->heap_peak;
+    uint64_t max = __atomic_load_n(&st->heap_peak, __ATOMIC_RELAXED);
+
+    __atomic_add_fetch(&st->requests, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&st->heap_total, peak, __ATOMIC_RELAXED);
+    while (peak > max
+           && !__atomic_compare_exchange_n(&st->heap_peak, &max, peak, 1,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
 }
 
-int js_qjs_handle_request(js_runtime_t *rt,
-                          js_http_request_t *req, js_http_response_t *resp,
-                          js_conn_t *conn) {
-    JSRuntime *qrt = JS_NewRuntime();
-    JSContext *qctx = JS_NewContext(qrt);
-    JS_SetModuleLoaderFunc(qrt, js_module_normalize, js_module_loader, NULL);
-
-    js_exec_t exec = {
-        .rt = rt,
-        .routes = NULL,
-        .qrt = qrt,
-        .qctx = qctx,
-        .conn = NULL,
-        .resp = {0},
-        .resolved = 0,
-        .timeouts = NULL,
-    };
+/*
+ * Create an exec: QuickJS runtime + context, Web API bindings, and the
+ * module evaluated from the startup bytecode. Returns NULL if any step
+ * fails; the caller answers with a 500.
+ */
+js_exec_t *js_exec_create(js_runtime_t *rt) {
+    js_exec_t *exec = calloc(1, sizeof(*exec));
+    if (!exec)
+        return NULL;
+
+    exec->rt = rt;
+    exec->body_wait[0] = exec->body_wait[1] = JS_UNDEFINED;
+    exec->out_src = exec->out_next = JS_UNDEFINED;
+    js_buf_init(&exec->out_buf);
+
+    /*
+     * Request isolation throws the runtime away after one request, so it
+     * lives in an arena and teardown becomes a bulk reset. Thread-mode
+     * runtimes are long-lived and stay on the system allocator.
+     */
+    js_arena_init(&exec->arena);
+    if (rt->isolation == JS_ISOLATION_REQUEST)
+        exec->qrt = JS_NewRuntime2(&js_qjs_arena_mf, exec);
+    else
+        exec->qrt = JS_NewRuntime2(&js_qjs_sys_mf, exec);
+    if (!exec->qrt) {
+        js_arena_destroy(&exec->arena);
+        free(exec);
+        return NULL;
+    }
+    if (rt->memory_limit > 0)
+        JS_SetMemoryLimit(exec->qrt, rt->memory_limit);
+    if (rt->gc_threshold > 0)
+        JS_SetGCThreshold(exec->qrt, rt->gc_threshold);
+
+    exec->qctx = JS_NewContext(exec->qrt);
+    if (!exec->qctx) {
+        JS_FreeRuntime(exec->qrt);
+        js_arena_destroy(&exec->arena);
+        free(exec);
+        return NULL;
+    }
+    JS_SetModuleLoaderFunc(exec->qrt, js_module_normalize, js_module_loader,
+                           rt);
+
+    /*
+     * Top-level code is not budgeted: heavy setup is what it is for.
+     * Handlers get their route's budget, see js_qjs_handle_request().
+     */
+    exec->budget = 0;
+    exec->budget_status = rt->budget_status;
+    JS_SetInterruptHandler(exec->qrt, js_qjs_interrupt, exec);
 
     /* register Web API bindings */
-    js_web_init(&exec);
+    js_web_init(exec);
 
     /* load pre-compiled bytecode (compiled once at startup) */
-    JSValue obj = JS_ReadObject(qctx, rt->bytecode, rt->bytecode_len,
+    JSValue obj = JS_ReadObject(exec->qctx, rt->bytecode, rt->bytecode_len,
                                 JS_READ_OBJ_BYTECODE);
     if (JS_IsException(obj)) goto fail;
 
     /* resolve imported modules before evaluation */
-    if (JS_ResolveModule(qctx, obj) < 0) {
-        JS_FreeValue(qctx, obj);
+    if (JS_ResolveModule(exec->qctx, obj) < 0) {
+        JS_FreeValue(exec->qctx, obj);
         goto fail;
     }
 
-    JSValue result = JS_EvalFunction(qctx, obj);
+    JSValue result = JS_EvalFunction(exec->qctx, obj);
     if (JS_IsException(result)) {
-        JS_FreeValue(qctx, result);
+        JS_FreeValue(exec->qctx, result);
         goto fail;
     }
-    JS_FreeValue(qctx, result);
+    JS_FreeValue(exec->qctx, result);
 
     /* drain pending jobs (for async module evaluation) */
     JSContext *pctx;
-    while (JS_ExecutePendingJob(qrt, &pctx) > 0)
+    while (JS_ExecutePendingJob(exec->qrt, &pctx) > 0)
         ;
+    exec->loaded = 1;
+
+    if (exec->oom) {
+        fprintf(stderr, "error: module evaluation exceeded the %zu byte "
+                "memory limit\n", rt->memory_limit);
+        js_exec_free(exec);
+        return NULL;
+    }
+
+    return exec;
+
+fail:
+    js_qjs_dump_error(exec->qctx);
+    js_exec_free(exec);
+    return NULL;
+}
+
+void js_exec_free(js_exec_t *exec) {
+    /* cancel any outstanding timers */
+    js_exec_cancel_timeouts(exec);
+    js_web_body_detach(exec);
+    JS_FreeValue(exec->qctx, exec->out_src);
+    JS_FreeValue(exec->qctx, exec->out_next);
+    js_buf_free(&exec->out_buf);
+
+    js_http_response_free(&exec->resp);
+    js_route_free_all(exec->routes, exec->qctx);
+
+    /*
+     * Finalizers still run, but the arena drops the individual frees and
+     * js_arena_destroy() releases the memory in one step.
+     */
+    exec->arena.closing = 1;
+    JS_FreeContext(exec->qctx);
+    JS_FreeRuntime(exec->qrt);
+    js_arena_destroy(&exec->arena);
+    free(exec);
+}
+
+/* ---- streamed responses ---- */
+
+/*
+ * A Response whose body is a ReadableStream or async iterable is pulled a
+ * chunk at a time. Inline, chunks go straight to the connection, which
+ * asks for the next one as its write buffer drains. A worker cannot touch
+ * the connection, so it collects the body and sends the response whole.
+ */
+
+static void js_qjs_out_read(js_exec_t *exec);
+
+static void js_qjs_out_close(js_exec_t *exec) {
+    exec->out_state = JS_OUT_ENDED;
+    JS_FreeValue(exec->qctx, exec->out_src);
+    JS_FreeValue(exec->qctx, exec->out_next);
+    exec->out_src = exec->out_next = JS_UNDEFINED;
+}
+
+/* the body is complete (ok) or cut short */
+static void js_qjs_out_end(js_exec_t *exec, int ok) {
+    js_qjs_out_close(exec);
+
+    if (exec->out_conn) {
+        js_http_stream_end(exec->out_conn, exec, ok);
+        exec->out_conn = NULL;
+        return;
+    }
+
+    if (ok) {
+        exec->resp.body = exec->out_buf.data;
+        exec->resp.body_len = exec->out_buf.len;
+        js_buf_init(&exec->out_buf);
+        return;
+    }
+    js_buf_free(&exec->out_buf);
+    if (exec->interrupted || exec->oom)
+        return;     /* js_exec_abort() answered already */
+    js_http_response_free(&exec->resp);
+    exec->resp.status = 500;
+    exec->resp.body = strdup("Internal Server Error");
+    exec->resp.body_len = 21;
+}
+
+/* returns: 1 = want the next chunk now, 0 = wait for the drain, -1 = error */
+static int js_qjs_out_write(js_exec_t *exec, JSValueConst value) {
+    JSContext *ctx = exec->qctx;
+    const char *str;
+    size_t len;
+    int rc;
+
+    const uint8_t *data = js_web_chunk(ctx, value, &len, &str);
+    if (!data)
+        return -1;
+    if (exec->out_conn)
+        rc = js_http_stream_send(exec->out_conn, (const char *) data, len);
+    else
+        rc = js_buf_append(&exec->out_buf, (const char *) data, len) < 0
+             ? -1 : 1;
+    if (str)
+        JS_FreeCString(ctx, str);
+    return rc;
+}
+
+static JSValue js_qjs_out_on_chunk(JSContext *ctx, JSValueConst this_val,
+                                   int argc, JSValueConst *argv) {
+    (void)this_val;
+    js_exec_t *exec = JS_GetContextOpaque(ctx);
+
+    exec->out_reading = 0;
+    if (exec->out_state != JS_OUT_ACTIVE)
+        return JS_UNDEFINED;
+    if (argc < 1 || !JS_IsObject(argv[0])) {
+        js_qjs_out_end(exec, 0);
+        return JS_UNDEFINED;
+    }
+
+    JSValue done = JS_GetPropertyStr(ctx, argv[0], "done");
+    int finished = JS_ToBool(ctx, done);
+    JS_FreeValue(ctx, done);
+    if (finished) {
+        js_qjs_out_end(exec, 1);
+        return JS_UNDEFINED;
+    }
+
+    JSValue value = JS_GetPropertyStr(ctx, argv[0], "value");
+    int rc = js_qjs_out_write(exec, value);
+    JS_FreeValue(ctx, value);
+    if (rc < 0)
+        js_qjs_out_end(exec, 0);
+    else if (rc > 0)
+        js_qjs_out_read(exec);
+    return JS_UNDEFINED;
+}
+
+static JSValue js_qjs_out_on_error(JSContext *ctx, JSValueConst this_val,
+                                   int argc, JSValueConst *argv) {
+    (void)this_val; (void)argc; (void)argv;
+    js_exec_t *exec = JS_GetContextOpaque(ctx);
+
+    exec->out_reading = 0;
+    if (exec->out_state == JS_OUT_ACTIVE)
+        js_qjs_out_end(exec, 0);
+    return JS_UNDEFINED;
+}
+
+/* ask the source for its next { value, done }; answered by a later job */
+static void js_qjs_out_read(js_exec_t *exec) {
+    JSContext *ctx = exec->qctx;
+
+    JSValue ret = JS_Call(ctx, exec->out_next, exec->out_src, 0, NULL);
+    if (JS_IsException(ret)) {
+        JS_FreeValue(ctx, JS_GetException(ctx));
+        js_qjs_out_end(exec, 0);
+        return;
+    }
+
+    JSValue on_chunk = JS_NewCFunction(ctx, js_qjs_out_on_chunk, "onChunk", 1);
+    JSValue on_error = JS_NewCFunction(ctx, js_qjs_out_on_error, "onError", 1);
+    JSValue args[2] = { on_chunk, on_error };
+
+    /* plain results from a hand-written iterator go through a promise too */
+    if ((int) JS_PromiseState(ctx, ret) < 0) {
+        JSValue global = JS_GetGlobalObject(ctx);
+        JSValue promise_ctor = JS_GetPropertyStr(ctx, global, "Promise");
+        JSAtom resolve = JS_NewAtom(ctx, "resolve");
+        JSValue p = JS_Invoke(ctx, promise_ctor, resolve, 1, &ret);
+        JS_FreeAtom(ctx, resolve);
+        JS_FreeValue(ctx, promise_ctor);
+        JS_FreeValue(ctx, global);
+        JS_FreeValue(ctx, ret);
+        ret = p;
+    }
+
+    JSAtom then = JS_NewAtom(ctx, "then");
+    JSValue then_result = JS_Invoke(ctx, ret, then, 2, args);
+    JS_FreeAtom(ctx, then);
+    JS_FreeValue(ctx, on_chunk);
+    JS_FreeValue(ctx, on_error);
+    JS_FreeValue(ctx, ret);
+    if (JS_IsException(then_result)) {
+        JS_FreeValue(ctx, JS_GetException(ctx));
+        js_qjs_out_end(exec, 0);
+        return;
+    }
+    JS_FreeValue(ctx, then_result);
+    exec->out_reading = 1;
+}
+
+/* the handler's Response; a stream body is pulled from here on */
+static void js_qjs_take_response(js_exec_t *exec, JSValueConst val) {
+    JSContext *ctx = exec->qctx;
+    JSValue src, next;
+
+    /* not a Response: no status to send, answer 500 */
+    int rc = js_web_read_response(ctx, val, &exec->resp);
+    if (rc == 0)
+        rc = js_web_response_stream(ctx, val, &src, &next);
+    if (rc == 0)
+        return;
+    if (rc < 0) {
+        JS_FreeValue(ctx, JS_GetException(ctx));
+        js_http_response_free(&exec->resp);
+        exec->resp.status = 500;
+        exec->resp.body = strdup("Internal Server Error");
+        exec->resp.body_len = 21;
+        return;
+    }
+
+    exec->out_src = src;
+    exec->out_next = next;
+    exec->out_state = JS_OUT_ACTIVE;
+
+    /* nothing waits on a worker's connection: start collecting now */
+    if (exec->job)
+        js_qjs_out_read(exec);
+}
+
+/* the connection drained: read the next chunk unless one is on its way */
+void js_qjs_stream_pull(js_exec_t *exec) {
+    JSContext *pctx;
+
+    if (exec->out_state != JS_OUT_ACTIVE || exec->out_reading)
+        return;
+
+    js_exec_enter(exec);
+    js_qjs_out_read(exec);
+    while (JS_ExecutePendingJob(exec->qrt, &pctx) > 0)
+        ;
+    js_exec_leave(exec);
+
+    js_exec_try_finish(exec);
+}
+
+/* the client is gone; nothing reads the rest of the body */
+void js_qjs_stream_abort(js_exec_t *exec) {
+    exec->out_conn = NULL;
+
+    /* the answer to a read in flight would land in a recycled exec */
+    if (exec->out_reading) {
+        js_exec_free(exec);
+        return;
+    }
+    js_qjs_out_close(exec);
+    js_pool_put(&js_thread_current->pool, exec);
+}
+
+/* ---- async lifecycle ---- */
+
+void js_pending_finish(js_exec_t *exec) {
+    js_conn_t *conn = exec->conn;
+    js_job_t *job = exec->job;
+
+    js_exec_account(exec);
+    js_web_body_detach(exec);
+
+    /* on a worker the connection belongs to an I/O thread: hand it back */
+    if (job) {
+        job->resp = exec->resp;
+        memset(&exec->resp, 0, sizeof(exec->resp));
+        js_pool_put(&js_thread_current->pool, exec);
+        js_worker_done(job);
+        return;
+    }
+
+    /* a streamed body: the head goes out now, the exec feeds the rest */
+    if (exec->out_state == JS_OUT_ACTIVE) {
+        js_http_response_t resp = exec->resp;
+        memset(&exec->resp, 0, sizeof(exec->resp));
+        resp.stream = exec;
+        exec->conn = NULL;
+        exec->out_conn = conn;
+        js_http_reply(exec->reply, &resp);
+        return;
+    }
+
+    /* queue the response in order and resume the connection */
+    js_http_reply(exec->reply, &exec->resp);
+
+    /* hand the JS state back to the thread's pool */
+    js_pool_put(&js_thread_current->pool, exec);
+}
+
+/*
+ * JS ran outside the handler call (a timer, request body bytes, the
+ * response stream): finish what the request is no longer waiting for.
+ */
+void js_exec_try_finish(js_exec_t *exec) {
+    if (js_exec_enforce_limits(exec) && exec->out_state == JS_OUT_ACTIVE)
+        js_qjs_out_end(exec, 0);
+
+    /* the response went out already; the exec only fed its body */
+    if (!exec->conn) {
+        if (exec->out_state == JS_OUT_ENDED)
+            js_pool_put(&js_thread_current->pool, exec);
+        return;
+    }
+
+    if (!exec->resolved)
+        return;
+    if (exec->out_state == JS_OUT_ACTIVE) {
+        /* inline the head need not wait; a worker collects the body first */
+        if (!exec->job)
+            js_pending_finish(exec);
+        return;
+    }
+    if (exec->timeouts == NULL)
+        js_pending_finish(exec);
+}
+
+/*
+ * The streamed body of a deferred request moved on (bytes, end of body
+ * or a lost connection): settle the read JS is waiting on, and finish
+ * the request if that was all it was waiting for.
+ */
+void js_qjs_body_wake(js_exec_t *exec) {
+    JSContext *pctx;
+
+    js_exec_enter(exec);
+    js_web_body_settle(exec);
+    while (JS_ExecutePendingJob(exec->qrt, &pctx) > 0)
+        ;
+    js_exec_leave(exec);
+
+    js_exec_try_finish(exec);
+}
+
+int js_qjs_handle_request(js_runtime_t *rt,
+                          js_http_request_t *req, js_http_response_t *resp,
+                          js_conn_t *conn, js_job_t *job) {
+    js_pool_t *pool = &js_thread_current->pool;
+    js_exec_t *exec = js_pool_get(pool, rt);
+    if (!exec) {
+        resp->status = 500;
+        resp->body = strdup("Internal Server Error");
+        resp->body_len = 21;
+        return 0;
+    }
+    exec->job = job;    /* where a streamed body goes, see take_response */
+    exec->reply = req->reply;
+
+    JSRuntime *qrt = exec->qrt;
+    JSContext *qctx = exec->qctx;
+    JSContext *pctx;
 
     /* match route */
     js_route_match_t match = {0};
-    if (!js_route_match(exec.routes, req->method, req->path, &match)) {
-        exec.resp.status = 404;
-        exec.resp.body = strdup("Not Found");
-        exec.resp.body_len = 9;
-        exec.resolved = 1;
+    if (!js_route_match(exec->routes, req->method, req->path, &match)) {
+        exec->resp.status = 404;
+        exec->resp.body = strdup("Not Found");
+        exec->resp.body_len = 9;
+        exec->resolved = 1;
         goto done;
     }
 
+    /* a route may tighten or relax the global budget */
+    js_route_t *route = match.route;
+    exec->budget = (js_nsec_t) (route->budget ? route->budget : rt->budget)
+                   * 1000000;
+    exec->budget_status = route->budget_status ? route->budget_status
+                                               : rt->budget_status;
+    exec->used = 0;
+    exec->route = route;
+    exec->heap_peak = exec->heap;
+    exec->body = req->stream;
+    if (req->stream)
+        req->stream->exec = exec;
+
     /* build JS Request object and call handler */
+    js_exec_enter(exec);
     JSValue js_req = js_web_new_request(qctx, req,
                                         match.params, match.param_count);
     JSValue handler_result = JS_Call(qctx, match.route->handler,
@@ -342,6 +1262,11 @@ int js_qjs_handle_request(js_runtime_t *rt,
     while (JS_ExecutePendingJob(qrt, &pctx) > 0)
         ;
 
+    if (exec->interrupted || exec->oom) {
+        JS_FreeValue(qctx, handler_result);
+        goto done;
+    }
+
     /* check if result is a Promise */
     JSPromiseStateEnum state = JS_PromiseState(qctx, handler_result);
 
@@ -349,9 +1274,9 @@ int js_qjs_handle_request(js_runtime_t *rt,
         /* already resolved — extract result synchronously */
         JSValue resolved_val = JS_PromiseResult(qctx, handler_result);
         JS_FreeValue(qctx, handler_result);
-        js_web_read_response(qctx, resolved_val, &exec.resp);
+        js_qjs_take_response(exec, resolved_val);
         JS_FreeValue(qctx, resolved_val);
-        exec.resolved = 1;
+        exec->resolved = 1;
         goto done;
 
     } else if (state == JS_PROMISE_REJECTED) {
@@ -376,7 +1301,7 @@ int js_qjs_handle_request(js_runtime_t *rt,
         while (JS_ExecutePendingJob(qrt, &pctx) > 0)
             ;
 
-        if (exec.resolved)
+        if (exec->resolved || exec->interrupted || exec->oom)
             goto done;
 
         /* truly async — not yet resolved */
@@ -384,36 +1309,51 @@ int js_qjs_handle_request(js_runtime_t *rt,
 
     } else {
         /* not a Promise — sync path (plain Response object) */
-        js_web_read_response(qctx, handler_result, &exec.resp);
+        js_qjs_take_response(exec, handler_result);
         JS_FreeValue(qctx, handler_result);
-        exec.resolved = 1;
+        exec->resolved = 1;
         goto done;
     }
 
 fail:
-    exec.resp.status = 500;
-    exec.resp.body = strdup("Internal Server Error");
-    exec.resp.body_len = 21;
-    exec.resolved = 1;
+    js_http_response_free(&exec->resp);
+    exec->resp.status = 500;
+    exec->resp.body = strdup("Internal Server Error");
+    exec->resp.body_len = 21;
+    exec->resolved = 1;
     /* fall through to done */
 
 done:
-    if (exec.timeouts != NULL)
+    /* a worker collects a streamed body: take what is ready already */
+    if (exec->out_state == JS_OUT_ACTIVE && job)
+        while (JS_ExecutePendingJob(qrt, &pctx) > 0)
+            ;
+    js_exec_leave(exec);
+    if (js_exec_enforce_limits(exec) && exec->out_state == JS_OUT_ACTIVE)
+        js_qjs_out_end(exec, 0);
+
+    /* inline, a streamed body does not wait for timers: they feed it */
+    if (exec->out_state == JS_OUT_ACTIVE ? job != NULL
+                                         : exec->timeouts != NULL)
         goto deferred;
 
-    *resp = exec.resp;
-    memset(&exec.resp, 0, sizeof(exec.resp));
-    js_route_free_all(exec.routes, qctx);
-    JS_FreeContext(qctx);
-    JS_FreeRuntime(qrt);
+    js_exec_account(exec);
+    js_web_body_detach(exec);
+
+    *resp = exec->resp;
+    memset(&exec->resp, 0, sizeof(exec->resp));
+    if (exec->out_state == JS_OUT_ACTIVE) {
+        /* the caller sends the head, then js_qjs_stream_pull() the body */
+        resp->stream = exec;
+        exec->out_conn = conn;
+        return 0;
+    }
+    js_pool_put(pool, exec);
     return 0;
 
 deferred:
-    {
-        js_exec_t *heap_exec = malloc(sizeof(*heap_exec));
-        *heap_exec = exec;
-        heap_exec->conn = conn;
-        JS_SetContextOpaque(qctx, heap_exec);
-        return 1;
-    }
+    js_exec_leave(exec);
+    exec->conn = conn;
+    exec->job = job;
+    return 1;
 }
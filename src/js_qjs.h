@@ -3,21 +3,70 @@
 
 /* forward declarations */
 struct js_runtime_s;
+struct js_job_s;
 
 /* ---- struct ---- */
 
+typedef enum {
+    JS_ISOLATION_REQUEST,   /* fresh runtime per request (default) */
+    JS_ISOLATION_THREAD     /* runtimes recycled within a worker thread */
+} js_isolation_t;
+
 typedef struct js_timeout_s js_timeout_t;
 
-typedef struct {
+/* response body read from a ReadableStream or async iterable */
+typedef enum {
+    JS_OUT_NONE,        /* body, if any, is in resp */
+    JS_OUT_ACTIVE,      /* chunks are being pulled */
+    JS_OUT_ENDED
+} js_out_state_t;
+
+typedef struct js_module_s {
+    char                *name;          /* resolved module path */
+    uint8_t             *bytecode;      /* compiled once at startup */
+    size_t               bytecode_len;
+    struct js_module_s  *next;
+} js_module_t;
+
+typedef struct js_exec_s {
     struct js_runtime_s *rt;       /* back pointer to global runtime */
-    js_route_t          *routes;   /* per-request route list */
+    js_route_t          *routes;   /* routes registered by the module */
     JSRuntime           *qrt;      /* QuickJS runtime */
     JSContext           *qctx;     /* QuickJS context */
+    js_arena_t           arena;    /* backs qrt in request isolation */
+    struct js_exec_s    *next;     /* idle list in js_pool_t */
     /* async support */
     js_conn_t           *conn;     /* NULL for sync */
+    js_http_reply_t     *reply;    /* inline: its place in conn's queue */
+    struct js_job_s     *job;      /* set when running on a worker thread */
     js_http_response_t   resp;     /* filled by .then() callback */
     int                  resolved; /* 1 = .then() invoked */
     js_timeout_t        *timeouts; /* linked list of pending timers */
+    /* JS time budget, see js_exec_enter() */
+    js_nsec_t            budget;   /* JS time allowed per request, 0 = off */
+    js_nsec_t            used;     /* JS time spent on this request */
+    js_nsec_t            entered;  /* monotonic, start of the current call */
+    js_nsec_t            deadline; /* monotonic, 0 = not running JS */
+    int                  budget_status;
+    int                  interrupted; /* budget fired; never recycled */
+    /* heap accounting, kept by the allocator hooks */
+    size_t               heap;      /* bytes held by qrt */
+    size_t               heap_peak; /* high-water mark of this request */
+    int                  oom;       /* memory limit refused; never recycled */
+    js_route_t          *route;     /* route of the request in flight */
+    int                  loaded;    /* module evaluated, handlers run now */
+    /* streamed request body, see js_web_body_settle() */
+    js_body_t           *body;      /* NULL = buffered body */
+    JSValue              body_wait[2]; /* resolve/reject of a pending read */
+    int                  body_wait_kind;
+    js_buf_t             body_text; /* text()/json() collected so far */
+    /* streamed response body, see js_qjs_stream_pull() */
+    js_out_state_t       out_state;
+    JSValue              out_src;   /* reader or async iterator */
+    JSValue              out_next;  /* its read() or next() */
+    int                  out_reading; /* a read is in flight */
+    js_conn_t           *out_conn;  /* inline: chunks go here */
+    js_buf_t             out_buf;   /* worker: the body collected */
 } js_exec_t;
 
 struct js_timeout_s {
@@ -29,14 +78,24 @@ struct js_timeout_s {
 
 /* ---- api ---- */
 
-int  js_qjs_compile(const char *filename, uint8_t **out_buf, size_t *out_len);
-int  js_qjs_read_config(const char *script_path, uint8_t *bytecode, size_t len,
-                        char **host, int *port);
+int  js_qjs_compile(struct js_runtime_s *rt);
+int  js_qjs_read_config(struct js_runtime_s *rt);
 int  js_qjs_handle_request(struct js_runtime_s *rt,
                            js_http_request_t *req, js_http_response_t *resp,
-                           js_conn_t *conn);
+                           js_conn_t *conn, struct js_job_s *job);
 /* returns: 0=sync (response in *resp), 1=async (response sent later) */
 
+js_exec_t *js_exec_create(struct js_runtime_s *rt);
+void       js_exec_free(js_exec_t *exec);
+
+void js_exec_enter(js_exec_t *exec);
+void js_exec_leave(js_exec_t *exec);
+int  js_exec_enforce_limits(js_exec_t *exec);
+
 void js_pending_finish(js_exec_t *exec);
+void js_exec_try_finish(js_exec_t *exec);
+void js_qjs_body_wake(js_exec_t *exec);
+void js_qjs_stream_pull(js_exec_t *exec);
+void js_qjs_stream_abort(js_exec_t *exec);
 
 #endif
@@ -18,9 +18,11 @@ static int js_route_parse(const char *pattern, js_segment_t **out, int *count) {
         js_segment_t *seg = &(*out)[*count];
         if (*p == ':') {
             seg->str = strndup(p + 1, len - 1);
+            seg->len = len - 1;
             seg->is_param = 1;
         } else {
             seg->str = strndup(p, len);
+            seg->len = len;
             seg->is_param = 0;
         }
         (*count)++;
@@ -46,6 +48,9 @@ js_route_t *js_route_add(js_route_t **head, js_http_method_t method,
         return NULL;
     }
 
+    for (int i = 0; i < r->segment_count; i++)
+        r->param_count += r->segments[i].is_param;
+
     /* append to end of list */
     js_route_t **pp = head;
     while (*pp) pp = &(*pp)->next;
@@ -55,60 +60,82 @@ js_route_t *js_route_add(js_route_t **head, js_http_method_t method,
     return r;
 }
 
-int js_route_match(js_route_t *head, js_http_method_t method,
-                   const char *path, js_route_match_t *result) {
-    /* split path into segments */
-    js_segment_t *path_segs = NULL;
-    int path_count = 0;
-    js_route_parse(path, &path_segs, &path_count);
+/* exact lookup by registration, not by request path */
+js_route_t *js_route_find(js_route_t *head, js_http_method_t method,
+                          const char *pattern) {
+    for (js_route_t *r = head; r; r = r->next) {
+        if (r->method == method && strcmp(r->pattern, pattern) == 0)
+            return r;
+    }
+    return NULL;
+}
+
+/*
+ * Walk the request path against the route's compiled segments in place,
+ * splitting on '/' exactly like js_route_parse(). When params is non-NULL
+ * the :param values are copied out; only done once a route has matched,
+ * so rejected routes cost no allocation.
+ */
+static int js_route_match_path(js_route_t *r, const char *path,
+                               js_param_t *params) {
+    const char *p = path;
+    if (*p == '/') p++;
 
+    int i = 0, n = 0;
+    while (*p) {
+        const char *slash = strchr(p, '/');
+        size_t len = slash ? (size_t)(slash - p) : strlen(p);
+
+        if (i >= r->segment_count)
+            return 0;
+
+        js_segment_t *seg = &r->segments[i++];
+        if (seg->is_param) {
+            if (params) {
+                params[n].name = strdup(seg->str);
+                params[n].value = strndup(p, len);
+                n++;
+            }
+        } else if (seg->len != len || memcmp(seg->str, p, len) != 0) {
+            return 0;
+        }
+
+        if (!slash) break;
+        p = slash + 1;
+    }
+
+    return i == r->segment_count;
+}
+
+/* the route a request goes to, without copying its params out */
+js_route_t *js_route_lookup(js_route_t *head, js_http_method_t method,
+                            const char *path) {
     for (js_route_t *r = head; r; r = r->next) {
         /* check method */
         if (r->method != JS_HTTP_ALL && r->method != method)
             continue;
-        /* check segment count */
-        if (r->segment_count != path_count)
-            continue;
 
-        /* match each segment */
-        int matched = 1;
-        int param_count = 0;
-        js_param_t *params = NULL;
-
-        for (int i = 0; i < r->segment_count; i++) {
-            if (r->segments[i].is_param) {
-                params = realloc(params, sizeof(js_param_t) * (param_count + 1));
-                params[param_count].name = strdup(r->segments[i].str);
-                params[param_count].value = strdup(path_segs[i].str);
-                param_count++;
-            } else if (strcmp(r->segments[i].str, path_segs[i].str) != 0) {
-                matched = 0;
-                break;
-            }
-        }
+        if (js_route_match_path(r, path, NULL))
+            return r;
+    }
 
-        if (matched) {
-            result->route = r;
-            result->params = params;
-            result->param_count = param_count;
-            /* free path segments */
-            for (int i = 0; i < path_count; i++) free(path_segs[i].str);
-            free(path_segs);
-            return 1;
-        }
+    return NULL;
+}
 
-        /* free params on mismatch */
-        for (int i = 0; i < param_count; i++) {
-            free(params[i].name);
-            free(params[i].value);
-        }
-        free(params);
+int js_route_match(js_route_t *head, js_http_method_t method,
+                   const char *path, js_route_match_t *result) {
+    js_route_t *r = js_route_lookup(head, method, path);
+    if (!r)
+        return 0;
+
+    result->route = r;
+    result->params = NULL;
+    result->param_count = r->param_count;
+    if (r->param_count > 0) {
+        result->params = calloc(r->param_count, sizeof(js_param_t));
+        js_route_match_path(r, path, result->params);
     }
-
-    /* free path segments */
-    for (int i = 0; i < path_count; i++) free(path_segs[i].str);
-    free(path_segs);
-    return 0;
+    return 1;
 }
 
 void js_route_match_free(js_route_match_t *match) {
@@ -129,6 +156,8 @@ void js_route_free_all(js_route_t *head, JSContext *ctx) {
             free(head->segments[i].str);
         free(head->segments);
         JS_FreeValue(ctx, head->handler);
+        if (head->static_resp)
+            js_http_static_free(head->static_resp);
         free(head);
         head = next;
     }
@@ -9,16 +9,35 @@ typedef struct {
 } js_param_t;
 
 typedef struct {
-    char *str;       /* literal text or param name (without ':') */
-    int   is_param;  /* 0 = literal, 1 = :param */
+    char   *str;       /* literal text or param name (without ':') */
+    size_t  len;
+    int     is_param;  /* 0 = literal, 1 = :param */
 } js_segment_t;
 
+/* per-route figures for mock.stats(), updated atomically by all threads */
+typedef struct {
+    uint64_t  requests;
+    uint64_t  heap_total;   /* sum of per-request heap peaks */
+    uint64_t  heap_peak;    /* largest heap seen by a request */
+} js_route_stats_t;
+
 typedef struct js_route_s {
     js_http_method_t    method;
     char               *pattern;       /* original: "/users/:id" */
     js_segment_t       *segments;
     int                 segment_count;
+    int                 param_count;   /* number of :param segments */
     JSValue             handler;       /* JS function, valid in current context only */
+    js_http_static_t   *static_resp;   /* prebuilt response, served without JS */
+    int                 cache_ttl;     /* ms to memoize responses, 0 = off */
+    int                 budget;        /* ms of JS time, 0 = global budget */
+    int                 budget_status; /* answer when exceeded, 0 = global */
+    int                 stream;        /* body read as it arrives, js_body.h */
+    size_t              stream_spill;  /* bytes queued in memory, 0 = no spill */
+    size_t              stream_limit;  /* max body bytes, 0 = unlimited */
+    int                 stream_limit_set; /* else limits.body applies */
+    js_route_stats_t    stats;         /* on rt->routes only */
+    struct js_route_s  *shared;        /* exec route -> its rt->routes twin */
     struct js_route_s  *next;
 } js_route_t;
 
@@ -32,6 +51,10 @@ typedef struct {
 
 js_route_t *js_route_add(js_route_t **head, js_http_method_t method,
                          const char *pattern, JSValue handler);
+js_route_t *js_route_find(js_route_t *head, js_http_method_t method,
+                          const char *pattern);
+js_route_t *js_route_lookup(js_route_t *head, js_http_method_t method,
+                            const char *path);
 int         js_route_match(js_route_t *head, js_http_method_t method,
                            const char *path, js_route_match_t *result);
 void        js_route_match_free(js_route_match_t *match);
@@ -3,8 +3,18 @@
 int js_runtime_init(js_runtime_t *rt) {
     memset(rt, 0, sizeof(*rt));
     rt->lfd = -1;
+    rt->port = 3000; /* default port */
+    rt->isolation = JS_ISOLATION_REQUEST;
+    rt->pool_size = 4;
+    rt->thread_count = 4;
+    rt->budget = 5000;
+    rt->budget_status = 503;
+    rt->memory_limit = 256 * 1024 * 1024;
+    rt->body_limit = 16 * 1024 * 1024;
     if (js_store_init(&rt->store, 64) < 0)
         return -1;
+    if (js_cache_init(&rt->cache, JS_CACHE_MAX_ENTRIES) < 0)
+        return -1;
     return 0;
 }
 
@@ -41,9 +51,18 @@ int js_runtime_listen(js_runtime_t *rt) {
 
 void js_runtime_free(js_runtime_t *rt) {
     /* free threads */
-    for (int i = 0; i < rt->thread_count; i++)
+    for (int i = 0; rt->threads && i < rt->thread_count; i++) {
+        if (rt->threads[i])
+            js_jobq_free(&rt->threads[i]->jobs);
         free(rt->threads[i]);
+    }
     free(rt->threads);
+    for (int i = 0; rt->workers && i < rt->worker_count; i++) {
+        if (rt->workers[i])
+            js_jobq_free(&rt->workers[i]->jobs);
+        free(rt->workers[i]);
+    }
+    free(rt->workers);
 
     /* close listen fd */
     if (rt->lfd >= 0)
@@ -52,8 +71,23 @@ void js_runtime_free(js_runtime_t *rt) {
     /* free store */
     js_store_free(&rt->store);
 
-    /* free bytecode */
-    free(rt->bytecode);
+    /* free bytecode, unless it lives in the embedded bundle's mapping */
+    if (!rt->bundle_map)
+        free(rt->bytecode);
+    while (rt->modules) {
+        js_module_t *next = rt->modules->next;
+        free(rt->modules->name);
+        if (!rt->bundle_map)
+            free(rt->modules->bytecode);
+        free(rt->modules);
+        rt->modules = next;
+    }
+    if (rt->bundle_map)
+        munmap(rt->bundle_map, rt->bundle_map_len);
+    js_route_free_all(rt->static_routes, NULL);
+    js_route_free_all(rt->routes, NULL);
+    js_cache_free(&rt->cache);
+    free(rt->script_path);
     free(rt->host);
 
     memset(rt, 0, sizeof(*rt));
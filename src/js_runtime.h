@@ -6,13 +6,34 @@
 typedef struct js_runtime_s {
     uint8_t       *bytecode;
     size_t         bytecode_len;
+    js_module_t   *modules;        /* imported modules, bytecode by path */
+    void          *bundle_map;     /* embedded bundle the bytecode is in */
+    size_t         bundle_map_len;
+    js_route_t    *static_routes;  /* constant responses, matched before JS */
+    js_route_t    *routes;         /* handler routes seen at startup (options) */
+    int            cached_routes;  /* routes with a cache ttl */
+    int            stream_routes;  /* routes taking the body as a stream */
+    js_cache_t     cache;          /* memoized responses */
     char          *script_path;    /* original script path for re-compilation */
     char          *host;
     int            port;
+    js_isolation_t isolation;      /* exec reuse policy across requests */
+    int            pool_size;      /* max idle execs kept per thread */
+    int            budget;         /* ms of JS time per request, 0 = off */
+    int            budget_status;  /* answer when a budget is exceeded */
+    uint64_t       budget_exceeded; /* times a budget fired (atomic) */
+    size_t         memory_limit;   /* bytes per exec runtime, 0 = off */
+    size_t         gc_threshold;   /* bytes, 0 = QuickJS default */
+    uint64_t       memory_exceeded; /* times the limit refused (atomic) */
+    size_t         body_limit;     /* max request body bytes, 0 = off */
     int            lfd;            /* listen fd */
+    int            edge;           /* connections use EPOLLET */
+    int            io_uring;       /* event loops use js_uring_t */
     js_store_t     store;
-    js_thread_t  **threads;
+    js_thread_t  **threads;        /* I/O event loops */
     int            thread_count;
+    js_thread_t  **workers;        /* JS executors, see js_worker.h */
+    int            worker_count;   /* 0 = run JS on the I/O threads */
 } js_runtime_t;
 
 /* ---- api ---- */
@@ -0,0 +1,176 @@
+#include "js_main.h"
+
+/* ---- scalar ---- */
+
+static const char *js_scan_any_scalar(const char *p, const char *end,
+                                      const js_scan_set_t *set) {
+    if (set->n == 1)
+        return memchr(p, set->chars[0], end - p);
+
+    for (; p < end; p++) {
+        if (memchr(set->chars, *p, set->n))
+            return p;
+    }
+    return NULL;
+}
+
+static const char *js_scan_head_end_scalar(const char *p, const char *end) {
+    return memmem(p, end - p, "\r\n\r\n", 4);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/* ---- sse4.2: 16 bytes per step ---- */
+
+__attribute__((target("sse4.2")))
+static const char *js_scan_any_sse42(const char *p, const char *end,
+                                     const js_scan_set_t *set) {
+    __m128i s = _mm_loadu_si128((const __m128i *) set->chars);
+
+    for (; end - p >= 16; p += 16) {
+        __m128i b = _mm_loadu_si128((const __m128i *) p);
+        int i = _mm_cmpestri(s, set->n, b, 16,
+                             _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY
+                             | _SIDD_LEAST_SIGNIFICANT);
+        if (i < 16)
+            return p + i;
+    }
+    return js_scan_any_scalar(p, end, set);
+}
+
+__attribute__((target("sse4.2")))
+static const char *js_scan_head_end_sse42(const char *p, const char *end) {
+    __m128i cr = _mm_set1_epi8('\r');
+    __m128i lf = _mm_set1_epi8('\n');
+
+    /* match CR LF CR LF at offsets 0..3 of every lane */
+    for (; end - p >= 16 + 3; p += 16) {
+        __m128i m = _mm_and_si128(
+            _mm_and_si128(
+                _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) p), cr),
+                _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (p + 1)), lf)),
+            _mm_and_si128(
+                _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (p + 2)), cr),
+                _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (p + 3)), lf)));
+        int mask = _mm_movemask_epi8(m);
+        if (mask)
+            return p + __builtin_ctz(mask);
+    }
+    return js_scan_head_end_scalar(p, end);
+}
+
+/* ---- avx2: 32 bytes per step ---- */
+
+__attribute__((target("avx2")))
+static const char *js_scan_any_avx2(const char *p, const char *end,
+                                    const js_scan_set_t *set) {
+    __m256i s[16];
+    for (int i = 0; i < set->n; i++)
+        s[i] = _mm256_set1_epi8(set->chars[i]);
+
+    for (; end - p >= 32; p += 32) {
+        __m256i b = _mm256_loadu_si256((const __m256i *) p);
+        __m256i m = _mm256_cmpeq_epi8(b, s[0]);
+        for (int i = 1; i < set->n; i++)
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi8(b, s[i]));
+        unsigned mask = (unsigned) _mm256_movemask_epi8(m);
+        if (mask)
+            return p + __builtin_ctz(mask);
+    }
+    return js_scan_any_scalar(p, end, set);
+}
+
+__attribute__((target("avx2")))
+static const char *js_scan_head_end_avx2(const char *p, const char *end) {
+    __m256i cr = _mm256_set1_epi8('\r');
+    __m256i lf = _mm256_set1_epi8('\n');
+
+    for (; end - p >= 32 + 3; p += 32) {
+        __m256i m = _mm256_and_si256(
+            _mm256_and_si256(
+                _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) p), cr),
+                _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) (p + 1)), lf)),
+            _mm256_and_si256(
+                _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) (p + 2)), cr),
+                _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) (p + 3)), lf)));
+        unsigned mask = (unsigned) _mm256_movemask_epi8(m);
+        if (mask)
+            return p + __builtin_ctz(mask);
+    }
+    return js_scan_head_end_sse42(p, end);
+}
+
+#endif
+
+/* ---- dispatch ---- */
+
+static const js_scan_impl_t js_scan_impls[] = {
+#if defined(__x86_64__) || defined(__i386__)
+    { "avx2",   js_scan_any_avx2,   js_scan_head_end_avx2 },
+    { "sse4.2", js_scan_any_sse42,  js_scan_head_end_sse42 },
+#endif
+    { "scalar", js_scan_any_scalar, js_scan_head_end_scalar },
+};
+
+/* usable before js_scan_init(), e.g. by `jsmock compile` */
+js_scan_impl_t js_scan_impl = {
+    "scalar", js_scan_any_scalar, js_scan_head_end_scalar
+};
+
+static int js_scan_supported(const char *name) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (strcmp(name, "avx2") == 0)
+        return __builtin_cpu_supports("avx2");
+    if (strcmp(name, "sse4.2") == 0)
+        return __builtin_cpu_supports("sse4.2");
+#endif
+    return strcmp(name, "scalar") == 0;
+}
+
+void js_scan_init(void) {
+    const char *cap = getenv("JSMOCK_SIMD");
+    int allowed = (cap == NULL);
+
+    for (int i = 0; i < js_countof(js_scan_impls); i++) {
+        const js_scan_impl_t *impl = &js_scan_impls[i];
+        if (!allowed && strcmp(impl->name, cap) == 0)
+            allowed = 1;
+        if (allowed && js_scan_supported(impl->name)) {
+            js_scan_impl = *impl;
+            return;
+        }
+    }
+}
+
+/* ---- case-insensitive compare ---- */
+
+/*
+ * Setting bit 0x20 lowercases letters and leaves digits and '-' as they
+ * are, so eight bytes are folded and compared at once. The only other
+ * byte folding onto a token character is a control character, which
+ * never appears in a header name.
+ */
+int js_scan_ieq(const char *s, const char *lower, size_t n) {
+    const uint64_t fold = 0x2020202020202020ULL;
+    uint64_t a, b;
+
+    if (n < 8) {
+        for (size_t i = 0; i < n; i++) {
+            if ((s[i] | 0x20) != lower[i])
+                return 0;
+        }
+        return 1;
+    }
+
+    /* whole words, then one last word overlapping the previous one */
+    for (size_t i = 0; i + 8 <= n; i += 8) {
+        memcpy(&a, s + i, 8);
+        memcpy(&b, lower + i, 8);
+        if ((a | fold) != b)
+            return 0;
+    }
+    memcpy(&a, s + n - 8, 8);
+    memcpy(&b, lower + n - 8, 8);
+    return (a | fold) == b;
+}
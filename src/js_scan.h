@@ -0,0 +1,48 @@
+#ifndef JS_SCAN_H
+#define JS_SCAN_H
+
+/* ---- struct ---- */
+
+/* up to 16 bytes to look for; padded so SIMD code can load it whole */
+typedef struct {
+    char chars[16];
+    int  n;
+} js_scan_set_t;
+
+#define js_scan_set(s)  { s, (int) sizeof(s) - 1 }
+
+typedef struct {
+    const char *name;
+    const char *(*any)(const char *p, const char *end,
+                       const js_scan_set_t *set);
+    const char *(*head_end)(const char *p, const char *end);
+} js_scan_impl_t;
+
+extern js_scan_impl_t js_scan_impl;
+
+/* ---- api ---- */
+
+/* pick the widest implementation the CPU supports (JSMOCK_SIMD caps it) */
+void js_scan_init(void);
+
+/* first byte in [p, end) that is in set, NULL if none */
+static inline const char *
+js_scan_any(const char *p, const char *end, const js_scan_set_t *set)
+{
+    return js_scan_impl.any(p, end, set);
+}
+
+/* first "\r\n\r\n" in [p, end), NULL if none */
+static inline const char *
+js_scan_head_end(const char *p, const char *end)
+{
+    return js_scan_impl.head_end(p, end);
+}
+
+/*
+ * Case-insensitive compare of n bytes of s against lower, which must be
+ * lowercase token characters (letters, digits, '-').
+ */
+int js_scan_ieq(const char *s, const char *lower, size_t n);
+
+#endif /* JS_SCAN_H */
@@ -7,8 +7,18 @@ static unsigned int js_store_hash(const char *key) {
     return h;
 }
 
+/* called with the lock held; readers load it without the lock */
+static void js_store_touch(js_store_t *store) {
+    __atomic_add_fetch(&store->generation, 1, __ATOMIC_RELEASE);
+}
+
+uint64_t js_store_generation(js_store_t *store) {
+    return __atomic_load_n(&store->generation, __ATOMIC_ACQUIRE);
+}
+
 int js_store_init(js_store_t *store, int bucket_count) {
     store->bucket_count = bucket_count;
+    store->generation = 0;
     store->buckets = calloc(bucket_count, sizeof(js_store_entry_t *));
     if (!store->buckets)
         return -1;
@@ -55,6 +65,7 @@ int js_store_set(js_store_t *store, const char *key, const char *value) {
         e->next = store->buckets[idx];
         store->buckets[idx] = e;
     }
+    js_store_touch(store);
     pthread_mutex_unlock(&store->lock);
     return 0;
 }
@@ -70,6 +81,7 @@ int js_store_del(js_store_t *store, const char *key) {
             free(e->key);
             free(e->value);
             free(e);
+            js_store_touch(store);
             pthread_mutex_unlock(&store->lock);
             return 0;
         }
@@ -102,6 +114,7 @@ int js_store_incr(js_store_t *store, const char *key) {
     char buf[32];
     snprintf(buf, sizeof(buf), "%d", val);
     e->value = strdup(buf);
+    js_store_touch(store);
     pthread_mutex_unlock(&store->lock);
     return val;
 }
@@ -119,6 +132,7 @@ void js_store_clear(js_store_t *store) {
         }
         store->buckets[i] = NULL;
     }
+    js_store_touch(store);
     pthread_mutex_unlock(&store->lock);
 }
 
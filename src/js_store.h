@@ -13,6 +13,7 @@ typedef struct {
     js_store_entry_t **buckets;
     int                bucket_count;
     pthread_mutex_t    lock;         /* thread-safe access */
+    uint64_t           generation;   /* bumped on every write */
 } js_store_t;
 
 /* ---- api ---- */
@@ -23,6 +24,7 @@ int   js_store_set(js_store_t *store, const char *key, const char *value);
 int   js_store_del(js_store_t *store, const char *key);
 int   js_store_incr(js_store_t *store, const char *key);
 void  js_store_clear(js_store_t *store);
+uint64_t js_store_generation(js_store_t *store);
 void  js_store_free(js_store_t *store);
 
 #endif
@@ -6,36 +6,100 @@ static void *js_thread_entry(void *arg) {
     js_thread_t *t = arg;
     js_thread_current = t;
 
-    if (js_engine_init(&t->engine, 1024) < 0) {
+    if (js_engine_init(&t->engine, 1024, t->rt->io_uring) < 0) {
         fprintf(stderr, "thread %d: engine init failed\n", t->id);
         return NULL;
     }
 
-    js_listen_start(&t->listen, t->rt->lfd, &t->engine.epoll, js_http_conn_init);
+    /* with workers, I/O threads never run JS and only wait for replies */
+    js_pool_init(&t->pool, t->rt->pool_size);
+    if (t->rt->worker_count > 0) {
+        js_jobq_start(&t->jobs, &t->engine);
+    } else if (t->rt->isolation == JS_ISOLATION_THREAD
+               && js_pool_prewarm(&t->pool, t->rt) < 0)
+    {
+        fprintf(stderr, "thread %d: module evaluation failed\n", t->id);
+    }
+    js_listen_start(&t->listen, t->rt->lfd, &t->engine, js_http_conn_init,
+                    sizeof(js_http_conn_t), t->rt->edge);
+
+    js_engine_run(&t->engine);
+    js_pool_free(&t->pool);
+    js_engine_free(&t->engine);
+    return NULL;
+}
+
+/* JS executor: its own event loop for queued requests and setTimeout */
+static void *js_worker_entry(void *arg) {
+    js_thread_t *t = arg;
+    js_thread_current = t;
+
+    if (js_engine_init(&t->engine, 64, t->rt->io_uring) < 0) {
+        fprintf(stderr, "worker %d: engine init failed\n", t->id);
+        return NULL;
+    }
+
+    js_pool_init(&t->pool, t->rt->pool_size);
+    if (t->rt->isolation == JS_ISOLATION_THREAD
+        && js_pool_prewarm(&t->pool, t->rt) < 0)
+    {
+        fprintf(stderr, "worker %d: module evaluation failed\n", t->id);
+    }
+    js_jobq_start(&t->jobs, &t->engine);
 
     js_engine_run(&t->engine);
+    js_pool_free(&t->pool);
     js_engine_free(&t->engine);
     return NULL;
 }
 
+static js_thread_t *js_thread_spawn(js_runtime_t *rt, int id, int worker) {
+    js_thread_t *t = calloc(1, sizeof(js_thread_t));
+    if (!t)
+        return NULL;
+    t->id = id;
+    t->rt = rt;
+    t->worker = worker;
+
+    /* the queue exists before any thread can push to it */
+    if (js_jobq_init(&t->jobs, worker ? js_worker_run : js_http_job_done) < 0) {
+        free(t);
+        return NULL;
+    }
+
+    if (pthread_create(&t->tid, NULL,
+                       worker ? js_worker_entry : js_thread_entry, t) != 0) {
+        fprintf(stderr, "failed to create %s %d\n",
+                worker ? "worker" : "thread", id);
+        js_jobq_free(&t->jobs);
+        free(t);
+        return NULL;
+    }
+    return t;
+}
+
 int js_thread_spawn_all(js_runtime_t *rt, int count) {
     rt->thread_count = count;
     rt->threads = calloc(count, sizeof(js_thread_t *));
     if (!rt->threads)
         return -1;
 
-    for (int i = 0; i < count; i++) {
-        rt->threads[i] = calloc(1, sizeof(js_thread_t));
-        if (!rt->threads[i])
+    /* workers first: I/O threads submit as soon as they accept */
+    if (rt->worker_count > 0) {
+        rt->workers = calloc(rt->worker_count, sizeof(js_thread_t *));
+        if (!rt->workers)
             return -1;
-        rt->threads[i]->id = i;
-        rt->threads[i]->rt = rt;
+        for (int i = 0; i < rt->worker_count; i++) {
+            rt->workers[i] = js_thread_spawn(rt, i, 1);
+            if (!rt->workers[i])
+                return -1;
+        }
+    }
 
-        if (pthread_create(&rt->threads[i]->tid, NULL,
-                           js_thread_entry, rt->threads[i]) != 0) {
-            fprintf(stderr, "failed to create thread %d\n", i);
+    for (int i = 0; i < count; i++) {
+        rt->threads[i] = js_thread_spawn(rt, i, 0);
+        if (!rt->threads[i])
             return -1;
-        }
     }
     return 0;
 }
@@ -45,4 +109,8 @@ void js_thread_wait_all(js_runtime_t *rt) {
         if (rt->threads[i])
             pthread_join(rt->threads[i]->tid, NULL);
     }
+    for (int i = 0; rt->workers && i < rt->worker_count; i++) {
+        if (rt->workers[i])
+            pthread_join(rt->workers[i]->tid, NULL);
+    }
 }
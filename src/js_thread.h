@@ -11,6 +11,10 @@ typedef struct {
     int                  id;        /* thread index */
     js_engine_t          engine;
     js_listen_t          listen;    /* listen socket event */
+    js_pool_t            pool;      /* recycled JS execs */
+    js_jobq_t            jobs;      /* worker: requests; I/O: replies */
+    int                  worker;    /* 1 = JS executor, no listen socket */
+    unsigned             next_worker; /* round-robin cursor of an I/O thread */
     struct js_runtime_s *rt;        /* back pointer to global runtime */
 } js_thread_t;
 
@@ -94,7 +94,7 @@ void js_timer_expire(js_timers_t *timers, js_msec_t now)
 {
     js_timer_t *timer;
     js_rbtree_t *tree;
-    js_rbtree_node_t *node, *next;
+    js_rbtree_node_t *node;
 
     timers->now = now;
 
@@ -104,9 +104,13 @@ void js_timer_expire(js_timers_t *timers, js_msec_t now)
 
     tree = &timers->tree;
 
+    /*
+     * The minimum is looked up again after every handler: a handler may
+     * delete other timers, e.g. the rest of an exec's setTimeout() calls.
+     */
     for (node = js_rbtree_min(tree);
          js_rbtree_is_there_successor(tree, node);
-         node = next)
+         node = js_rbtree_min(tree))
     {
         timer = (js_timer_t *) node;
 
@@ -114,8 +118,6 @@ void js_timer_expire(js_timers_t *timers, js_msec_t now)
             return;
         }
 
-        next = js_rbtree_node_successor(tree, node);
-
         js_rbtree_delete(tree, &timer->node);
         js_timer_in_tree_clear(timer);
 
@@ -0,0 +1,396 @@
+#include "js_main.h"
+
+/* user_data: request sequence number above, fd (or a marker) below */
+#define JS_URING_DATA(seq, fd)   ((uint64_t) (seq) << 32 | (uint32_t) (fd))
+#define JS_URING_TIMEOUT         0xfffffffeu   /* fd part of the deadline */
+#define JS_URING_IGNORE          UINT64_MAX    /* removals, cancellations */
+
+/* ---- ring ---- */
+
+static int js_uring_setup(unsigned entries, struct io_uring_params *p) {
+    return (int) syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int js_uring_enter(int fd, unsigned submit, unsigned wait,
+                          unsigned flags) {
+    return (int) syscall(__NR_io_uring_enter, fd, submit, wait, flags,
+                         NULL, 0);
+}
+
+int js_uring_init(js_uring_t *ur, int entries) {
+    struct io_uring_params p;
+
+    memset(ur, 0, sizeof(*ur));
+    ur->fd = -1;
+
+    /* fewer task-work interrupts where the kernel has it, else plain */
+    memset(&p, 0, sizeof(p));
+    p.flags = IORING_SETUP_COOP_TASKRUN | IORING_SETUP_SUBMIT_ALL;
+    int fd = js_uring_setup(entries, &p);
+    if (fd < 0 && errno == EINVAL) {
+        memset(&p, 0, sizeof(p));
+        fd = js_uring_setup(entries, &p);
+    }
+    if (fd < 0)
+        return -1;
+    ur->fd = fd;
+    ur->entries = p.sq_entries;
+
+    ur->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ur->cq_ring_size = p.cq_off.cqes
+                       + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ur->cq_ring_size > ur->sq_ring_size)
+            ur->sq_ring_size = ur->cq_ring_size;
+        ur->cq_ring_size = ur->sq_ring_size;
+    }
+    ur->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+
+    ur->sq_ring = mmap(NULL, ur->sq_ring_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ur->sq_ring == MAP_FAILED) {
+        ur->sq_ring = NULL;
+        goto failed;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        ur->cq_ring = ur->sq_ring;
+    } else {
+        ur->cq_ring = mmap(NULL, ur->cq_ring_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (ur->cq_ring == MAP_FAILED) {
+            ur->cq_ring = NULL;
+            goto failed;
+        }
+    }
+    ur->sqes = mmap(NULL, ur->sqes_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (ur->sqes == MAP_FAILED) {
+        ur->sqes = NULL;
+        goto failed;
+    }
+
+    char *sq = ur->sq_ring, *cq = ur->cq_ring;
+    ur->sq_head = (unsigned *) (sq + p.sq_off.head);
+    ur->sq_tail = (unsigned *) (sq + p.sq_off.tail);
+    ur->sq_mask = (unsigned *) (sq + p.sq_off.ring_mask);
+    ur->sq_array = (unsigned *) (sq + p.sq_off.array);
+    ur->sq_local = *ur->sq_tail;
+    ur->cq_head = (unsigned *) (cq + p.cq_off.head);
+    ur->cq_tail = (unsigned *) (cq + p.cq_off.tail);
+    ur->cq_mask = (unsigned *) (cq + p.cq_off.ring_mask);
+    ur->cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+    return 0;
+
+failed:
+    js_uring_free(ur);
+    return -1;
+}
+
+void js_uring_free(js_uring_t *ur) {
+    if (ur->sqes)
+        munmap(ur->sqes, ur->sqes_size);
+    if (ur->cq_ring && ur->cq_ring != ur->sq_ring)
+        munmap(ur->cq_ring, ur->cq_ring_size);
+    if (ur->sq_ring)
+        munmap(ur->sq_ring, ur->sq_ring_size);
+    if (ur->fd >= 0)
+        close(ur->fd);
+    free(ur->slots);
+    memset(ur, 0, sizeof(*ur));
+    ur->fd = -1;
+}
+
+/* hand the queued SQEs to the kernel, waiting for wait completions */
+static int js_uring_submit(js_uring_t *ur, unsigned wait) {
+    __atomic_store_n(ur->sq_tail, ur->sq_local, __ATOMIC_RELEASE);
+    unsigned submit = ur->sq_local
+                      - __atomic_load_n(ur->sq_head, __ATOMIC_ACQUIRE);
+    if (submit == 0 && wait == 0)
+        return 0;
+    return js_uring_enter(ur->fd, submit, wait,
+                          wait ? IORING_ENTER_GETEVENTS : 0);
+}
+
+/* the next free SQE, cleared; a full queue is submitted first */
+static struct io_uring_sqe *js_uring_sqe(js_uring_t *ur, uint64_t data) {
+    unsigned head = __atomic_load_n(ur->sq_head, __ATOMIC_ACQUIRE);
+
+    if (ur->sq_local - head == ur->entries) {
+        if (js_uring_submit(ur, 0) < 0)
+            return NULL;
+        head = __atomic_load_n(ur->sq_head, __ATOMIC_ACQUIRE);
+        if (ur->sq_local - head == ur->entries)
+            return NULL;
+    }
+
+    unsigned idx = ur->sq_local & *ur->sq_mask;
+    struct io_uring_sqe *sqe = &ur->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->user_data = data;
+    ur->sq_array[idx] = idx;
+    ur->sq_local++;
+    return sqe;
+}
+
+/* ---- watched fds ---- */
+
+static js_uring_slot_t *js_uring_slot(js_uring_t *ur, int fd) {
+    if (fd < 0)
+        return NULL;
+    if (fd >= ur->slot_count) {
+        int count = ur->slot_count ? ur->slot_count : 64;
+        while (count <= fd)
+            count *= 2;
+        js_uring_slot_t *slots = realloc(ur->slots, count * sizeof(*slots));
+        if (!slots)
+            return NULL;
+        memset(slots + ur->slot_count, 0,
+               (count - ur->slot_count) * sizeof(*slots));
+        ur->slots = slots;
+        ur->slot_count = count;
+    }
+    return &ur->slots[fd];
+}
+
+static uint32_t js_uring_seq(js_uring_t *ur) {
+    if (++ur->seq == 0)
+        ur->seq = 1;
+    return ur->seq;
+}
+
+/* a one-shot poll for the interest of the slot's event */
+static int js_uring_arm(js_uring_t *ur, int fd, js_uring_slot_t *slot) {
+    js_event_t *ev = slot->ev;
+    uint32_t seq = js_uring_seq(ur);
+    struct io_uring_sqe *sqe = js_uring_sqe(ur, JS_URING_DATA(seq, fd));
+    if (!sqe)
+        return -1;
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = ev->mask | (ev->flags & EPOLLRDHUP);
+    slot->seq = seq;
+    return 0;
+}
+
+/* take back the request in flight; its completion is ignored */
+static int js_uring_cancel(js_uring_t *ur, int fd, js_uring_slot_t *slot) {
+    if (slot->seq == 0)
+        return 0;
+
+    struct io_uring_sqe *sqe = js_uring_sqe(ur, JS_URING_IGNORE);
+    if (!sqe)
+        return -1;
+    sqe->opcode = slot->accept ? IORING_OP_ASYNC_CANCEL
+                               : IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = JS_URING_DATA(slot->seq, fd);
+    slot->seq = 0;
+    return 0;
+}
+
+int js_uring_add(js_uring_t *ur, int fd, uint32_t events, js_event_t *ev) {
+    js_uring_slot_t *slot = js_uring_slot(ur, fd);
+    if (!slot)
+        return -1;
+
+    slot->ev = ev;
+    slot->seq = 0;
+    slot->accept = NULL;
+    ev->mask = events;
+    return events ? js_uring_arm(ur, fd, slot) : 0;
+}
+
+/* like js_epoll_mod(): the same interest again costs nothing */
+int js_uring_mod(js_uring_t *ur, int fd, uint32_t events, js_event_t *ev) {
+    js_uring_slot_t *slot = js_uring_slot(ur, fd);
+    if (!slot)
+        return -1;
+    if (ev->mask == events)
+        return 0;
+
+    ev->mask = events;
+    if (js_uring_cancel(ur, fd, slot) < 0)
+        return -1;
+    return events ? js_uring_arm(ur, fd, slot) : 0;
+}
+
+int js_uring_del(js_uring_t *ur, int fd) {
+    js_uring_slot_t *slot = js_uring_slot(ur, fd);
+    if (!slot || !slot->ev)
+        return 0;
+
+    /* a poll in flight pins the file: the fd's close would not free it */
+    int rc = js_uring_cancel(ur, fd, slot);
+    slot->ev->mask = 0;
+    slot->ev = NULL;
+    slot->accept = NULL;
+    return rc;
+}
+
+/* connections of listener fd come in through one multishot accept */
+static int js_uring_accept_arm(js_uring_t *ur, int fd, js_uring_slot_t *slot) {
+    uint32_t seq = js_uring_seq(ur);
+    struct io_uring_sqe *sqe = js_uring_sqe(ur, JS_URING_DATA(seq, fd));
+    if (!sqe)
+        return -1;
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = fd;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    slot->seq = seq;
+    return 0;
+}
+
+int js_uring_accept(js_uring_t *ur, int fd, js_event_t *ev,
+                    js_accept_handler_t handler) {
+    js_uring_slot_t *slot = js_uring_slot(ur, fd);
+    if (!slot)
+        return -1;
+
+    slot->ev = ev;
+    slot->accept = handler;
+    ev->mask = EPOLLIN;
+    return js_uring_accept_arm(ur, fd, slot);
+}
+
+/* ---- completions ---- */
+
+static void js_uring_accepted(js_uring_t *ur, int fd, js_uring_slot_t *slot,
+                              struct io_uring_cqe *cqe) {
+    js_event_t *ev = slot->ev;
+    int more = cqe->flags & IORING_CQE_F_MORE;
+
+    if (!more)
+        slot->seq = 0;
+    if (cqe->res >= 0) {
+        slot->accept(ev, cqe->res);
+    } else if (cqe->res == -EINVAL && !more) {
+        /* no multishot accept: watch it, ev->read accepts */
+        slot->accept = NULL;
+        js_uring_arm(ur, fd, slot);
+        return;
+    }
+
+    /* ended (an error, a full ring): start over; the table may have grown */
+    slot = &ur->slots[fd];
+    if (!more && slot->ev == ev && slot->accept && slot->seq == 0)
+        js_uring_accept_arm(ur, fd, slot);
+}
+
+static void js_uring_polled(js_uring_t *ur, int fd, js_uring_slot_t *slot,
+                            struct io_uring_cqe *cqe) {
+    js_event_t *ev = slot->ev;
+    uint32_t events = cqe->res < 0 ? EPOLLERR : (uint32_t) cqe->res;
+
+    slot->seq = 0;
+    ev->revents = events;
+    if ((events & EPOLLIN) && ev->read) {
+        ev->read(ev);
+    } else if ((events & EPOLLOUT) && ev->write) {
+        ev->write(ev);
+    } else if ((events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) && ev->read) {
+        ev->read(ev);
+    }
+
+    /*
+     * Armed again unless the callback did (new interest) or let go of
+     * the fd; ev may be freed by now, so it is only compared.
+     */
+    slot = &ur->slots[fd];
+    if (slot->ev == ev && slot->seq == 0 && ev->mask)
+        js_uring_arm(ur, fd, slot);
+}
+
+static void js_uring_complete(js_uring_t *ur, struct io_uring_cqe *cqe) {
+    if (cqe->user_data == JS_URING_IGNORE)
+        return;
+
+    uint32_t seq = (uint32_t) (cqe->user_data >> 32);
+    uint32_t fd = (uint32_t) cqe->user_data;
+
+    if (fd == JS_URING_TIMEOUT) {
+        if (seq == ur->timeout_seq)
+            ur->timeout_seq = 0;
+        return;
+    }
+
+    /* a request cancelled or replaced since, or an fd let go of */
+    if ((int) fd >= ur->slot_count)
+        return;
+    js_uring_slot_t *slot = &ur->slots[fd];
+    if (!slot->ev || slot->seq != seq)
+        return;
+
+    if (slot->accept)
+        js_uring_accepted(ur, fd, slot, cqe);
+    else
+        js_uring_polled(ur, fd, slot, cqe);
+}
+
+/* the wait ends at the earliest timer at the latest */
+static int js_uring_deadline(js_uring_t *ur, int timeout_ms) {
+    struct timespec now;
+    struct __kernel_timespec at;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    at.tv_sec = now.tv_sec + timeout_ms / 1000;
+    at.tv_nsec = now.tv_nsec + (long long) (timeout_ms % 1000) * 1000000;
+    if (at.tv_nsec >= 1000000000) {
+        at.tv_sec++;
+        at.tv_nsec -= 1000000000;
+    }
+
+    /* the one in flight is close enough: keep it */
+    if (ur->timeout_seq) {
+        long long diff = (at.tv_sec - ur->deadline.tv_sec) * 1000
+                         + (at.tv_nsec - ur->deadline.tv_nsec) / 1000000;
+        if (diff >= 0 && diff <= JS_TIMER_DEFAULT_BIAS)
+            return 0;
+
+        struct io_uring_sqe *sqe = js_uring_sqe(ur, JS_URING_IGNORE);
+        if (!sqe)
+            return -1;
+        sqe->opcode = IORING_OP_TIMEOUT_REMOVE;
+        sqe->fd = -1;
+        sqe->addr = JS_URING_DATA(ur->timeout_seq, JS_URING_TIMEOUT);
+        ur->timeout_seq = 0;
+    }
+
+    uint32_t seq = js_uring_seq(ur);
+    struct io_uring_sqe *sqe = js_uring_sqe(ur,
+                                   JS_URING_DATA(seq, JS_URING_TIMEOUT));
+    if (!sqe)
+        return -1;
+    ur->deadline = at;
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = (uint64_t) (uintptr_t) &ur->deadline;
+    sqe->len = 1;
+    sqe->timeout_flags = IORING_TIMEOUT_ABS;
+    ur->timeout_seq = seq;
+    return 0;
+}
+
+int js_uring_poll(js_uring_t *ur, int timeout_ms) {
+    if (timeout_ms > 0 && js_uring_deadline(ur, timeout_ms) < 0)
+        return -1;
+
+    /* submit everything queued since the last round and wait, at once */
+    int rc = js_uring_submit(ur, timeout_ms == 0 ? 0 : 1);
+    if (rc < 0 && errno != EINTR && errno != ETIME && errno != EAGAIN
+        && errno != EBUSY)
+        return -1;
+
+    unsigned head = *ur->cq_head;
+    unsigned tail = __atomic_load_n(ur->cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        struct io_uring_cqe cqe = ur->cqes[head & *ur->cq_mask];
+
+        /* free the entry before the callback can fill the ring again */
+        __atomic_store_n(ur->cq_head, ++head, __ATOMIC_RELEASE);
+        js_uring_complete(ur, &cqe);
+    }
+    return 0;
+}
@@ -0,0 +1,64 @@
+#ifndef JS_URING_H
+#define JS_URING_H
+
+/*
+ * io_uring event backend. Keeps the js_event_t model: each watched fd has
+ * a one-shot poll in flight, armed again after its callback, which gives
+ * the level-triggered behaviour of js_epoll_t. Arming, changing and
+ * removing interest are SQEs, sent with the wait in one io_uring_enter()
+ * per loop instead of an epoll_ctl() each. Listeners use a multishot
+ * accept, the timer deadline a timeout SQE.
+ */
+
+/* ---- struct ---- */
+
+typedef struct {
+    js_event_t          *ev;       /* NULL = not watched */
+    uint32_t             seq;      /* of the request in flight, 0 = none */
+    js_accept_handler_t  accept;   /* listener: new fds go here */
+} js_uring_slot_t;
+
+typedef struct {
+    int                  fd;
+    unsigned             entries;
+
+    /* submission queue */
+    unsigned            *sq_head;
+    unsigned            *sq_tail;
+    unsigned            *sq_mask;
+    unsigned            *sq_array;
+    unsigned             sq_local;  /* tail, SQEs not published yet included */
+    struct io_uring_sqe *sqes;
+
+    /* completion queue */
+    unsigned            *cq_head;
+    unsigned            *cq_tail;
+    unsigned            *cq_mask;
+    struct io_uring_cqe *cqes;
+
+    void                *sq_ring;
+    size_t               sq_ring_size;
+    void                *cq_ring;
+    size_t               cq_ring_size;
+    size_t               sqes_size;
+
+    js_uring_slot_t     *slots;    /* by fd */
+    int                  slot_count;
+    uint32_t             seq;      /* last request sequence number */
+
+    uint32_t             timeout_seq;   /* timeout SQE in flight, 0 = none */
+    struct __kernel_timespec deadline;  /* of that timeout, CLOCK_MONOTONIC */
+} js_uring_t;
+
+/* ---- api ---- */
+
+int  js_uring_init(js_uring_t *ur, int entries);
+int  js_uring_add(js_uring_t *ur, int fd, uint32_t events, js_event_t *ev);
+int  js_uring_mod(js_uring_t *ur, int fd, uint32_t events, js_event_t *ev);
+int  js_uring_del(js_uring_t *ur, int fd);
+int  js_uring_accept(js_uring_t *ur, int fd, js_event_t *ev,
+                     js_accept_handler_t handler);
+int  js_uring_poll(js_uring_t *ur, int timeout_ms);
+void js_uring_free(js_uring_t *ur);
+
+#endif
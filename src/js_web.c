@@ -18,7 +18,8 @@ static void js_timeout_handler(js_timer_t *timer, void *data) {
         pp = &(*pp)->next;
     }
 
-    /* execute JS callback */
+    /* execute JS callback, charged to the request's budget */
+    js_exec_enter(exec);
     JSValue ret = JS_Call(qctx, to->cb, JS_UNDEFINED, 0, NULL);
     JS_FreeValue(qctx, ret);
     JS_FreeValue(qctx, to->cb);
@@ -27,12 +28,12 @@ static void js_timeout_handler(js_timer_t *timer, void *data) {
     JSContext *pctx;
     while (JS_ExecutePendingJob(exec->qrt, &pctx) > 0)
         ;
-
-    /* if async request and promise resolved, finish it */
-    if (exec->conn && exec->resolved && exec->timeouts == NULL)
-        js_pending_finish(exec);
+    js_exec_leave(exec);
 
     free(to);
+
+    /* if async request and promise resolved, finish it */
+    js_exec_try_finish(exec);
 }
 
 static JSValue js_set_timeout(JSContext *ctx, JSValueConst this_val,
@@ -72,6 +73,9 @@ static JSClassID js_response_class_id;
 static JSClassID js_request_class_id;
 static JSClassID js_headers_class_id;
 static JSClassID js_url_class_id;
+static JSClassID js_request_body_class_id;
+static JSClassID js_stream_class_id;
+static JSClassID js_stream_controller_class_id;
 
 /* ==== Headers class ==== */
 
@@ -497,10 +501,15 @@ JSValue js_web_new_request(JSContext *ctx, js_http_request_t *req,
         }
     }
 
-    /* copy body */
+    /* copy body, NULs and all; a streamed one is read through exec->body */
+    d->streamed = (req->stream != NULL);
     if (req->body && req->body_len > 0) {
-        d->body = strndup(req->body, req->body_len);
-        d->body_len = req->body_len;
+        d->body = malloc(req->body_len + 1);
+        if (d->body) {
+            memcpy(d->body, req->body, req->body_len);
+            d->body[req->body_len] = '\0';     /* for JS_ParseJSON() */
+            d->body_len = req->body_len;
+        }
     }
 
     /* copy params */
@@ -555,11 +564,222 @@ static JSValue js_request_get_params(JSContext *ctx, JSValueConst this_val,
     return obj;
 }
 
+/* ==== streamed request body ==== */
+
+static js_exec_t *js_web_get_exec(JSContext *ctx) {
+    return JS_GetContextOpaque(ctx);
+}
+
+enum {
+    JS_BODY_WAIT_READ,      /* read(): next chunk */
+    JS_BODY_WAIT_TEXT,      /* text(): whole body as a string */
+    JS_BODY_WAIT_JSON,      /* json(): whole body parsed */
+    JS_BODY_WAIT_BYTES      /* arrayBuffer(): whole body as is */
+};
+
+/* no state of its own: reads go through exec->body */
+static JSClassDef js_request_body_class = {
+    .class_name = "RequestBody",
+};
+
+static void js_web_free_array_buffer(JSRuntime *rt, void *opaque, void *ptr) {
+    (void)opaque;
+    js_free_rt(rt, ptr);
+}
+
+/* for ArrayBuffers over malloc'd memory, such as a js_buf_t's */
+static void js_web_free_array_buffer_libc(JSRuntime *rt, void *opaque,
+                                          void *ptr) {
+    (void)rt; (void)opaque;
+    free(ptr);
+}
+
+/* new Uint8Array(buf); buf ownership moves */
+static JSValue js_web_new_uint8array(JSContext *ctx, JSValue buf) {
+    JSValue global = JS_GetGlobalObject(ctx);
+    JSValue uint8_ctor = JS_GetPropertyStr(ctx, global, "Uint8Array");
+    JS_FreeValue(ctx, global);
+    JSValue result = JS_CallConstructor(ctx, uint8_ctor, 1, &buf);
+    JS_FreeValue(ctx, uint8_ctor);
+    JS_FreeValue(ctx, buf);
+    return result;
+}
+
+static JSValue js_web_read_result(JSContext *ctx, JSValue value, int done) {
+    JSValue obj = JS_NewObject(ctx);
+    JS_SetPropertyStr(ctx, obj, "value", value);
+    JS_SetPropertyStr(ctx, obj, "done", JS_NewBool(ctx, done));
+    return obj;
+}
+
+/* resolve (ok) or reject a pending read with val; val ownership moves */
+static void js_web_resolve(JSContext *ctx, JSValue wait[2], int ok,
+                           JSValue val) {
+    JSValue resolve = wait[0];
+    JSValue reject = wait[1];
+
+    wait[0] = wait[1] = JS_UNDEFINED;
+    JSValue ret = JS_Call(ctx, ok ? resolve : reject, JS_UNDEFINED, 1, &val);
+    JS_FreeValue(ctx, ret);
+    JS_FreeValue(ctx, val);
+    JS_FreeValue(ctx, resolve);
+    JS_FreeValue(ctx, reject);
+}
+
+static void js_web_body_complete(js_exec_t *exec, int ok, JSValue val) {
+    js_buf_free(&exec->body_text);
+    js_buf_init(&exec->body_text);
+    js_web_resolve(exec->qctx, exec->body_wait, ok, val);
+}
+
+static JSValue js_web_body_error(JSContext *ctx) {
+    JSValue err = JS_NewError(ctx);
+    JS_SetPropertyStr(ctx, err, "message",
+                      JS_NewString(ctx, "request body aborted"));
+    return err;
+}
+
+/*
+ * Settle the pending read()/text()/json() if what it waits for has
+ * arrived; otherwise it stays pending until js_qjs_body_wake().
+ */
+void js_web_body_settle(js_exec_t *exec) {
+    JSContext *ctx = exec->qctx;
+    js_body_t *b = exec->body;
+    ssize_t n = 0;
+
+    if (JS_IsUndefined(exec->body_wait[0]))
+        return;
+
+    if (exec->body_wait_kind == JS_BODY_WAIT_READ) {
+        uint8_t *buf = NULL;
+        if (b) {
+            buf = js_malloc(ctx, JS_BODY_CHUNK);
+            if (!buf) {
+                js_web_body_complete(exec, 0, JS_GetException(ctx));
+                return;
+            }
+            n = js_body_read(b, (char *) buf, JS_BODY_CHUNK);
+        }
+        if (n > 0) {
+            /* the chunk is handed to JS as is */
+            JSValue ab = JS_NewArrayBuffer(ctx, buf, n,
+                                           js_web_free_array_buffer, NULL, 0);
+            js_web_body_complete(exec, 1, js_web_read_result(ctx,
+                                 js_web_new_uint8array(ctx, ab), 0));
+            return;
+        }
+        js_free(ctx, buf);
+
+        if (n < 0 || (b && b->error))
+            js_web_body_complete(exec, 0, js_web_body_error(ctx));
+        else if (!b || b->done)
+            js_web_body_complete(exec, 1,
+                                 js_web_read_result(ctx, JS_UNDEFINED, 1));
+        return;
+    }
+
+    /* text() / json() / arrayBuffer(): collect until the end */
+    char chunk[16 * 1024];
+    while (b && (n = js_body_read(b, chunk, sizeof(chunk))) > 0) {
+        if (js_buf_append(&exec->body_text, chunk, n) < 0) {
+            n = -1;
+            break;
+        }
+    }
+    if (n < 0 || (b && b->error)) {
+        js_web_body_complete(exec, 0, js_web_body_error(ctx));
+        return;
+    }
+    if (b && !b->done)
+        return;
+
+    /*
+     * arrayBuffer() takes the collected bytes over as they are;
+     * JS_ParseJSON() wants a NUL after the text.
+     */
+    js_buf_t *text = &exec->body_text;
+    JSValue val;
+    if (exec->body_wait_kind == JS_BODY_WAIT_BYTES) {
+        val = JS_NewArrayBuffer(ctx, (uint8_t *) text->data, text->len,
+                                js_web_free_array_buffer_libc, NULL, 0);
+        if (!JS_IsException(val))
+            js_buf_init(text);
+    } else if (js_buf_append(text, "", 1) < 0)
+        val = JS_ThrowOutOfMemory(ctx);
+    else if (exec->body_wait_kind == JS_BODY_WAIT_TEXT)
+        val = JS_NewStringLen(ctx, text->data, text->len - 1);
+    else
+        val = JS_ParseJSON(ctx, text->data, text->len - 1, "<request>");
+
+    if (JS_IsException(val))
+        js_web_body_complete(exec, 0, JS_GetException(ctx));
+    else
+        js_web_body_complete(exec, 1, val);
+}
+
+/* the request is over: drop a read still pending, let go of the body */
+void js_web_body_detach(js_exec_t *exec) {
+    if (exec->body)
+        exec->body->exec = NULL;
+    exec->body = NULL;
+
+    JS_FreeValue(exec->qctx, exec->body_wait[0]);
+    JS_FreeValue(exec->qctx, exec->body_wait[1]);
+    exec->body_wait[0] = exec->body_wait[1] = JS_UNDEFINED;
+    js_buf_free(&exec->body_text);
+    js_buf_init(&exec->body_text);
+}
+
+/* one read at a time, answered by js_web_body_settle() */
+static JSValue js_web_body_wait(JSContext *ctx, int kind) {
+    js_exec_t *exec = js_web_get_exec(ctx);
+    JSValue funcs[2];
+
+    if (!JS_IsUndefined(exec->body_wait[0]))
+        return JS_ThrowTypeError(ctx, "request body is already being read");
+
+    JSValue promise = JS_NewPromiseCapability(ctx, funcs);
+    if (JS_IsException(promise))
+        return promise;
+    exec->body_wait[0] = funcs[0];
+    exec->body_wait[1] = funcs[1];
+    exec->body_wait_kind = kind;
+
+    js_web_body_settle(exec);
+    return promise;
+}
+
+static JSValue js_request_body_read(JSContext *ctx, JSValueConst this_val,
+                                    int argc, JSValue *argv) {
+    (void)this_val; (void)argc; (void)argv;
+    return js_web_body_wait(ctx, JS_BODY_WAIT_READ);
+}
+
+/* getReader() and [Symbol.asyncIterator]() are the body itself */
+static JSValue js_request_body_self(JSContext *ctx, JSValueConst this_val,
+                                    int argc, JSValue *argv) {
+    (void)argc; (void)argv;
+    return JS_DupValue(ctx, this_val);
+}
+
+static JSValue js_request_get_body(JSContext *ctx, JSValueConst this_val,
+                                   int magic) {
+    (void)magic;
+    JSRequestData *d = JS_GetOpaque2(ctx, this_val, js_request_class_id);
+    if (!d) return JS_EXCEPTION;
+    if (!d->streamed)
+        return JS_NULL;
+    return JS_NewObjectClass(ctx, js_request_body_class_id);
+}
+
 static JSValue js_request_text(JSContext *ctx, JSValueConst this_val,
                                int argc, JSValue *argv) {
     (void)argc; (void)argv;
     JSRequestData *d = JS_GetOpaque2(ctx, this_val, js_request_class_id);
     if (!d) return JS_EXCEPTION;
+    if (d->streamed)
+        return js_web_body_wait(ctx, JS_BODY_WAIT_TEXT);
     if (d->body)
         return JS_NewStringLen(ctx, d->body, d->body_len);
     return JS_NewString(ctx, "");
@@ -570,56 +790,132 @@ static JSValue js_request_json(JSContext *ctx, JSValueConst this_val,
     (void)argc; (void)argv;
     JSRequestData *d = JS_GetOpaque2(ctx, this_val, js_request_class_id);
     if (!d) return JS_EXCEPTION;
+    if (d->streamed)
+        return js_web_body_wait(ctx, JS_BODY_WAIT_JSON);
     if (!d->body)
         return JS_NULL;
     return JS_ParseJSON(ctx, d->body, d->body_len, "<request>");
 }
 
+/* the body as is: binary bodies are not round-tripped through a string */
+static JSValue js_request_array_buffer(JSContext *ctx, JSValueConst this_val,
+                                       int argc, JSValue *argv) {
+    (void)argc; (void)argv;
+    JSRequestData *d = JS_GetOpaque2(ctx, this_val, js_request_class_id);
+    if (!d) return JS_EXCEPTION;
+    if (d->streamed)
+        return js_web_body_wait(ctx, JS_BODY_WAIT_BYTES);
+    return JS_NewArrayBufferCopy(ctx, (const uint8_t *) d->body, d->body_len);
+}
+
 /* ==== Response class ==== */
 
+static void js_response_data_free(JSRuntime *rt, JSResponseData *d) {
+    for (int i = 0; i < d->header_count; i++) {
+        free(d->headers[i].name);
+        free(d->headers[i].value);
+    }
+    free(d->headers);
+    js_rcbuf_release(d->body);
+    JS_FreeValueRT(rt, d->stream);
+    free(d);
+}
+
 static void js_response_finalizer(JSRuntime *rt, JSValue val) {
-    (void)rt;
     JSResponseData *d = JS_GetOpaque(val, js_response_class_id);
-    if (d) {
-        for (int i = 0; i < d->header_count; i++) {
-            free(d->headers[i].name);
-            free(d->headers[i].value);
-        }
-        free(d->headers);
-        free(d->body);
-        free(d);
-    }
+    if (d)
+        js_response_data_free(rt, d);
+}
+
+static void js_response_mark(JSRuntime *rt, JSValueConst val,
+                             JS_MarkFunc *mark_func) {
+    JSResponseData *d = JS_GetOpaque(val, js_response_class_id);
+    if (d)
+        JS_MarkValue(rt, d->stream, mark_func);
 }
 
 static JSClassDef js_response_class = {
     "Response",
     .finalizer = js_response_finalizer,
+    .gc_mark = js_response_mark,
 };
 
+/* obj[Symbol.asyncIterator], JS_UNDEFINED if it has none */
+static JSValue js_web_async_iterator(JSContext *ctx, JSValueConst obj) {
+    JSValue global = JS_GetGlobalObject(ctx);
+    JSValue symbol = JS_GetPropertyStr(ctx, global, "Symbol");
+    JSValue key = JS_GetPropertyStr(ctx, symbol, "asyncIterator");
+    JSAtom atom = JS_ValueToAtom(ctx, key);
+    JSValue method = JS_GetProperty(ctx, obj, atom);
+    JS_FreeAtom(ctx, atom);
+    JS_FreeValue(ctx, key);
+    JS_FreeValue(ctx, symbol);
+    JS_FreeValue(ctx, global);
+    if (JS_IsFunction(ctx, method))
+        return method;
+    JS_FreeValue(ctx, method);
+    return JS_UNDEFINED;
+}
+
+/* a body that is read chunk by chunk: ReadableStream or async iterable */
+static int js_web_is_stream(JSContext *ctx, JSValueConst val) {
+    if (!JS_IsObject(val))
+        return 0;
+    if (JS_GetOpaque(val, js_stream_class_id))
+        return 1;
+    JSValue method = js_web_async_iterator(ctx, val);
+    int found = !JS_IsUndefined(method);
+    JS_FreeValue(ctx, method);
+    return found;
+}
+
 static JSValue js_response_ctor(JSContext *ctx, JSValueConst new_target,
                                 int argc, JSValue *argv) {
     (void)new_target;
     JSResponseData *d = calloc(1, sizeof(*d));
+    if (!d)
+        return JS_ThrowOutOfMemory(ctx);
     d->status = 200;
+    d->stream = JS_UNDEFINED;
 
-    /* arg0: body (string or null) */
-    if (argc >= 1 && !JS_IsNull(argv[0]) && !JS_IsUndefined(argv[0])) {
+    /* arg0: body (string, ArrayBuffer, typed array, stream or null) */
+    if (argc >= 1 && js_web_is_stream(ctx, argv[0])) {
+        d->stream = JS_DupValue(ctx, argv[0]);
+    } else if (argc >= 1 && !JS_IsNull(argv[0]) && !JS_IsUndefined(argv[0])) {
         size_t len;
-        const char *str = JS_ToCStringLen(ctx, &len, argv[0]);
-        if (str) {
-            d->body = strndup(str, len);
-            d->body_len = len;
+        const char *str;
+        const uint8_t *bytes = js_web_chunk(ctx, argv[0], &len, &str);
+        if (!bytes) {
+            js_response_data_free(JS_GetRuntime(ctx), d);
+            return JS_EXCEPTION;
+        }
+        d->body = js_rcbuf_create((const char *) bytes, len);
+        if (str)
             JS_FreeCString(ctx, str);
+        if (!d->body) {
+            js_response_data_free(JS_GetRuntime(ctx), d);
+            return JS_ThrowOutOfMemory(ctx);
         }
     }
 
     /* arg1: options { status, headers } */
     if (argc >= 2 && JS_IsObject(argv[1])) {
         JSValue status_val = JS_GetPropertyStr(ctx, argv[1], "status");
-        if (JS_IsNumber(status_val)) {
-            int32_t s;
-            JS_ToInt32(ctx, &s, status_val);
-            d->status = s;
+        if (!JS_IsUndefined(status_val)) {
+            double s;
+            /* also keeps 0 out: a reply of status 0 would send nothing */
+            if (JS_ToFloat64(ctx, &s, status_val) < 0) {
+                JS_FreeValue(ctx, status_val);
+                js_response_data_free(JS_GetRuntime(ctx), d);
+                return JS_EXCEPTION;
+            }
+            if (!(s >= 200 && s <= 599) || s != (int) s) {
+                JS_FreeValue(ctx, status_val);
+                js_response_data_free(JS_GetRuntime(ctx), d);
+                return JS_ThrowRangeError(ctx, "Response: status must be "
+                                          "an integer in 200..599");
+            }
+            d->status = (int) s;
         }
         JS_FreeValue(ctx, status_val);
 
@@ -653,6 +949,394 @@ static JSValue js_response_ctor(JSContext *ctx, JSValueConst new_target,
     return obj;
 }
 
+/* ==== ReadableStream ==== */
+
+static void js_stream_finalizer(JSRuntime *rt, JSValue val) {
+    JSReadableStreamData *d = JS_GetOpaque(val, js_stream_class_id);
+    if (d) {
+        JS_FreeValueRT(rt, d->source);
+        JS_FreeValueRT(rt, d->controller);
+        JS_FreeValueRT(rt, d->error);
+        JS_FreeValueRT(rt, d->wait[0]);
+        JS_FreeValueRT(rt, d->wait[1]);
+        for (int i = 0; i < d->queue_len; i++)
+            JS_FreeValueRT(rt, d->queue[i]);
+        free(d->queue);
+        free(d);
+    }
+}
+
+/* source and controller point back at the stream: let the GC see cycles */
+static void js_stream_mark(JSRuntime *rt, JSValueConst val,
+                           JS_MarkFunc *mark_func) {
+    JSReadableStreamData *d = JS_GetOpaque(val, js_stream_class_id);
+    if (d) {
+        JS_MarkValue(rt, d->source, mark_func);
+        JS_MarkValue(rt, d->controller, mark_func);
+        JS_MarkValue(rt, d->error, mark_func);
+        JS_MarkValue(rt, d->wait[0], mark_func);
+        JS_MarkValue(rt, d->wait[1], mark_func);
+        for (int i = 0; i < d->queue_len; i++)
+            JS_MarkValue(rt, d->queue[i], mark_func);
+    }
+}
+
+static JSClassDef js_stream_class = {
+    "ReadableStream",
+    .finalizer = js_stream_finalizer,
+    .gc_mark = js_stream_mark,
+};
+
+static void js_stream_controller_finalizer(JSRuntime *rt, JSValue val) {
+    JSStreamControllerData *c = JS_GetOpaque(val,
+                                             js_stream_controller_class_id);
+    if (c) {
+        JS_FreeValueRT(rt, c->stream);
+        free(c);
+    }
+}
+
+static void js_stream_controller_mark(JSRuntime *rt, JSValueConst val,
+                                      JS_MarkFunc *mark_func) {
+    JSStreamControllerData *c = JS_GetOpaque(val,
+                                             js_stream_controller_class_id);
+    if (c)
+        JS_MarkValue(rt, c->stream, mark_func);
+}
+
+static JSClassDef js_stream_controller_class = {
+    "ReadableStreamDefaultController",
+    .finalizer = js_stream_controller_finalizer,
+    .gc_mark = js_stream_controller_mark,
+};
+
+/* answer the pending read from the queue, or with the stream's end */
+static void js_stream_settle(JSContext *ctx, JSReadableStreamData *d) {
+    if (JS_IsUndefined(d->wait[0]))
+        return;
+
+    if (d->queue_len > 0) {
+        JSValue chunk = d->queue[0];
+        d->queue_len--;
+        memmove(d->queue, d->queue + 1, d->queue_len * sizeof(JSValue));
+        js_web_resolve(ctx, d->wait, 1, js_web_read_result(ctx, chunk, 0));
+    } else if (d->errored) {
+        js_web_resolve(ctx, d->wait, 0, JS_DupValue(ctx, d->error));
+    } else if (d->closed) {
+        js_web_resolve(ctx, d->wait, 1,
+                       js_web_read_result(ctx, JS_UNDEFINED, 1));
+    }
+}
+
+/* error(e): queued chunks are dropped, reads reject with e from now on */
+static void js_stream_fail(JSContext *ctx, JSReadableStreamData *d,
+                           JSValueConst err) {
+    if (d->closed || d->errored)
+        return;
+    d->errored = 1;
+    d->error = JS_DupValue(ctx, err);
+    for (int i = 0; i < d->queue_len; i++)
+        JS_FreeValue(ctx, d->queue[i]);
+    d->queue_len = 0;
+    js_stream_settle(ctx, d);
+}
+
+static void js_stream_pull(JSContext *ctx, JSValueConst obj,
+                           JSReadableStreamData *d);
+
+/* start() or pull() settled; magic: 1 = it failed */
+static JSValue js_stream_pulled(JSContext *ctx, JSValueConst this_val,
+                                int argc, JSValueConst *argv, int magic,
+                                JSValue *func_data) {
+    (void)this_val;
+    JSReadableStreamData *d = JS_GetOpaque(func_data[0], js_stream_class_id);
+
+    d->pulling = 0;
+    if (magic) {
+        js_stream_fail(ctx, d, argc >= 1 ? argv[0] : JS_UNDEFINED);
+    } else if (d->pull_again) {
+        d->pull_again = 0;
+        if (!JS_IsUndefined(d->wait[0]))
+            js_stream_pull(ctx, func_data[0], d);
+    }
+    return JS_UNDEFINED;
+}
+
+/* a start() or pull() call returned ret: wait for it if it is a promise */
+static void js_stream_track(JSContext *ctx, JSValueConst obj,
+                            JSReadableStreamData *d, JSValue ret) {
+    if (JS_IsException(ret)) {
+        JSValue err = JS_GetException(ctx);
+        d->pulling = 0;
+        js_stream_fail(ctx, d, err);
+        JS_FreeValue(ctx, err);
+        return;
+    }
+
+    if ((int) JS_PromiseState(ctx, ret) < 0) {
+        JS_FreeValue(ctx, ret);
+        JSValue data = JS_DupValue(ctx, obj);
+        js_stream_pulled(ctx, JS_UNDEFINED, 0, NULL, 0, &data);
+        JS_FreeValue(ctx, data);
+        return;
+    }
+
+    JSValue on_ok = JS_NewCFunctionData(ctx, js_stream_pulled, 0, 0, 1,
+                                        &obj);
+    JSValue on_fail = JS_NewCFunctionData(ctx, js_stream_pulled, 1, 1, 1,
+                                          &obj);
+    JSValue args[2] = { on_ok, on_fail };
+    JSAtom then = JS_NewAtom(ctx, "then");
+    JS_FreeValue(ctx, JS_Invoke(ctx, ret, then, 2, args));
+    JS_FreeAtom(ctx, then);
+    JS_FreeValue(ctx, on_ok);
+    JS_FreeValue(ctx, on_fail);
+    JS_FreeValue(ctx, ret);
+}
+
+/* call source[name](controller) if the source has it */
+static int js_stream_call(JSContext *ctx, JSValueConst obj,
+                          JSReadableStreamData *d, const char *name) {
+    JSValue fn = JS_GetPropertyStr(ctx, d->source, name);
+    if (!JS_IsFunction(ctx, fn)) {
+        JS_FreeValue(ctx, fn);
+        return 0;
+    }
+    d->pulling = 1;
+    JSValue ret = JS_Call(ctx, fn, d->source, 1, &d->controller);
+    JS_FreeValue(ctx, fn);
+    js_stream_track(ctx, obj, d, ret);
+    return 1;
+}
+
+/* a read found the queue empty: ask the source for more, once at a time */
+static void js_stream_pull(JSContext *ctx, JSValueConst obj,
+                           JSReadableStreamData *d) {
+    if (d->closed || d->errored)
+        return;
+    if (d->pulling) {
+        d->pull_again = 1;
+        return;
+    }
+    js_stream_call(ctx, obj, d, "pull");
+}
+
+static JSValue js_stream_ctor(JSContext *ctx, JSValueConst new_target,
+                              int argc, JSValue *argv) {
+    (void)new_target;
+    JSReadableStreamData *d = calloc(1, sizeof(*d));
+    if (!d)
+        return JS_ThrowOutOfMemory(ctx);
+    d->source = argc >= 1 && JS_IsObject(argv[0])
+                ? JS_DupValue(ctx, argv[0]) : JS_NewObject(ctx);
+    d->error = JS_UNDEFINED;
+    d->wait[0] = d->wait[1] = JS_UNDEFINED;
+
+    JSValue obj = JS_NewObjectClass(ctx, js_stream_class_id);
+    JS_SetOpaque(obj, d);
+
+    JSStreamControllerData *c = calloc(1, sizeof(*c));
+    if (!c) {
+        d->controller = JS_UNDEFINED;
+        JS_FreeValue(ctx, obj);
+        return JS_ThrowOutOfMemory(ctx);
+    }
+    c->stream = JS_DupValue(ctx, obj);
+    d->controller = JS_NewObjectClass(ctx, js_stream_controller_class_id);
+    JS_SetOpaque(d->controller, c);
+
+    js_stream_call(ctx, obj, d, "start");
+    return obj;
+}
+
+static JSReadableStreamData *js_stream_of_controller(JSContext *ctx,
+                                                     JSValueConst this_val) {
+    JSStreamControllerData *c = JS_GetOpaque2(ctx, this_val,
+                                              js_stream_controller_class_id);
+    if (!c)
+        return NULL;
+    return JS_GetOpaque(c->stream, js_stream_class_id);
+}
+
+static JSValue js_stream_controller_enqueue(JSContext *ctx,
+                                            JSValueConst this_val,
+                                            int argc, JSValue *argv) {
+    JSReadableStreamData *d = js_stream_of_controller(ctx, this_val);
+    if (!d) return JS_EXCEPTION;
+    if (d->closed || d->errored)
+        return JS_ThrowTypeError(ctx, "stream is closed");
+
+    if (d->queue_len == d->queue_cap) {
+        int cap = d->queue_cap ? d->queue_cap * 2 : 8;
+        JSValue *q = realloc(d->queue, cap * sizeof(JSValue));
+        if (!q)
+            return JS_ThrowOutOfMemory(ctx);
+        d->queue = q;
+        d->queue_cap = cap;
+    }
+    d->queue[d->queue_len++] = argc >= 1 ? JS_DupValue(ctx, argv[0])
+                                         : JS_UNDEFINED;
+    js_stream_settle(ctx, d);
+    return JS_UNDEFINED;
+}
+
+static JSValue js_stream_controller_close(JSContext *ctx,
+                                          JSValueConst this_val,
+                                          int argc, JSValue *argv) {
+    (void)argc; (void)argv;
+    JSReadableStreamData *d = js_stream_of_controller(ctx, this_val);
+    if (!d) return JS_EXCEPTION;
+    if (d->closed || d->errored)
+        return JS_ThrowTypeError(ctx, "stream is closed");
+    d->closed = 1;
+    js_stream_settle(ctx, d);
+    return JS_UNDEFINED;
+}
+
+static JSValue js_stream_controller_error(JSContext *ctx,
+                                          JSValueConst this_val,
+                                          int argc, JSValue *argv) {
+    JSReadableStreamData *d = js_stream_of_controller(ctx, this_val);
+    if (!d) return JS_EXCEPTION;
+    js_stream_fail(ctx, d, argc >= 1 ? argv[0] : JS_UNDEFINED);
+    return JS_UNDEFINED;
+}
+
+/* high-water mark of one chunk */
+static JSValue js_stream_controller_get_desired_size(JSContext *ctx,
+                                                     JSValueConst this_val,
+                                                     int magic) {
+    (void)magic;
+    JSReadableStreamData *d = js_stream_of_controller(ctx, this_val);
+    if (!d) return JS_EXCEPTION;
+    if (d->errored)
+        return JS_NULL;
+    return JS_NewInt32(ctx, d->closed ? 0 : 1 - d->queue_len);
+}
+
+/* getReader() and [Symbol.asyncIterator]() are the stream itself */
+static JSValue js_stream_read(JSContext *ctx, JSValueConst this_val,
+                              int argc, JSValue *argv) {
+    (void)argc; (void)argv;
+    JSReadableStreamData *d = JS_GetOpaque2(ctx, this_val,
+                                            js_stream_class_id);
+    if (!d) return JS_EXCEPTION;
+    if (!JS_IsUndefined(d->wait[0]))
+        return JS_ThrowTypeError(ctx, "stream is already being read");
+
+    JSValue promise = JS_NewPromiseCapability(ctx, d->wait);
+    if (JS_IsException(promise))
+        return promise;
+    js_stream_settle(ctx, d);
+    if (!JS_IsUndefined(d->wait[0]))
+        js_stream_pull(ctx, this_val, d);
+    return promise;
+}
+
+/* cancel(reason); magic 1 is the async iterator's return() */
+static JSValue js_stream_cancel(JSContext *ctx, JSValueConst this_val,
+                                int argc, JSValue *argv, int magic) {
+    JSReadableStreamData *d = JS_GetOpaque2(ctx, this_val,
+                                            js_stream_class_id);
+    if (!d) return JS_EXCEPTION;
+
+    if (!d->closed && !d->errored) {
+        d->closed = 1;
+        for (int i = 0; i < d->queue_len; i++)
+            JS_FreeValue(ctx, d->queue[i]);
+        d->queue_len = 0;
+        js_stream_settle(ctx, d);
+
+        JSValue fn = JS_GetPropertyStr(ctx, d->source, "cancel");
+        if (JS_IsFunction(ctx, fn)) {
+            JSValue reason = argc >= 1 ? argv[0] : JS_UNDEFINED;
+            JSValue ret = JS_Call(ctx, fn, d->source, 1, &reason);
+            if (JS_IsException(ret)) {
+                JS_FreeValue(ctx, fn);
+                return ret;
+            }
+            JS_FreeValue(ctx, ret);
+        }
+        JS_FreeValue(ctx, fn);
+    }
+
+    JSValue funcs[2];
+    JSValue promise = JS_NewPromiseCapability(ctx, funcs);
+    if (JS_IsException(promise))
+        return promise;
+    js_web_resolve(ctx, funcs, 1, magic ? js_web_read_result(ctx,
+                   JS_UNDEFINED, 1) : JS_UNDEFINED);
+    return promise;
+}
+
+/*
+ * How the server pulls a streamed response body: src and next are the
+ * object and method to call for each { value, done }. Returns 1 with
+ * both set, 0 if the body is not a stream, -1 on exception.
+ */
+int js_web_response_stream(JSContext *ctx, JSValueConst val,
+                           JSValue *src, JSValue *next) {
+    JSResponseData *d = JS_GetOpaque(val, js_response_class_id);
+    if (!d || JS_IsUndefined(d->stream))
+        return 0;
+
+    if (JS_GetOpaque(d->stream, js_stream_class_id)) {
+        *src = JS_DupValue(ctx, d->stream);
+        *next = JS_GetPropertyStr(ctx, d->stream, "read");
+        return 1;
+    }
+
+    JSValue method = js_web_async_iterator(ctx, d->stream);
+    *src = JS_Call(ctx, method, d->stream, 0, NULL);
+    JS_FreeValue(ctx, method);
+    if (JS_IsException(*src))
+        return -1;
+    *next = JS_GetPropertyStr(ctx, *src, "next");
+    if (!JS_IsFunction(ctx, *next)) {
+        JS_FreeValue(ctx, *src);
+        JS_FreeValue(ctx, *next);
+        JS_ThrowTypeError(ctx, "body iterator has no next()");
+        return -1;
+    }
+    return 1;
+}
+
+/*
+ * Bytes of a body chunk: typed arrays and ArrayBuffers as they are,
+ * anything else as its string. When *str is set on return the caller
+ * frees it with JS_FreeCString(). NULL on exception.
+ *
+ * Only objects are asked for their buffer, typed arrays first: each
+ * failed lookup throws, and strings and Uint8Array are the usual chunks.
+ */
+const uint8_t *js_web_chunk(JSContext *ctx, JSValueConst val, size_t *len,
+                            const char **str) {
+    size_t off, size, bpe;
+    uint8_t *bytes;
+
+    *str = NULL;
+    if (JS_IsObject(val)) {
+        JSValue ab = JS_GetTypedArrayBuffer(ctx, val, &off, &size, &bpe);
+        if (!JS_IsException(ab)) {
+            bytes = JS_GetArrayBuffer(ctx, len, ab);
+            JS_FreeValue(ctx, ab);      /* val keeps the buffer alive */
+            if (!bytes)
+                return NULL;
+            *len = size;
+            return bytes + off;
+        }
+        JS_FreeValue(ctx, JS_GetException(ctx));
+
+        bytes = JS_GetArrayBuffer(ctx, len, val);
+        if (bytes)
+            return bytes;
+        JS_FreeValue(ctx, JS_GetException(ctx));
+    }
+
+    *str = JS_ToCStringLen(ctx, len, val);
+    return (const uint8_t *) *str;
+}
+
 /* ==== TextEncoder / TextDecoder ==== */
 
 static JSValue js_textencoder_ctor(JSContext *ctx, JSValueConst new_target,
@@ -675,14 +1359,7 @@ static JSValue js_textencoder_encode(JSContext *ctx, JSValueConst this_val,
     if (!str) return JS_EXCEPTION;
     JSValue buf = JS_NewArrayBufferCopy(ctx, (const uint8_t *)str, len);
     JS_FreeCString(ctx, str);
-    /* wrap in Uint8Array */
-    JSValue global = JS_GetGlobalObject(ctx);
-    JSValue uint8_ctor = JS_GetPropertyStr(ctx, global, "Uint8Array");
-    JS_FreeValue(ctx, global);
-    JSValue result = JS_CallConstructor(ctx, uint8_ctor, 1, &buf);
-    JS_FreeValue(ctx, uint8_ctor);
-    JS_FreeValue(ctx, buf);
-    return result;
+    return js_web_new_uint8array(ctx, buf);
 }
 
 static JSValue js_textdecoder_decode(JSContext *ctx, JSValueConst this_val,
@@ -709,23 +1386,90 @@ static JSValue js_textdecoder_decode(JSContext *ctx, JSValueConst this_val,
 
 /* ==== mock.get/post/put/patch/delete/all bindings ==== */
 
-static js_exec_t *js_web_get_exec(JSContext *ctx) {
-    return JS_GetContextOpaque(ctx);
-}
-
 static JSValue js_mock_route(JSContext *ctx, JSValueConst this_val,
                              int argc, JSValue *argv,
                              js_http_method_t method) {
     (void)this_val;
     if (argc < 2) return JS_UNDEFINED;
+    /* a constant Response was registered as a static route at startup */
+    if (!JS_IsFunction(ctx, argv[1])) return JS_UNDEFINED;
     const char *pattern = JS_ToCString(ctx, argv[0]);
     if (!pattern) return JS_EXCEPTION;
     js_exec_t *exec = js_web_get_exec(ctx);
-    js_route_add(&exec->routes, method, pattern, JS_DupValue(ctx, argv[1]));
+    js_route_t *r = js_route_add(&exec->routes, method, pattern,
+                                 JS_DupValue(ctx, argv[1]));
     JS_FreeCString(ctx, pattern);
+    if (r && argc > 2)
+        js_web_route_options(ctx, argv[2], r);
     return JS_UNDEFINED;
 }
 
+/* budget: ms | { ms, status }; fields that are absent are left alone */
+void js_web_read_budget(JSContext *ctx, JSValueConst val, int *ms,
+                        int *status) {
+    int32_t n;
+
+    if (JS_IsNumber(val)) {
+        if (JS_ToInt32(ctx, &n, val) == 0 && n >= 0)
+            *ms = n;
+        return;
+    }
+    if (!JS_IsObject(val))
+        return;
+
+    JSValue v = JS_GetPropertyStr(ctx, val, "ms");
+    if (JS_IsNumber(v) && JS_ToInt32(ctx, &n, v) == 0 && n >= 0)
+        *ms = n;
+    JS_FreeValue(ctx, v);
+
+    v = JS_GetPropertyStr(ctx, val, "status");
+    if (JS_IsNumber(v) && JS_ToInt32(ctx, &n, v) == 0
+        && n >= 100 && n <= 599)
+        *status = n;
+    JS_FreeValue(ctx, v);
+}
+
+/* third argument of mock.get() etc: { cache: { ttl }, budget, stream } */
+void js_web_route_options(JSContext *ctx, JSValueConst opts, js_route_t *r) {
+    if (!JS_IsObject(opts))
+        return;
+
+    JSValue budget = JS_GetPropertyStr(ctx, opts, "budget");
+    js_web_read_budget(ctx, budget, &r->budget, &r->budget_status);
+    JS_FreeValue(ctx, budget);
+
+    JSValue cache = JS_GetPropertyStr(ctx, opts, "cache");
+    if (JS_IsObject(cache)) {
+        JSValue ttl = JS_GetPropertyStr(ctx, cache, "ttl");
+        int32_t ms;
+        if (JS_IsNumber(ttl) && JS_ToInt32(ctx, &ms, ttl) == 0 && ms > 0)
+            r->cache_ttl = ms;
+        JS_FreeValue(ctx, ttl);
+    }
+    JS_FreeValue(ctx, cache);
+
+    /* stream: true | { spill, limit } in bytes */
+    JSValue stream = JS_GetPropertyStr(ctx, opts, "stream");
+    if (JS_IsObject(stream)) {
+        int64_t n;
+        JSValue v = JS_GetPropertyStr(ctx, stream, "spill");
+        if (JS_IsNumber(v) && JS_ToInt64(ctx, &n, v) == 0 && n >= 0)
+            r->stream_spill = n;
+        JS_FreeValue(ctx, v);
+
+        v = JS_GetPropertyStr(ctx, stream, "limit");
+        if (JS_IsNumber(v) && JS_ToInt64(ctx, &n, v) == 0 && n >= 0) {
+            r->stream_limit = n;
+            r->stream_limit_set = 1;
+        }
+        JS_FreeValue(ctx, v);
+        r->stream = 1;
+    } else {
+        r->stream = JS_ToBool(ctx, stream) > 0;
+    }
+    JS_FreeValue(ctx, stream);
+}
+
 static JSValue js_mock_get(JSContext *ctx, JSValueConst this_val,
                            int argc, JSValue *argv) {
     return js_mock_route(ctx, this_val, argc, argv, JS_HTTP_GET);
@@ -751,10 +1495,82 @@ static JSValue js_mock_all(JSContext *ctx, JSValueConst this_val,
     return js_mock_route(ctx, this_val, argc, argv, JS_HTTP_ALL);
 }
 
+/* mock.static(method, path, body, init): collected at startup, see js_qjs.c */
+static JSValue js_mock_static(JSContext *ctx, JSValueConst this_val,
+                              int argc, JSValue *argv) {
+    (void)this_val; (void)argc; (void)argv;
+    js_exec_t *exec = js_web_get_exec(ctx);
+
+    /* captured when the config was read; a handler is too late */
+    if (exec->loaded)
+        return JS_ThrowTypeError(ctx, "mock.static: only allowed at "
+                                 "module top level");
+    return JS_UNDEFINED;
+}
+
+/* ==== mock.stats ==== */
+
+static JSValue js_mock_stats(JSContext *ctx, JSValueConst this_val,
+                             int argc, JSValue *argv) {
+    (void)this_val; (void)argc; (void)argv;
+    js_exec_t *exec = js_web_get_exec(ctx);
+    uint64_t hits, misses;
+    int entries;
+
+    js_cache_stats(&exec->rt->cache, &hits, &misses, &entries);
+    JSValue cache = JS_NewObject(ctx);
+    JS_SetPropertyStr(ctx, cache, "hits", JS_NewInt64(ctx, hits));
+    JS_SetPropertyStr(ctx, cache, "misses", JS_NewInt64(ctx, misses));
+    JS_SetPropertyStr(ctx, cache, "entries", JS_NewInt32(ctx, entries));
+
+    JSValue budget = JS_NewObject(ctx);
+    uint64_t exceeded = __atomic_load_n(&exec->rt->budget_exceeded,
+                                        __ATOMIC_RELAXED);
+    JS_SetPropertyStr(ctx, budget, "exceeded", JS_NewInt64(ctx, exceeded));
+
+    /* this runtime right now, and heap peaks per route over all requests */
+    JSMemoryUsage usage;
+    JS_ComputeMemoryUsage(JS_GetRuntime(ctx), &usage);
+    JSValue memory = JS_NewObject(ctx);
+    uint64_t oom = __atomic_load_n(&exec->rt->memory_exceeded,
+                                   __ATOMIC_RELAXED);
+    JS_SetPropertyStr(ctx, memory, "exceeded", JS_NewInt64(ctx, oom));
+    JS_SetPropertyStr(ctx, memory, "used",
+                      JS_NewInt64(ctx, usage.malloc_size));
+
+    JSValue routes = JS_NewObject(ctx);
+    for (js_route_t *r = exec->rt->routes; r; r = r->next) {
+        js_route_stats_t *st = &r->stats;
+        uint64_t n = __atomic_load_n(&st->requests, __ATOMIC_RELAXED);
+        uint64_t total = __atomic_load_n(&st->heap_total, __ATOMIC_RELAXED);
+        uint64_t peak = __atomic_load_n(&st->heap_peak, __ATOMIC_RELAXED);
+
+        char key[512];
+        snprintf(key, sizeof(key), "%s %s",
+                 r->method == JS_HTTP_ALL ? "ALL"
+                                          : js_http_method_str(r->method),
+                 r->pattern);
+        JSValue rs = JS_NewObject(ctx);
+        JS_SetPropertyStr(ctx, rs, "requests", JS_NewInt64(ctx, n));
+        JS_SetPropertyStr(ctx, rs, "peak", JS_NewInt64(ctx, peak));
+        JS_SetPropertyStr(ctx, rs, "average",
+                          JS_NewInt64(ctx, n ? total / n : 0));
+        JS_SetPropertyStr(ctx, routes, key, rs);
+    }
+    JS_SetPropertyStr(ctx, memory, "routes", routes);
+
+    JSValue stats = JS_NewObject(ctx);
+    JS_SetPropertyStr(ctx, stats, "cache", cache);
+    JS_SetPropertyStr(ctx, stats, "budget", budget);
+    JS_SetPropertyStr(ctx, stats, "memory", memory);
+    return stats;
+}
+
 /* ==== mock.env ==== */
 
-static JSValue js_mock_env(JSContext *ctx, JSValueConst this_val,
-                           int argc, JSValue *argv) {
+/* also bound while the config is read, see js_qjs_register_stubs() */
+JSValue js_web_env(JSContext *ctx, JSValueConst this_val,
+                   int argc, JSValueConst *argv) {
     (void)this_val; (void)argc;
     const char *name = JS_ToCString(ctx, argv[0]);
     if (!name) return JS_EXCEPTION;
@@ -846,132 +1662,204 @@ static JSValue js_console_log(JSContext *ctx, JSValueConst this_val,
 
 /* ==== init: register all Web APIs ==== */
 
+/*
+ * Property tables are static and shared by every context. Methods are
+ * instantiated lazily by QuickJS on first access, so an exec only pays for
+ * the bindings its handlers actually touch.
+ */
+
+static const JSCFunctionListEntry js_headers_proto_funcs[] = {
+    JS_CFUNC_DEF("get", 1, js_headers_get),
+    JS_CFUNC_DEF("set", 2, js_headers_set),
+    JS_CFUNC_DEF("has", 1, js_headers_has),
+    JS_CFUNC_DEF("delete", 1, js_headers_delete),
+};
+
+static const JSCFunctionListEntry js_url_proto_funcs[] = {
+    JS_CGETSET_MAGIC_DEF("href", js_url_get_prop, NULL, 0),
+    JS_CGETSET_MAGIC_DEF("protocol", js_url_get_prop, NULL, 1),
+    JS_CGETSET_MAGIC_DEF("host", js_url_get_prop, NULL, 2),
+    JS_CGETSET_MAGIC_DEF("hostname", js_url_get_prop, NULL, 3),
+    JS_CGETSET_MAGIC_DEF("port", js_url_get_prop, NULL, 4),
+    JS_CGETSET_MAGIC_DEF("pathname", js_url_get_prop, NULL, 5),
+    JS_CGETSET_MAGIC_DEF("search", js_url_get_prop, NULL, 6),
+    JS_CGETSET_MAGIC_DEF("hash", js_url_get_prop, NULL, 7),
+    JS_CGETSET_MAGIC_DEF("searchParams", js_url_get_search_params, NULL, 0),
+};
+
+static const JSCFunctionListEntry js_request_proto_funcs[] = {
+    JS_CGETSET_MAGIC_DEF("method", js_request_get_method, NULL, 0),
+    JS_CGETSET_MAGIC_DEF("url", js_request_get_url, NULL, 0),
+    JS_CGETSET_MAGIC_DEF("headers", js_request_get_headers, NULL, 0),
+    JS_CGETSET_MAGIC_DEF("params", js_request_get_params, NULL, 0),
+    JS_CGETSET_MAGIC_DEF("body", js_request_get_body, NULL, 0),
+    JS_CFUNC_DEF("text", 0, js_request_text),
+    JS_CFUNC_DEF("json", 0, js_request_json),
+    JS_CFUNC_DEF("arrayBuffer", 0, js_request_array_buffer),
+};
+
+static const JSCFunctionListEntry js_request_body_proto_funcs[] = {
+    JS_CFUNC_DEF("read", 0, js_request_body_read),
+    JS_CFUNC_DEF("next", 0, js_request_body_read),
+    JS_CFUNC_DEF("getReader", 0, js_request_body_self),
+    JS_CFUNC_DEF("[Symbol.asyncIterator]", 0, js_request_body_self),
+};
+
+static const JSCFunctionListEntry js_stream_proto_funcs[] = {
+    JS_CFUNC_DEF("read", 0, js_stream_read),
+    JS_CFUNC_DEF("next", 0, js_stream_read),
+    JS_CFUNC_MAGIC_DEF("cancel", 1, js_stream_cancel, 0),
+    JS_CFUNC_MAGIC_DEF("return", 1, js_stream_cancel, 1),
+    JS_CFUNC_DEF("getReader", 0, js_request_body_self),
+    JS_CFUNC_DEF("[Symbol.asyncIterator]", 0, js_request_body_self),
+};
+
+static const JSCFunctionListEntry js_stream_controller_proto_funcs[] = {
+    JS_CFUNC_DEF("enqueue", 1, js_stream_controller_enqueue),
+    JS_CFUNC_DEF("close", 0, js_stream_controller_close),
+    JS_CFUNC_DEF("error", 1, js_stream_controller_error),
+    JS_CGETSET_MAGIC_DEF("desiredSize",
+                         js_stream_controller_get_desired_size, NULL, 0),
+};
+
+static const JSCFunctionListEntry js_textencoder_proto_funcs[] = {
+    JS_CFUNC_DEF("encode", 1, js_textencoder_encode),
+};
+
+static const JSCFunctionListEntry js_textdecoder_proto_funcs[] = {
+    JS_CFUNC_DEF("decode", 1, js_textdecoder_decode),
+};
+
+static const JSCFunctionListEntry js_console_funcs[] = {
+    JS_CFUNC_DEF("log", 1, js_console_log),
+};
+
+static const JSCFunctionListEntry js_store_funcs[] = {
+    JS_CFUNC_DEF("get", 1, js_store_js_get),
+    JS_CFUNC_DEF("set", 2, js_store_js_set),
+    JS_CFUNC_DEF("del", 1, js_store_js_del),
+    JS_CFUNC_DEF("incr", 1, js_store_js_incr),
+    JS_CFUNC_DEF("clear", 0, js_store_js_clear),
+};
+
+static const JSCFunctionListEntry js_mock_funcs[] = {
+    JS_CFUNC_DEF("get", 2, js_mock_get),
+    JS_CFUNC_DEF("post", 2, js_mock_post),
+    JS_CFUNC_DEF("put", 2, js_mock_put),
+    JS_CFUNC_DEF("patch", 2, js_mock_patch),
+    JS_CFUNC_DEF("delete", 2, js_mock_delete),
+    JS_CFUNC_DEF("all", 2, js_mock_all),
+    JS_CFUNC_DEF("env", 1, js_web_env),
+    JS_CFUNC_DEF("static", 4, js_mock_static),
+    JS_CFUNC_DEF("stats", 0, js_mock_stats),
+    JS_OBJECT_DEF("store", js_store_funcs, js_countof(js_store_funcs),
+                  JS_PROP_WRITABLE | JS_PROP_CONFIGURABLE),
+};
+
+static const JSCFunctionListEntry js_global_funcs[] = {
+    JS_OBJECT_DEF("console", js_console_funcs, js_countof(js_console_funcs),
+                  JS_PROP_WRITABLE | JS_PROP_CONFIGURABLE),
+    JS_OBJECT_DEF("mock", js_mock_funcs, js_countof(js_mock_funcs),
+                  JS_PROP_WRITABLE | JS_PROP_CONFIGURABLE),
+    JS_CFUNC_DEF("setTimeout", 2, js_set_timeout),
+};
+
+/*
+ * Allocate class IDs. Called once from main() before worker threads start:
+ * JS_NewClassID() is process-global and not thread-safe.
+ */
+void js_web_global_init(void) {
+    JS_NewClassID(&js_headers_class_id);
+    JS_NewClassID(&js_url_class_id);
+    JS_NewClassID(&js_request_class_id);
+    JS_NewClassID(&js_request_body_class_id);
+    JS_NewClassID(&js_stream_class_id);
+    JS_NewClassID(&js_stream_controller_class_id);
+    JS_NewClassID(&js_response_class_id);
+}
+
+/* Prototype + optional constructor for one class; proto ownership moves. */
+static void js_web_define_class(JSContext *ctx, JSValueConst global,
+                                JSClassID class_id, const char *name,
+                                JSCFunction *ctor, int ctor_len,
+                                const JSCFunctionListEntry *funcs, int count) {
+    JSValue proto = JS_NewObject(ctx);
+    if (count > 0)
+        JS_SetPropertyFunctionList(ctx, proto, funcs, count);
+
+    if (ctor) {
+        JSValue fn = JS_NewCFunction2(ctx, ctor, name, ctor_len,
+                                      JS_CFUNC_constructor, 0);
+        JS_SetConstructor(ctx, fn, proto);
+        JS_SetPropertyStr(ctx, global, name, fn);
+    }
+
+    if (class_id)
+        JS_SetClassProto(ctx, class_id, proto);
+    else
+        JS_FreeValue(ctx, proto);
+}
+
+/* Response alone, for contexts without an exec (config evaluation) */
+void js_web_init_response(JSContext *ctx) {
+    JS_NewClass(JS_GetRuntime(ctx), js_response_class_id, &js_response_class);
+
+    JSValue global = JS_GetGlobalObject(ctx);
+    js_web_define_class(ctx, global, js_response_class_id, "Response",
+                        js_response_ctor, 2, NULL, 0);
+    JS_FreeValue(ctx, global);
+}
+
+int js_web_is_response(JSValueConst val) {
+    return JS_GetOpaque(val, js_response_class_id) != NULL;
+}
+
 void js_web_init(js_exec_t *exec) {
     JSContext *ctx = exec->qctx;
     JSRuntime *rt = exec->qrt;
     JS_SetContextOpaque(ctx, exec);
 
-    JSValue global = JS_GetGlobalObject(ctx);
-
-    /* ---- Headers class ---- */
-    JS_NewClassID(&js_headers_class_id);
+    /* class definitions are per runtime; IDs come from js_web_global_init */
     JS_NewClass(rt, js_headers_class_id, &js_headers_class);
-    JSValue hdrs_proto = JS_NewObject(ctx);
-    JS_SetPropertyStr(ctx, hdrs_proto, "get",
-                      JS_NewCFunction(ctx, js_headers_get, "get", 1));
-    JS_SetPropertyStr(ctx, hdrs_proto, "set",
-                      JS_NewCFunction(ctx, js_headers_set, "set", 2));
-    JS_SetPropertyStr(ctx, hdrs_proto, "has",
-                      JS_NewCFunction(ctx, js_headers_has, "has", 1));
-    JS_SetPropertyStr(ctx, hdrs_proto, "delete",
-                      JS_NewCFunction(ctx, js_headers_delete, "delete", 1));
-    JSValue hdrs_ctor = JS_NewCFunction2(ctx, js_headers_ctor, "Headers", 1,
-                                        JS_CFUNC_constructor, 0);
-    JS_SetConstructor(ctx, hdrs_ctor, hdrs_proto);
-    JS_SetClassProto(ctx, js_headers_class_id, hdrs_proto);
-    JS_SetPropertyStr(ctx, global, "Headers", hdrs_ctor);
-
-    /* ---- URL class ---- */
-    JS_NewClassID(&js_url_class_id);
     JS_NewClass(rt, js_url_class_id, &js_url_class);
-    JSValue url_proto = JS_NewObject(ctx);
-    static const JSCFunctionListEntry url_getters[] = {
-        JS_CGETSET_MAGIC_DEF("href", js_url_get_prop, NULL, 0),
-        JS_CGETSET_MAGIC_DEF("protocol", js_url_get_prop, NULL, 1),
-        JS_CGETSET_MAGIC_DEF("host", js_url_get_prop, NULL, 2),
-        JS_CGETSET_MAGIC_DEF("hostname", js_url_get_prop, NULL, 3),
-        JS_CGETSET_MAGIC_DEF("port", js_url_get_prop, NULL, 4),
-        JS_CGETSET_MAGIC_DEF("pathname", js_url_get_prop, NULL, 5),
-        JS_CGETSET_MAGIC_DEF("search", js_url_get_prop, NULL, 6),
-        JS_CGETSET_MAGIC_DEF("hash", js_url_get_prop, NULL, 7),
-        JS_CGETSET_MAGIC_DEF("searchParams", js_url_get_search_params, NULL, 0),
-    };
-    JS_SetPropertyFunctionList(ctx, url_proto, url_getters,
-                               sizeof(url_getters) / sizeof(url_getters[0]));
-    JSValue url_ctor = JS_NewCFunction2(ctx, js_url_ctor, "URL", 1,
-                                       JS_CFUNC_constructor, 0);
-    JS_SetConstructor(ctx, url_ctor, url_proto);
-    JS_SetClassProto(ctx, js_url_class_id, url_proto);
-    JS_SetPropertyStr(ctx, global, "URL", url_ctor);
-
-    /* ---- Request class ---- */
-    JS_NewClassID(&js_request_class_id);
     JS_NewClass(rt, js_request_class_id, &js_request_class);
-    JSValue req_proto = JS_NewObject(ctx);
-    static const JSCFunctionListEntry req_getters[] = {
-        JS_CGETSET_MAGIC_DEF("method", js_request_get_method, NULL, 0),
-        JS_CGETSET_MAGIC_DEF("url", js_request_get_url, NULL, 0),
-        JS_CGETSET_MAGIC_DEF("headers", js_request_get_headers, NULL, 0),
-        JS_CGETSET_MAGIC_DEF("params", js_request_get_params, NULL, 0),
-    };
-    JS_SetPropertyFunctionList(ctx, req_proto, req_getters,
-                               sizeof(req_getters) / sizeof(req_getters[0]));
-    JS_SetPropertyStr(ctx, req_proto, "text",
-                      JS_NewCFunction(ctx, js_request_text, "text", 0));
-    JS_SetPropertyStr(ctx, req_proto, "json",
-                      JS_NewCFunction(ctx, js_request_json, "json", 0));
-    JS_SetClassProto(ctx, js_request_class_id, req_proto);
-
-    /* ---- Response class ---- */
-    JS_NewClassID(&js_response_class_id);
-    JS_NewClass(rt, js_response_class_id, &js_response_class);
-    JSValue resp_proto = JS_NewObject(ctx);
-    JSValue resp_ctor = JS_NewCFunction2(ctx, js_response_ctor, "Response", 2,
-                                        JS_CFUNC_constructor, 0);
-    JS_SetConstructor(ctx, resp_ctor, resp_proto);
-    JS_SetClassProto(ctx, js_response_class_id, resp_proto);
-    JS_SetPropertyStr(ctx, global, "Response", resp_ctor);
-
-    /* ---- TextEncoder: new TextEncoder().encode(str) ---- */
-    JSValue te_proto = JS_NewObject(ctx);
-    JS_SetPropertyStr(ctx, te_proto, "encode",
-                      JS_NewCFunction(ctx, js_textencoder_encode, "encode", 1));
-    JSValue te_ctor = JS_NewCFunction2(ctx, js_textencoder_ctor, "TextEncoder", 0,
-                                       JS_CFUNC_constructor, 0);
-    JS_SetConstructor(ctx, te_ctor, te_proto);
-    JS_SetPropertyStr(ctx, global, "TextEncoder", te_ctor);
-    JS_FreeValue(ctx, te_proto);
-
-    /* ---- TextDecoder: new TextDecoder().decode(bytes) ---- */
-    JSValue td_proto = JS_NewObject(ctx);
-    JS_SetPropertyStr(ctx, td_proto, "decode",
-                      JS_NewCFunction(ctx, js_textdecoder_decode, "decode", 1));
-    JSValue td_ctor = JS_NewCFunction2(ctx, js_textdecoder_ctor, "TextDecoder", 0,
-                                       JS_CFUNC_constructor, 0);
-    JS_SetConstructor(ctx, td_ctor, td_proto);
-    JS_SetPropertyStr(ctx, global, "TextDecoder", td_ctor);
-    JS_FreeValue(ctx, td_proto);
-
-    /* ---- console ---- */
-    JSValue console = JS_NewObject(ctx);
-    JS_SetPropertyStr(ctx, console, "log",
-                      JS_NewCFunction(ctx, js_console_log, "log", 1));
-    JS_SetPropertyStr(ctx, global, "console", console);
-
-    /* ---- mock object ---- */
-    JSValue mock = JS_NewObject(ctx);
-    JS_SetPropertyStr(ctx, mock, "get", JS_NewCFunction(ctx, js_mock_get, "get", 2));
-    JS_SetPropertyStr(ctx, mock, "post", JS_NewCFunction(ctx, js_mock_post, "post", 2));
-    JS_SetPropertyStr(ctx, mock, "put", JS_NewCFunction(ctx, js_mock_put, "put", 2));
-    JS_SetPropertyStr(ctx, mock, "patch", JS_NewCFunction(ctx, js_mock_patch, "patch", 2));
-    JS_SetPropertyStr(ctx, mock, "delete", JS_NewCFunction(ctx, js_mock_delete, "delete", 2));
-    JS_SetPropertyStr(ctx, mock, "all", JS_NewCFunction(ctx, js_mock_all, "all", 2));
-    JS_SetPropertyStr(ctx, mock, "env", JS_NewCFunction(ctx, js_mock_env, "env", 1));
-
-    /* ---- mock.store ---- */
-    JSValue store = JS_NewObject(ctx);
-    JS_SetPropertyStr(ctx, store, "get", JS_NewCFunction(ctx, js_store_js_get, "get", 1));
-    JS_SetPropertyStr(ctx, store, "set", JS_NewCFunction(ctx, js_store_js_set, "set", 2));
-    JS_SetPropertyStr(ctx, store, "del", JS_NewCFunction(ctx, js_store_js_del, "del", 1));
-    JS_SetPropertyStr(ctx, store, "incr", JS_NewCFunction(ctx, js_store_js_incr, "incr", 1));
-    JS_SetPropertyStr(ctx, store, "clear", JS_NewCFunction(ctx, js_store_js_clear, "clear", 0));
-    JS_SetPropertyStr(ctx, mock, "store", store);
-
-    JS_SetPropertyStr(ctx, global, "mock", mock);
-
-    /* ---- setTimeout ---- */
-    JS_SetPropertyStr(ctx, global, "setTimeout",
-                      JS_NewCFunction(ctx, js_set_timeout, "setTimeout", 2));
+    JS_NewClass(rt, js_request_body_class_id, &js_request_body_class);
+    JS_NewClass(rt, js_stream_class_id, &js_stream_class);
+    JS_NewClass(rt, js_stream_controller_class_id,
+                &js_stream_controller_class);
+
+    JSValue global = JS_GetGlobalObject(ctx);
+
+    js_web_define_class(ctx, global, js_headers_class_id, "Headers",
+                        js_headers_ctor, 1, js_headers_proto_funcs,
+                        js_countof(js_headers_proto_funcs));
+    js_web_define_class(ctx, global, js_url_class_id, "URL",
+                        js_url_ctor, 1, js_url_proto_funcs,
+                        js_countof(js_url_proto_funcs));
+    js_web_define_class(ctx, global, js_request_class_id, "Request",
+                        NULL, 0, js_request_proto_funcs,
+                        js_countof(js_request_proto_funcs));
+    js_web_define_class(ctx, global, js_request_body_class_id, "RequestBody",
+                        NULL, 0, js_request_body_proto_funcs,
+                        js_countof(js_request_body_proto_funcs));
+    js_web_define_class(ctx, global, js_stream_class_id, "ReadableStream",
+                        js_stream_ctor, 1, js_stream_proto_funcs,
+                        js_countof(js_stream_proto_funcs));
+    js_web_define_class(ctx, global, js_stream_controller_class_id,
+                        "ReadableStreamDefaultController", NULL, 0,
+                        js_stream_controller_proto_funcs,
+                        js_countof(js_stream_controller_proto_funcs));
+    js_web_init_response(ctx);
+    js_web_define_class(ctx, global, 0, "TextEncoder",
+                        js_textencoder_ctor, 0, js_textencoder_proto_funcs,
+                        js_countof(js_textencoder_proto_funcs));
+    js_web_define_class(ctx, global, 0, "TextDecoder",
+                        js_textdecoder_ctor, 0, js_textdecoder_proto_funcs,
+                        js_countof(js_textdecoder_proto_funcs));
+
+    /* console, mock, mock.store, setTimeout */
+    JS_SetPropertyFunctionList(ctx, global, js_global_funcs,
+                               js_countof(js_global_funcs));
 
     JS_FreeValue(ctx, global);
 }
@@ -981,9 +1869,13 @@ int js_web_read_response(JSContext *ctx, JSValue val, js_http_response_t *resp)
     if (!d)
         return -1;
 
+    /* the body is shared, not copied: it outlives the Response if need be */
     resp->status = d->status;
-    resp->body = d->body ? strdup(d->body) : NULL;
-    resp->body_len = d->body_len;
+    if (d->body) {
+        resp->body_ref = js_rcbuf_ref(d->body);
+        resp->body = resp->body_ref->data;
+        resp->body_len = resp->body_ref->len;
+    }
 
     if (d->header_count > 0) {
         resp->headers = calloc(d->header_count, sizeof(js_header_t));
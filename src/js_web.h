@@ -12,16 +12,39 @@ typedef struct {
     size_t       body_len;
     js_param_t  *params;
     int          param_count;
+    int          streamed;      /* body arrives through exec->body */
 } JSRequestData;
 
 typedef struct {
     int          status;
     js_header_t *headers;
     int          header_count;
-    char        *body;
-    size_t       body_len;
+    js_rcbuf_t  *body;          /* lent to every js_http_response_t read */
+    JSValue      stream;        /* ReadableStream or async iterable body */
 } JSResponseData;
 
+/*
+ * ReadableStream fed by an underlying source { start, pull, cancel }.
+ * Chunks wait in queue until read; one read may be pending at a time.
+ */
+typedef struct {
+    JSValue      source;
+    JSValue      controller;
+    JSValue     *queue;
+    int          queue_len;
+    int          queue_cap;
+    int          closed;
+    int          errored;
+    JSValue      error;
+    int          pulling;       /* start() or pull() not settled yet */
+    int          pull_again;    /* a read wanted a pull meanwhile */
+    JSValue      wait[2];       /* resolve/reject of the pending read */
+} JSReadableStreamData;
+
+typedef struct {
+    JSValue      stream;        /* the ReadableStream it feeds */
+} JSStreamControllerData;
+
 typedef struct {
     js_header_t *entries;
     int          count;
@@ -41,9 +64,23 @@ typedef struct {
 
 /* ---- api ---- */
 
+void    js_web_global_init(void);
 void    js_web_init(js_exec_t *exec);
+void    js_web_init_response(JSContext *ctx);
+int     js_web_is_response(JSValueConst val);
+void    js_web_route_options(JSContext *ctx, JSValueConst opts, js_route_t *r);
+void    js_web_read_budget(JSContext *ctx, JSValueConst val, int *ms,
+                           int *status);
 JSValue js_web_new_request(JSContext *ctx, js_http_request_t *req,
                            js_param_t *params, int param_count);
 int     js_web_read_response(JSContext *ctx, JSValue val, js_http_response_t *resp);
+void    js_web_body_settle(js_exec_t *exec);
+int     js_web_response_stream(JSContext *ctx, JSValueConst val,
+                               JSValue *src, JSValue *next);
+const uint8_t *js_web_chunk(JSContext *ctx, JSValueConst val, size_t *len,
+                            const char **str);
+void    js_web_body_detach(js_exec_t *exec);
+JSValue js_web_env(JSContext *ctx, JSValueConst this_val,
+                   int argc, JSValueConst *argv);
 
 #endif
@@ -0,0 +1,102 @@
+#include "js_main.h"
+
+/* ---- job queue ---- */
+
+static void js_jobq_on_read(js_event_t *ev) {
+    js_jobq_t *q = js_event_data(ev, js_jobq_t, event);
+    uint64_t n;
+
+    /* reset the eventfd before taking the list, so no push is missed */
+    if (read(ev->fd, &n, sizeof(n)) < 0 && errno != EAGAIN)
+        return;
+
+    /* handlers may close connections other events of this round refer to */
+    js_engine_post(q->engine, &q->posted);
+}
+
+static void js_jobq_run(js_event_t *ev) {
+    js_jobq_t *q = js_event_data(ev, js_jobq_t, posted);
+
+    js_job_t *job = __atomic_exchange_n(&q->head, NULL, __ATOMIC_ACQUIRE);
+
+    /* the list is newest first; restore submission order */
+    js_job_t *fifo = NULL;
+    while (job) {
+        js_job_t *next = job->next;
+        job->next = fifo;
+        fifo = job;
+        job = next;
+    }
+
+    while (fifo) {
+        js_job_t *next = fifo->next;
+        q->handler(fifo);
+        fifo = next;
+    }
+}
+
+int js_jobq_init(js_jobq_t *q, js_job_handler_t handler) {
+    q->head = NULL;
+    q->handler = handler;
+    q->event.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    q->event.read = js_jobq_on_read;
+    q->event.write = NULL;
+    memset(&q->posted, 0, sizeof(q->posted));
+    q->posted.fd = -1;
+    q->posted.read = js_jobq_run;
+    q->engine = NULL;
+    return q->event.fd < 0 ? -1 : 0;
+}
+
+/* called on the consumer thread: deliver wakeups to its event loop */
+int js_jobq_start(js_jobq_t *q, js_engine_t *eng) {
+    q->engine = eng;
+    return js_engine_add(eng, q->event.fd, EPOLLIN, &q->event);
+}
+
+/* any thread; only the push that finds the queue empty signals */
+void js_jobq_push(js_jobq_t *q, js_job_t *job) {
+    js_job_t *head = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+    do {
+        job->next = head;
+    } while (!__atomic_compare_exchange_n(&q->head, &head, job, 1,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    if (head == NULL) {
+        uint64_t one = 1;
+        ssize_t n = write(q->event.fd, &one, sizeof(one));
+        (void) n;   /* only fails when the counter is saturated */
+    }
+}
+
+void js_jobq_free(js_jobq_t *q) {
+    if (q->event.fd >= 0)
+        close(q->event.fd);
+    q->event.fd = -1;
+}
+
+/* ---- workers ---- */
+
+/* I/O thread: round-robin over the workers, replies come back to us */
+void js_worker_submit(js_runtime_t *rt, js_job_t *job) {
+    js_thread_t *t = js_thread_current;
+    js_thread_t *w = rt->workers[t->next_worker++ % rt->worker_count];
+
+    job->reply = &t->jobs;
+    js_jobq_push(&w->jobs, job);
+}
+
+/* worker thread: js_jobq_t handler for submitted requests */
+void js_worker_run(js_job_t *job) {
+    js_runtime_t *rt = js_thread_current->rt;
+
+    int rc = js_qjs_handle_request(rt, &job->req, &job->resp, job->conn, job);
+
+    /* async handlers finish later through js_pending_finish() */
+    if (rc == 0)
+        js_worker_done(job);
+}
+
+void js_worker_done(js_job_t *job) {
+    js_jobq_push(job->reply, job);
+}
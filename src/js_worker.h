@@ -0,0 +1,49 @@
+#ifndef JS_WORKER_H
+#define JS_WORKER_H
+
+/*
+ * Optional JS executor threads (export default { workers }). I/O threads
+ * parse requests and hand them to a worker as jobs; the worker runs the
+ * handler and hands the job back to the I/O thread that owns the
+ * connection. Both directions use js_jobq_t: a lock-free multi-producer
+ * list drained by a single consumer, woken through an eventfd.
+ */
+
+/* forward declarations */
+struct js_runtime_s;
+typedef struct js_job_s js_job_t;
+
+typedef void (*js_job_handler_t)(js_job_t *job);
+
+/* ---- struct ---- */
+
+typedef struct {
+    js_job_t          *head;      /* newest first, pushed with CAS */
+    js_event_t         event;     /* eventfd, readable once non-empty */
+    js_event_t         posted;    /* runs the handlers after the round */
+    js_engine_t       *engine;
+    js_job_handler_t   handler;   /* runs on the consumer thread */
+} js_jobq_t;
+
+struct js_job_s {
+    js_conn_t           *conn;    /* owned by the I/O thread; workers never touch it */
+    js_jobq_t           *reply;   /* completion queue of that I/O thread */
+    js_http_request_t    req;     /* slices of detached, or of conn->rbuf */
+    char                *detached;  /* req's bytes, copied out of rbuf */
+    js_http_response_t   resp;    /* filled by the worker */
+    js_cache_slot_t      slot;
+    js_job_t            *next;
+};
+
+/* ---- api ---- */
+
+int  js_jobq_init(js_jobq_t *q, js_job_handler_t handler);
+int  js_jobq_start(js_jobq_t *q, js_engine_t *eng);
+void js_jobq_push(js_jobq_t *q, js_job_t *job);
+void js_jobq_free(js_jobq_t *q);
+
+void js_worker_submit(struct js_runtime_s *rt, js_job_t *job);
+void js_worker_run(js_job_t *job);
+void js_worker_done(js_job_t *job);
+
+#endif
@@ -0,0 +1,18 @@
+mock.post("/echo", (req) => new Response(req.arrayBuffer()));
+mock.post("/len", (req) => new Response(String(req.arrayBuffer().byteLength)));
+mock.post("/textlen", (req) => new Response(String(req.text().length)));
+
+mock.post("/stream-echo", async (req) => new Response(await req.arrayBuffer()),
+          { stream: true });
+
+mock.get("/png", () => new Response(
+    new Uint8Array([0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0, 0]),
+    { headers: { "Content-Type": "image/png" } }));
+mock.get("/view", () =>
+    new Response(new Uint8Array([1, 2, 3, 4, 5]).subarray(1, 3)));
+mock.get("/buffer", () => new Response(new Uint8Array([0, 0, 7]).buffer));
+
+export default {
+    listen: 18107,
+    workers: Number(mock.env("WORKERS")) || 0,
+};
@@ -0,0 +1,27 @@
+mock.get("/spin", () => {
+    for (;;) {}
+});
+
+mock.get("/catch", () => {
+    try {
+        for (;;) {}
+    } catch (e) {
+        return new Response("caught");
+    }
+});
+
+mock.get("/route", () => {
+    for (;;) {}
+}, { budget: { ms: 50, status: 504 } });
+
+mock.get("/async", () => new Promise(() => {
+    setTimeout(() => {
+        for (;;) {}
+    }, 10);
+}));
+
+mock.get("/ok", () => new Response("ok"));
+
+mock.get("/stats", () => new Response(String(mock.stats().budget.exceeded)));
+
+export default { listen: 18098, budget: 100 };
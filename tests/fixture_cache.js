@@ -0,0 +1,17 @@
+mock.get("/rand", () => new Response(String(Math.random())),
+         { cache: { ttl: 60000 } });
+mock.get("/short", () => new Response(String(Math.random())),
+         { cache: { ttl: 200 } });
+mock.get("/nocache", () => new Response(String(Math.random())));
+
+mock.post("/bump", () => {
+    mock.store.incr("bumps");
+    return new Response("bumped");
+});
+
+mock.get("/stats", () => {
+    const s = mock.stats().cache;
+    return new Response(s.hits + " " + s.misses);
+});
+
+export default { listen: 18097 };
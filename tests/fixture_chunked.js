@@ -0,0 +1,8 @@
+mock.post("/echo", async (req) => {
+    const body = await req.text();
+    return new Response(body.length + ":" + body);
+});
+
+mock.get("/ping", () => new Response("pong"));
+
+export default { listen: 18103, limits: { body: 1024 } };
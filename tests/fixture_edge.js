@@ -0,0 +1,24 @@
+mock.get("/ping", () => new Response("pong"));
+mock.get("/n", (req) => new Response(new URL(req.url).search.slice(1) + ";"));
+mock.get("/delay", async () => {
+    await new Promise((resolve) => setTimeout(resolve, 100));
+    return new Response("late");
+});
+mock.get("/big", () => new Response("x".repeat(1000000)));
+mock.post("/size", (req) => new Response(String(req.arrayBuffer().byteLength)));
+mock.post("/upload", async (req) => {
+    let size = 0;
+    for await (const chunk of req.body) size += chunk.length;
+    return new Response(String(size));
+}, { stream: true });
+mock.get("/stream", () => new Response((async function* () {
+    for (let i = 0; i < 50; i++) yield "y".repeat(10000);
+})()));
+
+export default {
+    listen: 18109,
+    threads: 2,
+    events: mock.env("EVENTS") || "edge",
+    engine: mock.env("ENGINE") || "epoll",
+    workers: Number(mock.env("WORKERS")) || 0,
+};
@@ -0,0 +1,23 @@
+let hits = 0;
+
+// top-level code: runs once per worker thread at startup
+mock.store.incr("evals");
+
+mock.get("/hits", (req) => {
+    hits++;
+    return new Response(String(hits));
+});
+
+mock.get("/delayed-hits", async (req) => {
+    hits++;
+    const n = hits;
+    return new Promise((resolve) => {
+        setTimeout(() => resolve(new Response(String(n))), 50);
+    });
+});
+
+mock.get("/evals", (req) => {
+    return new Response(JSON.stringify(mock.store.get("evals")));
+});
+
+export default { listen: 18094, isolation: "thread" };
@@ -0,0 +1,8 @@
+let hits = 0;
+
+mock.get("/hits", (req) => {
+    hits++;
+    return new Response(String(hits));
+});
+
+export default { listen: 18095 };
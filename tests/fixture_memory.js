@@ -0,0 +1,28 @@
+function hog() {
+    const chunks = [];
+    for (;;)
+        chunks.push(new Array(100000).fill(chunks.length));
+}
+
+mock.get("/hog", () => {
+    hog();
+});
+
+mock.get("/catch", () => {
+    try {
+        hog();
+    } catch (e) {
+        return new Response("caught");
+    }
+});
+
+mock.get("/ok", () => new Response("ok"));
+
+mock.get("/stats", () => {
+    const m = mock.stats().memory;
+    const ok = m.routes["GET /ok"];
+    return new Response(m.exceeded + " " + ok.requests + " "
+                        + (ok.peak > 0) + " " + (ok.average <= ok.peak));
+});
+
+export default { listen: 18099, limits: { memory: 32 * 1024 * 1024 } };
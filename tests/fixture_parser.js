@@ -0,0 +1,9 @@
+mock.get("/echo", (req) => {
+    const url = new URL(req.url);
+    return new Response(url.pathname + "|" + url.search + "|" +
+                        (req.headers.get("x-tag") || "-"));
+});
+
+mock.post("/body", async (req) => new Response("len:" + (await req.text()).length));
+
+export default { listen: 18101 };
@@ -0,0 +1,14 @@
+mock.get("/n", (req) => new Response(new URL(req.url).search.slice(1) + ";"));
+mock.get("/cached", () => new Response("c;"), { cache: { ttl: 60000 } });
+mock.static("GET", "/static", "s;");
+mock.get("/big", () => new Response("x".repeat(100000)));
+mock.get("/delay", async (req) => {
+    const ms = Number(new URL(req.url).search.slice(1));
+    await new Promise((resolve) => setTimeout(resolve, ms));
+    return new Response("d" + ms + ";");
+});
+
+export default {
+    listen: 18108,
+    workers: Number(mock.env("WORKERS")) || 0,
+};
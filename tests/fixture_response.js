@@ -16,4 +16,23 @@ mock.get("/custom", (req) => {
     });
 });
 
+mock.get("/bad-status", (req) => {
+    const status = Number(new URL(req.url).search.slice(1));
+    try {
+        return new Response("kept", { status });
+    } catch (e) {
+        return new Response(e.name, { status: 400 });
+    }
+});
+
+mock.get("/bad-body", () => {
+    try {
+        return new Response({ toString() { throw new Error("no body"); } });
+    } catch (e) {
+        return new Response("caught: " + e.message, { status: 400 });
+    }
+});
+
+mock.get("/not-response", () => "just a string");
+
 export default { listen: 18085 };
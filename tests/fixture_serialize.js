@@ -0,0 +1,19 @@
+const long = "v".repeat(1000);
+const big = "0123456789abcdef".repeat(1 << 16);
+
+mock.get("/long", () => new Response("ok", { headers: { "X-Long": long } }));
+mock.get("/teapot", () => new Response("short and stout", { status: 418 }));
+mock.get("/unprocessable", () => new Response("no", { status: 422 }));
+mock.get("/odd", () => new Response("odd", { status: 599 }));
+mock.get("/big", () => new Response(big));
+
+// outlives the request: the body is shared with the write, not handed over
+let kept;
+mock.get("/kept", () => (kept = new Response(big)));
+mock.get("/cached", () => new Response("cached"), { cache: { ttl: 60000 } });
+mock.static("GET", "/static", "constant");
+
+export default {
+    listen: 18106,
+    workers: Number(mock.env("WORKERS")) || 0,
+};
@@ -0,0 +1,9 @@
+mock.get("/headers", (req) => new Response(
+    req.headers.get("cookie").length + "|" +
+    req.headers.get("traceparent") + "|" +
+    req.headers.get("x-last")));
+
+mock.post("/body", async (req) => new Response(
+    req.headers.get("content-type") + "|" + (await req.text())));
+
+export default { listen: 18102 };
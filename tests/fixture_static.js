@@ -0,0 +1,16 @@
+const health = new Response("ok", { headers: { "X-Kind": "constant" } });
+
+mock.static("GET", "/static", "hello static", {
+    status: 201,
+    headers: { "Content-Type": "text/plain" },
+});
+mock.get("/health", health);
+mock.get("/dynamic", () => new Response("dynamic"));
+
+mock.static("GET", "/shadow", "from static");
+mock.get("/shadow", () => new Response("from js"));
+
+mock.static("POST", "/only-post", "posted");
+mock.static("GET", "/users/:id", "any user");
+
+export default { listen: 18096 };
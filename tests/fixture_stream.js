@@ -0,0 +1,39 @@
+mock.post("/iter", async (req) => {
+    let n = 0, chunks = 0;
+    for await (const chunk of req.body) {
+        n += chunk.length;
+        chunks++;
+    }
+    return new Response(n + ":" + (chunks > 0));
+}, { stream: true });
+
+mock.post("/text", async (req) => new Response(await req.text()),
+          { stream: true });
+
+mock.post("/reader", async (req) => {
+    const reader = req.body.getReader();
+    let sum = 0;
+    for (;;) {
+        const { done, value } = await reader.read();
+        if (done)
+            break;
+        for (let i = 0; i < value.length; i++)
+            sum = (sum + value[i]) % 65536;
+    }
+    return new Response(String(sum));
+}, { stream: { spill: 4096, limit: 4 * 1024 * 1024 } });
+
+mock.post("/buffered", (req) => new Response(String(req.body === null) + ":" + req.text()));
+
+mock.get("/ping", () => new Response("pong"));
+mock.get("/delay", async () => {
+    await new Promise((resolve) => setTimeout(resolve, 200));
+    return new Response("delayed");
+});
+
+export default {
+    listen: 18104,
+    threads: 1,
+    workers: Number(mock.env("WORKERS")) || 0,
+    limits: { body: 3584 * 1024 },
+};
@@ -0,0 +1,65 @@
+async function* parts() {
+    yield "a";
+    await null;
+    yield "b";
+    yield new TextEncoder().encode("c");
+}
+
+mock.get("/gen", () => new Response(parts(), {
+    headers: { "Content-Type": "text/plain" },
+}));
+
+mock.get("/enqueue", () => new Response(new ReadableStream({
+    start(controller) {
+        controller.enqueue("hello ");
+        controller.enqueue("stream");
+        controller.close();
+    },
+})));
+
+// 16 MB pulled 64 KB at a time, only as fast as the client reads
+mock.get("/big", () => {
+    const chunk = new Uint8Array(65536).fill(120);
+    let left = 256;
+    return new Response(new ReadableStream({
+        pull(controller) {
+            if (left-- > 0)
+                controller.enqueue(chunk);
+            else
+                controller.close();
+        },
+    }));
+});
+
+mock.get("/slow", () => {
+    let n = 0;
+    return new Response(new ReadableStream({
+        start(controller) {
+            controller.enqueue("first ");
+            const tick = () => {
+                if (++n < 3) {
+                    controller.enqueue(n + " ");
+                    setTimeout(tick, 200);
+                } else {
+                    controller.close();
+                }
+            };
+            setTimeout(tick, 200);
+        },
+    }));
+});
+
+mock.get("/broken", () => new Response(new ReadableStream({
+    start(controller) {
+        controller.enqueue("partial");
+        setTimeout(() => controller.error(new Error("boom")), 50);
+    },
+})));
+
+mock.get("/ping", () => new Response("pong"));
+
+export default {
+    listen: 18105,
+    threads: 1,
+    workers: Number(mock.env("WORKERS")) || 0,
+};
@@ -0,0 +1,22 @@
+function spin(ms) {
+    const end = Date.now() + ms;
+    while (Date.now() < end) {}
+}
+
+mock.get("/slow", () => {
+    spin(500);
+    return new Response("slow");
+});
+
+mock.get("/fast", () => new Response("fast"));
+
+mock.get("/users/:id", (req) => new Response("user:" + req.params.id));
+
+mock.get("/delayed", () => new Promise((resolve) => {
+    setTimeout(() => resolve(new Response("delayed")), 50);
+}));
+
+mock.get("/cached", () => new Response(String(Math.random())),
+         { cache: { ttl: 60000 } });
+
+export default { listen: 18100, threads: 1, workers: 2 };
@@ -0,0 +1,79 @@
+#!/bin/bash
+# Test: binary bodies - NUL bytes, req.arrayBuffer(), typed array responses
+
+JSMOCK="$(dirname "$0")/../jsmock"
+PASS=0
+FAIL=0
+TESTS=0
+
+assert_eq() {
+    local desc="$1" expected="$2" actual="$3"
+    TESTS=$((TESTS + 1))
+    if [ "$expected" = "$actual" ]; then
+        echo "  PASS: $desc"
+        PASS=$((PASS + 1))
+    else
+        echo "  FAIL: $desc (expected='$expected', got='$actual')"
+        FAIL=$((FAIL + 1))
+    fi
+}
+
+stop_server() {
+    if [ -n "$PID" ]; then
+        kill "$PID" 2>/dev/null
+        wait "$PID" 2>/dev/null || true
+        PID=
+    fi
+}
+DATA=$(mktemp)
+trap 'stop_server; rm -f "$DATA"' EXIT
+head -c 200000 /dev/urandom > "$DATA"
+printf 'a\0b' >> "$DATA"
+WANT=$(md5sum < "$DATA" | cut -d' ' -f1)
+SIZE=$(stat -c %s "$DATA")
+
+BASE="http://127.0.0.1:18107"
+
+hex() {
+    curl -s --max-time 5 "$BASE$1" | od -An -tx1 | tr -d ' \n'
+}
+
+run_suite() {
+    local mode="$1"
+
+    SUM=$(curl -s --max-time 10 --data-binary @"$DATA" "$BASE/echo" \
+          | md5sum | cut -d' ' -f1)
+    assert_eq "echo keeps NUL bytes ($mode)" "$WANT" "$SUM"
+
+    LEN=$(curl -s --max-time 10 --data-binary @"$DATA" "$BASE/len")
+    assert_eq "arrayBuffer().byteLength ($mode)" "$SIZE" "$LEN"
+
+    LEN=$(printf 'a\0b' | curl -s --max-time 5 --data-binary @- "$BASE/textlen")
+    assert_eq "text() past a NUL ($mode)" "3" "$LEN"
+
+    SUM=$(curl -s --max-time 10 --data-binary @"$DATA" "$BASE/stream-echo" \
+          | md5sum | cut -d' ' -f1)
+    assert_eq "streamed arrayBuffer() ($mode)" "$WANT" "$SUM"
+
+    assert_eq "Uint8Array body ($mode)" "89504e470d0a1a0a0000" "$(hex /png)"
+    assert_eq "subarray body ($mode)" "0203" "$(hex /view)"
+    assert_eq "ArrayBuffer body ($mode)" "000007" "$(hex /buffer)"
+}
+
+echo "=== test_binary ==="
+
+$JSMOCK "$(dirname "$0")/fixture_binary.js" 2>/dev/null &
+PID=$!
+sleep 1
+run_suite inline
+stop_server
+
+WORKERS=2 $JSMOCK "$(dirname "$0")/fixture_binary.js" 2>/dev/null &
+PID=$!
+sleep 1
+run_suite workers
+
+# --- Summary ---
+echo ""
+echo "test_binary: $PASS/$TESTS passed"
+[ "$FAIL" -eq 0 ] || exit 1
@@ -0,0 +1,65 @@
+#!/bin/bash
+# Test: handlers are interrupted once they exceed their JS time budget
+
+JSMOCK="$(dirname "$0")/../jsmock"
+PASS=0
+FAIL=0
+TESTS=0
+
+assert_eq() {
+    local desc="$1" expected="$2" actual="$3"
+    TESTS=$((TESTS + 1))
+    if [ "$expected" = "$actual" ]; then
+        echo "  PASS: $desc"
+        PASS=$((PASS + 1))
+    else
+        echo "  FAIL: $desc (expected='$expected', got='$actual')"
+        FAIL=$((FAIL + 1))
+    fi
+}
+
+stop_server() {
+    if [ -n "$PID" ]; then
+        kill "$PID" 2>/dev/null
+        wait "$PID" 2>/dev/null || true
+        PID=
+    fi
+}
+trap stop_server EXIT
+
+echo "=== test_budget ==="
+
+$JSMOCK "$(dirname "$0")/fixture_budget.js" 2>/dev/null &
+PID=$!
+sleep 1
+
+BASE="http://127.0.0.1:18098"
+
+# --- an endless loop is cut off with the global status ---
+CODE=$(curl -s --max-time 5 -o /dev/null -w '%{http_code}' "$BASE/spin")
+assert_eq "global budget answers 503" "503" "$CODE"
+
+# --- try/catch cannot swallow the interrupt ---
+CODE=$(curl -s --max-time 5 -o /dev/null -w '%{http_code}' "$BASE/catch")
+assert_eq "interrupt is uncatchable" "503" "$CODE"
+
+# --- per-route budget and status ---
+CODE=$(curl -s --max-time 5 -o /dev/null -w '%{http_code}' "$BASE/route")
+assert_eq "route budget answers 504" "504" "$CODE"
+
+# --- timer callbacks are charged to the request ---
+CODE=$(curl -s --max-time 5 -o /dev/null -w '%{http_code}' "$BASE/async")
+assert_eq "timer callback interrupted" "503" "$CODE"
+
+# --- the worker thread keeps serving ---
+BODY=$(curl -s --max-time 5 "$BASE/ok")
+assert_eq "server still responds" "ok" "$BODY"
+
+# --- counter ---
+BODY=$(curl -s --max-time 5 "$BASE/stats")
+assert_eq "exceeded counted" "4" "$BODY"
+
+# --- Summary ---
+echo ""
+echo "test_budget: $PASS/$TESTS passed"
+[ "$FAIL" -eq 0 ] || exit 1
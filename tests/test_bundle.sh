@@ -0,0 +1,100 @@
+#!/bin/bash
+# Test: jsmock compile and .jsbc startup
+
+JSMOCK="$(dirname "$0")/../jsmock"
+PASS=0
+FAIL=0
+TESTS=0
+
+assert_eq() {
+    local desc="$1" expected="$2" actual="$3"
+    TESTS=$((TESTS + 1))
+    if [ "$expected" = "$actual" ]; then
+        echo "  PASS: $desc"
+        PASS=$((PASS + 1))
+    else
+        echo "  FAIL: $desc (expected='$expected', got='$actual')"
+        FAIL=$((FAIL + 1))
+    fi
+}
+
+stop_server() {
+    if [ -n "$PID" ]; then
+        kill "$PID" 2>/dev/null
+        wait "$PID" 2>/dev/null || true
+        PID=
+    fi
+}
+cleanup() {
+    stop_server
+    rm -rf "$TMPDIR_BC"
+}
+trap cleanup EXIT
+
+echo "=== test_bundle ==="
+
+TMPDIR_BC=$(mktemp -d)
+cp "$(dirname "$0")/fixture_module.js" "$(dirname "$0")/helper_module.js" "$TMPDIR_BC"
+BASE="http://127.0.0.1:18088"
+
+# --- compile writes <script>.jsbc by default ---
+$JSMOCK compile "$TMPDIR_BC/fixture_module.js" 2>/dev/null
+assert_eq "compile exits 0" "0" "$?"
+[ -f "$TMPDIR_BC/fixture_module.jsbc" ] && OK=yes || OK=no
+assert_eq "default output path" "yes" "$OK"
+
+# --- -o picks the output path ---
+$JSMOCK compile "$TMPDIR_BC/fixture_module.js" -o "$TMPDIR_BC/mock.jsbc" 2>/dev/null
+[ -f "$TMPDIR_BC/mock.jsbc" ] && OK=yes || OK=no
+assert_eq "compile -o" "yes" "$OK"
+
+# --- serve from the bundle ---
+$JSMOCK "$TMPDIR_BC/mock.jsbc" 2>/dev/null &
+PID=$!
+sleep 1
+BODY=$(curl -sf "$BASE/greet/bundle")
+assert_eq "serve from bundle" "hello bundle" "$BODY"
+stop_server
+
+# --- sources are optional once compiled ---
+mv "$TMPDIR_BC/fixture_module.js" "$TMPDIR_BC/fixture_module.js.bak"
+mv "$TMPDIR_BC/helper_module.js" "$TMPDIR_BC/helper_module.js.bak"
+$JSMOCK "$TMPDIR_BC/mock.jsbc" 2>/dev/null &
+PID=$!
+sleep 1
+BODY=$(curl -sf "$BASE/greet/nosrc")
+assert_eq "serve without sources" "hello nosrc" "$BODY"
+stop_server
+mv "$TMPDIR_BC/fixture_module.js.bak" "$TMPDIR_BC/fixture_module.js"
+
+# --- a changed import invalidates the bundle ---
+sed 's/hello /hi /' "$TMPDIR_BC/helper_module.js.bak" > "$TMPDIR_BC/helper_module.js"
+$JSMOCK "$TMPDIR_BC/mock.jsbc" 2>/dev/null &
+PID=$!
+sleep 1
+BODY=$(curl -sf "$BASE/greet/stale")
+assert_eq "stale bundle is recompiled" "hi stale" "$BODY"
+stop_server
+
+# --- build produces a standalone executable ---
+$JSMOCK build "$TMPDIR_BC/fixture_module.js" -o "$TMPDIR_BC/greet-mock" 2>/dev/null
+[ -x "$TMPDIR_BC/greet-mock" ] && OK=yes || OK=no
+assert_eq "build output is executable" "yes" "$OK"
+
+rm -f "$TMPDIR_BC/fixture_module.js" "$TMPDIR_BC/helper_module.js"
+(cd / && "$TMPDIR_BC/greet-mock" 2>/dev/null) &
+PID=$!
+sleep 1
+BODY=$(curl -sf "$BASE/greet/binary")
+assert_eq "standalone executable serves without sources" "hi binary" "$BODY"
+stop_server
+
+# --- a corrupt bundle is rejected ---
+printf 'JSMOCKBC garbage' > "$TMPDIR_BC/bad.jsbc"
+$JSMOCK "$TMPDIR_BC/bad.jsbc" 2>/dev/null
+assert_eq "corrupt bundle exits 1" "1" "$?"
+
+# --- Summary ---
+echo ""
+echo "test_bundle: $PASS/$TESTS passed"
+[ "$FAIL" -eq 0 ] || exit 1
@@ -0,0 +1,75 @@
+#!/bin/bash
+# Test: memoized responses with { cache: { ttl } }
+
+JSMOCK="$(dirname "$0")/../jsmock"
+PASS=0
+FAIL=0
+TESTS=0
+
+assert_eq() {
+    local desc="$1" expected="$2" actual="$3"
+    TESTS=$((TESTS + 1))
+    if [ "$expected" = "$actual" ]; then
+        echo "  PASS: $desc"
+        PASS=$((PASS + 1))
+    else
+        echo "  FAIL: $desc (expected='$expected', got='$actual')"
+        FAIL=$((FAIL + 1))
+    fi
+}
+
+stop_server() {
+    if [ -n "$PID" ]; then
+        kill "$PID" 2>/dev/null
+        wait "$PID" 2>/dev/null || true
+        PID=
+    fi
+}
+trap stop_server EXIT
+
+echo "=== test_cache ==="
+
+$JSMOCK "$(dirname "$0")/fixture_cache.js" 2>/dev/null &
+PID=$!
+sleep 1
+
+BASE="http://127.0.0.1:18097"
+
+# --- repeat hits are served from the cache ---
+A=$(curl -sf "$BASE/rand")
+B=$(curl -sf "$BASE/rand")
+assert_eq "cached response repeats" "$A" "$B"
+
+# --- the query string is part of the key ---
+C=$(curl -sf "$BASE/rand?page=2")
+[ "$A" != "$C" ] && OK=yes || OK=no
+assert_eq "different query, different entry" "yes" "$OK"
+
+# --- routes without cache options always run ---
+A2=$(curl -sf "$BASE/nocache")
+B2=$(curl -sf "$BASE/nocache")
+[ "$A2" != "$B2" ] && OK=yes || OK=no
+assert_eq "uncached route runs every time" "yes" "$OK"
+
+# --- mock.store writes invalidate ---
+curl -sf -X POST "$BASE/bump" >/dev/null
+D=$(curl -sf "$BASE/rand")
+[ "$A" != "$D" ] && OK=yes || OK=no
+assert_eq "store write invalidates" "yes" "$OK"
+
+# --- entries expire after ttl ---
+E=$(curl -sf "$BASE/short")
+sleep 0.4
+F=$(curl -sf "$BASE/short")
+[ "$E" != "$F" ] && OK=yes || OK=no
+assert_eq "entry expires after ttl" "yes" "$OK"
+
+# --- hit/miss counters ---
+read -r HITS MISSES <<< "$(curl -sf "$BASE/stats")"
+assert_eq "hits counted" "1" "$HITS"
+assert_eq "misses counted" "5" "$MISSES"
+
+# --- Summary ---
+echo ""
+echo "test_cache: $PASS/$TESTS passed"
+[ "$FAIL" -eq 0 ] || exit 1
@@ -0,0 +1,96 @@
+#!/bin/bash
+# Test: Transfer-Encoding: chunked request bodies
+
+JSMOCK="$(dirname "$0")/../jsmock"
+PASS=0
+FAIL=0
+TESTS=0
+
+assert_eq() {
+    local desc="$1" expected="$2" actual="$3"
+    TESTS=$((TESTS + 1))
+    if [ "$expected" = "$actual" ]; then
+        echo "  PASS: $desc"
+        PASS=$((PASS + 1))
+    else
+        echo "  FAIL: $desc (expected='$expected', got='$actual')"
+        FAIL=$((FAIL + 1))
+    fi
+}
+
+stop_server() {
+    if [ -n "$PID" ]; then
+        kill "$PID" 2>/dev/null
+        wait "$PID" 2>/dev/null || true
+        PID=
+    fi
+}
+trap stop_server EXIT
+
+# send_pieces PIECE... : write each piece separately, then print the reply
+send_pieces() {
+    exec 3<>/dev/tcp/127.0.0.1/18103
+    for piece in "$@"; do
+        printf '%b' "$piece" >&3
+        sleep 0.05
+    done
+    timeout 2 cat <&3
+    exec 3<&-
+}
+
+echo "=== test_chunked ==="
+
+$JSMOCK "$(dirname "$0")/fixture_chunked.js" 2>/dev/null &
+PID=$!
+sleep 1
+
+BASE="http://127.0.0.1:18103"
+
+# --- curl streams -d as chunks when told to ---
+BODY=$(curl -s --max-time 5 -H "Transfer-Encoding: chunked" -H "Expect:" \
+       -d "hello chunked" "$BASE/echo")
+assert_eq "chunked body from curl" "13:hello chunked" "$BODY"
+
+# --- chunks, extensions and trailers split across reads ---
+RESP=$(send_pieces "POST /echo HTTP/1.1\r\nTransfer-Encoding: chunked\r\nConnection: close\r\n\r\n" \
+       "5;ext=1\r\nhel" "lo\r\n6\r" "\n world\r\n0\r\n" "X-Trailer: t\r\n\r\n" | tail -c 14)
+assert_eq "chunks split across reads" "11:hello world" "$RESP"
+
+# --- keep-alive continues after a chunked body ---
+RESP=$(send_pieces "POST /echo HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabc\r\n0\r\n\r\nGET /ping HTTP/1.1\r\nConnection: close\r\n\r\n" \
+       | grep -ao '3:abc\|pong' | tr '\n' ' ')
+assert_eq "pipelined request after chunked body" "3:abc pong " "$RESP"
+
+# --- size limit ---
+BIG=$(head -c 2000 /dev/zero | tr '\0' 'x')
+CODE=$(curl -s --max-time 5 -o /dev/null -w '%{http_code}' -H "Transfer-Encoding: chunked" \
+       -H "Expect:" -d "$BIG" "$BASE/echo")
+assert_eq "chunked body over the limit" "413" "$CODE"
+
+CODE=$(curl -s --max-time 5 -o /dev/null -w '%{http_code}' -H "Expect:" -d "$BIG" "$BASE/echo")
+assert_eq "Content-Length over the limit" "413" "$CODE"
+
+# --- unsupported codings and broken framing ---
+RESP=$(send_pieces "POST /echo HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n" | head -1 | tr -d '\r')
+assert_eq "unknown transfer coding" "HTTP/1.1 501 Not Implemented" "$RESP"
+
+# a length past 32 bits is not cut down to fit
+RESP=$(send_pieces "POST /echo HTTP/1.1\r\nContent-Length: 4294967301\r\n\r\nhello" | head -1 | tr -d '\r')
+assert_eq "Content-Length past 32 bits" "HTTP/1.1 413 Content Too Large" "$RESP"
+
+# Content-Length is digits only, fits, and agrees with any repeat
+for cl in "10abc" "-1" "99999999999999999999999" "5\r\nContent-Length: 3"; do
+    RESP=$(send_pieces "POST /echo HTTP/1.1\r\nContent-Length: $cl\r\n\r\nhello" | head -1 | tr -d '\r')
+    assert_eq "bad Content-Length: ${cl%%\\*}" "HTTP/1.1 400 Bad Request" "$RESP"
+done
+
+RESP=$(send_pieces "POST /echo HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n" | wc -c)
+assert_eq "bad chunk size closes the connection" "0" "$RESP"
+
+BODY=$(curl -s --max-time 5 "$BASE/ping")
+assert_eq "server still serving" "pong" "$BODY"
+
+# --- Summary ---
+echo ""
+echo "test_chunked: $PASS/$TESTS passed"
+[ "$FAIL" -eq 0 ] || exit 1
@@ -0,0 +1,121 @@
+#!/bin/bash
+# Test: edge-triggered connections and the io_uring engine - reads past one
+# event, big writes, bursts, timers
+
+JSMOCK="$(dirname "$0")/../jsmock"
+PASS=0
+FAIL=0
+TESTS=0
+
+assert_eq() {
+    local desc="$1" expected="$2" actual="$3"
+    TESTS=$((TESTS + 1))
+    if [ "$expected" = "$actual" ]; then
+        echo "  PASS: $desc"
+        PASS=$((PASS + 1))
+    else
+        echo "  FAIL: $desc (expected='$expected', got='$actual')"
+        FAIL=$((FAIL + 1))
+    fi
+}
+
+stop_server() {
+    if [ -n "$PID" ]; then
+        kill "$PID" 2>/dev/null
+        wait "$PID" 2>/dev/null || true
+        PID=
+    fi
+}
+
+BASE="http://127.0.0.1:18109"
+TMP=$(mktemp -d)
+trap 'stop_server; rm -rf "$TMP"' EXIT
+head -c 3000000 /dev/urandom > "$TMP/body"
+
+run_suite() {
+    local mode="$1"
+
+    BODY=$(curl -s --max-time 5 "$BASE/ping" "$BASE/ping")
+    assert_eq "keep-alive requests ($mode)" "pongpong" "$BODY"
+
+    # setTimeout: the loop wakes up for a timer with nothing to read
+    BODY=$(curl -s --max-time 5 "$BASE/delay")
+    assert_eq "timer ($mode)" "late" "$BODY"
+
+    # 3 MB take several rounds of JS_CONN_READ_MAX bytes
+    BODY=$(curl -s --max-time 10 --data-binary "@$TMP/body" "$BASE/size")
+    assert_eq "large buffered body ($mode)" "3000000" "$BODY"
+    BODY=$(curl -s --max-time 10 --data-binary "@$TMP/body" "$BASE/upload")
+    assert_eq "large streamed body ($mode)" "3000000" "$BODY"
+
+    SIZE=$(curl -s --max-time 10 "$BASE/big" | wc -c)
+    assert_eq "large response ($mode)" "1000000" "$SIZE"
+    SIZE=$(curl -s --max-time 10 "$BASE/stream" | wc -c)
+    assert_eq "streamed response ($mode)" "500000" "$SIZE"
+
+    # one write of 100 requests, more than a batch and a read
+    local all=""
+    for i in $(seq 1 100); do
+        all+="GET /n?$i HTTP/1.1\r\n\r\n"
+    done
+    all+="GET /n?end HTTP/1.1\r\nConnection: close\r\n\r\n"
+    exec 3<>/dev/tcp/127.0.0.1/18109
+    printf '%b' "$all" >&3
+    GOT=$(timeout 5 cat <&3 | grep -ao '[a-z0-9]*;' | wc -l)
+    exec 3<&-
+    assert_eq "pipelined requests ($mode)" "101" "$GOT"
+
+    # a burst of clients, more than one accept batch
+    for i in $(seq 1 100); do
+        curl -s --max-time 5 "$BASE/ping" > "$TMP/c$i" &
+    done
+    wait
+    GOT=$(cat "$TMP"/c* | grep -c pong)
+    rm -f "$TMP"/c*
+    assert_eq "100 concurrent connections ($mode)" "100" "$GOT"
+}
+
+echo "=== test_edge ==="
+
+$JSMOCK "$(dirname "$0")/fixture_edge.js" 2>/dev/null &
+PID=$!
+sleep 1
+run_suite edge
+stop_server
+
+WORKERS=2 $JSMOCK "$(dirname "$0")/fixture_edge.js" 2>/dev/null &
+PID=$!
+sleep 1
+run_suite "edge, workers"
+stop_server
+
+EVENTS=level $JSMOCK "$(dirname "$0")/fixture_edge.js" 2>/dev/null &
+PID=$!
+sleep 1
+run_suite level
+stop_server
+
+# a kernel without io_uring falls back to epoll with a warning: say so
+uring_check() {
+    if grep -q "io_uring unavailable" "$TMP/err"; then
+        echo "  NOTE: io_uring unavailable here, the $1 suite ran on epoll"
+    fi
+}
+
+ENGINE=io_uring $JSMOCK "$(dirname "$0")/fixture_edge.js" 2>"$TMP/err" &
+PID=$!
+sleep 1
+uring_check io_uring
+run_suite io_uring
+stop_server
+
+ENGINE=io_uring WORKERS=2 $JSMOCK "$(dirname "$0")/fixture_edge.js" 2>"$TMP/err" &
+PID=$!
+sleep 1
+uring_check "io_uring, workers"
+run_suite "io_uring, workers"
+
+# --- Summary ---
+echo ""
+echo "test_edge: $PASS/$TESTS passed"
+[ "$FAIL" -eq 0 ] || exit 1
@@ -0,0 +1,77 @@
+#!/bin/bash
+# Test: isolation policy — per-request (default) vs recycled per-thread runtimes
+
+JSMOCK="$(dirname "$0")/../jsmock"
+PASS=0
+FAIL=0
+TESTS=0
+
+assert_eq() {
+    local desc="$1" expected="$2" actual="$3"
+    TESTS=$((TESTS + 1))
+    if [ "$expected" = "$actual" ]; then
+        echo "  PASS: $desc"
+        PASS=$((PASS + 1))
+    else
+        echo "  FAIL: $desc (expected='$expected', got='$actual')"
+        FAIL=$((FAIL + 1))
+    fi
+}
+
+stop_server() {
+    if [ -n "$PID" ]; then
+        kill "$PID" 2>/dev/null
+        wait "$PID" 2>/dev/null || true
+        PID=
+        sleep 0.3
+    fi
+}
+trap stop_server EXIT
+
+echo "=== test_isolation ==="
+
+$JSMOCK "$(dirname "$0")/fixture_isolation.js" 2>/dev/null &
+PID=$!
+sleep 1
+
+BASE="http://127.0.0.1:18094"
+
+# --- Test 1: module state persists on one keep-alive connection ---
+# one connection is served by one thread, which reuses its idle runtime
+echo "[1] isolation: thread keeps module state"
+BODY=$(curl -sf "$BASE/hits" "$BASE/hits" "$BASE/hits" | tr -d '\n')
+assert_eq "three hits on one connection" "123" "$BODY"
+
+# --- Test 2: async handler returns its runtime to the pool ---
+echo "[2] async handler recycles runtime"
+# a new connection may land on a thread whose runtime already counted hits
+read -r A B C <<< "$(curl -sf --max-time 5 -w '\n' "$BASE/hits" "$BASE/delayed-hits" \
+                     "$BASE/hits" | tr '\n' ' ')"
+assert_eq "sync, delayed, sync hits share one runtime" \
+          "$((A + 1)) $((A + 2))" "$B $C"
+
+# --- Test 3: top-level code ran at startup, once per worker thread ---
+echo "[3] module evaluated once per thread at startup"
+BODY=$(curl -sf "$BASE/evals")
+assert_eq "evaluations after startup (4 threads)" "4" "$BODY"
+curl -sf "$BASE/hits" "$BASE/hits" > /dev/null
+BODY=$(curl -sf "$BASE/evals")
+assert_eq "requests do not re-evaluate the module" "4" "$BODY"
+
+stop_server
+
+# --- Test 4: default isolation starts every request fresh ---
+echo "[4] isolation: request (default) starts fresh"
+$JSMOCK "$(dirname "$0")/fixture_isolation_request.js" 2>/dev/null &
+PID=$!
+sleep 1
+BODY=$(curl -sf "http://127.0.0.1:18095/hits" "http://127.0.0.1:18095/hits" \
+                "http://127.0.0.1:18095/hits" | tr -d '\n')
+assert_eq "three hits, each in a fresh runtime" "111" "$BODY"
+
+stop_server
+
+# --- Summary ---
+echo ""
+echo "test_isolation: $PASS/$TESTS passed"
+[ "$FAIL" -eq 0 ] || exit 1
@@ -0,0 +1,58 @@
+#!/bin/bash
+# Test: per-runtime memory limit and heap figures in mock.stats()
+
+JSMOCK="$(dirname "$0")/../jsmock"
+PASS=0
+FAIL=0
+TESTS=0
+
+assert_eq() {
+    local desc="$1" expected="$2" actual="$3"
+    TESTS=$((TESTS + 1))
+    if [ "$expected" = "$actual" ]; then
+        echo "  PASS: $desc"
+        PASS=$((PASS + 1))
+    else
+        echo "  FAIL: $desc (expected='$expected', got='$actual')"
+        FAIL=$((FAIL + 1))
+    fi
+}
+
+stop_server() {
+    if [ -n "$PID" ]; then
+        kill "$PID" 2>/dev/null
+        wait "$PID" 2>/dev/null || true
+        PID=
+    fi
+}
+trap stop_server EXIT
+
+echo "=== test_memory ==="
+
+$JSMOCK "$(dirname "$0")/fixture_memory.js" 2>/dev/null &
+PID=$!
+sleep 1
+
+BASE="http://127.0.0.1:18099"
+
+# --- runaway allocation is refused with a 500 ---
+CODE=$(curl -s --max-time 5 -o /dev/null -w '%{http_code}' "$BASE/hog")
+assert_eq "memory limit answers 500" "500" "$CODE"
+
+# --- catching the out-of-memory error does not help ---
+CODE=$(curl -s --max-time 5 -o /dev/null -w '%{http_code}' "$BASE/catch")
+assert_eq "caught OOM still answers 500" "500" "$CODE"
+
+# --- the server keeps serving ---
+BODY=$(curl -s --max-time 5 "$BASE/ok")
+assert_eq "server still responds" "ok" "$BODY"
+curl -s --max-time 5 "$BASE/ok" >/dev/null
+
+# --- counters and per-route heap figures ---
+BODY=$(curl -s --max-time 5 "$BASE/stats")
+assert_eq "stats: exceeded, requests, peak, average" "2 2 true true" "$BODY"
+
+# --- Summary ---
+echo ""
+echo "test_memory: $PASS/$TESTS passed"
+[ "$FAIL" -eq 0 ] || exit 1
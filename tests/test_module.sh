@@ -39,6 +39,20 @@ BASE="http://127.0.0.1:18088"
 BODY=$(curl -sf "$BASE/greet/world")
 assert_eq "import function from module" "hello world" "$BODY"
 
+stop_server
+
+# --- imports are served from bytecode compiled at startup ---
+TMPDIR_MOD=$(mktemp -d)
+cp "$(dirname "$0")/fixture_module.js" "$(dirname "$0")/helper_module.js" "$TMPDIR_MOD"
+$JSMOCK "$TMPDIR_MOD/fixture_module.js" 2>/dev/null &
+PID=$!
+sleep 1
+rm -f "$TMPDIR_MOD/helper_module.js"
+
+BODY=$(curl -sf "$BASE/greet/cache")
+assert_eq "import works after module file is removed" "hello cache" "$BODY"
+rm -rf "$TMPDIR_MOD"
+
 # --- Summary ---
 echo ""
 echo "test_module: $PASS/$TESTS passed"
@@ -0,0 +1,104 @@
+#!/bin/bash
+# Test: requests split across reads, pipelined and without headers
+
+JSMOCK="$(dirname "$0")/../jsmock"
+PASS=0
+FAIL=0
+TESTS=0
+
+assert_eq() {
+    local desc="$1" expected="$2" actual="$3"
+    TESTS=$((TESTS + 1))
+    if [ "$expected" = "$actual" ]; then
+        echo "  PASS: $desc"
+        PASS=$((PASS + 1))
+    else
+        echo "  FAIL: $desc (expected='$expected', got='$actual')"
+        FAIL=$((FAIL + 1))
+    fi
+}
+
+stop_server() {
+    if [ -n "$PID" ]; then
+        kill "$PID" 2>/dev/null
+        wait "$PID" 2>/dev/null || true
+        PID=
+    fi
+}
+trap stop_server EXIT
+
+# send_pieces PIECE... : write each piece separately, then print the reply
+send_pieces() {
+    exec 3<>/dev/tcp/127.0.0.1/18101
+    for piece in "$@"; do
+        printf '%b' "$piece" >&3
+        sleep 0.05
+    done
+    timeout 2 cat <&3
+    exec 3<&-
+}
+
+echo "=== test_parser ==="
+
+$JSMOCK "$(dirname "$0")/fixture_parser.js" 2>/dev/null &
+PID=$!
+sleep 1
+
+BASE="http://127.0.0.1:18101"
+
+# --- plain request ---
+BODY=$(curl -s --max-time 5 -H "X-Tag: t1" "$BASE/echo?a=1")
+assert_eq "path, query and header" "/echo|?a=1|t1" "$BODY"
+
+# --- request head split at every awkward spot ---
+RESP=$(send_pieces "GET /ec" "ho?b=2 HTTP/1.1\r\nX-T" "ag: t2\r" "\nConnection: close\r\n\r" "\n" \
+       | tail -c 13)
+assert_eq "head split across reads" "/echo|?b=2|t2" "$RESP"
+
+# --- body arriving after the head ---
+RESP=$(send_pieces "POST /body HTTP/1.1\r\nContent-Length: 10\r\nConnection: close\r\n\r\n" "01234" "56789" | tail -c 6)
+assert_eq "body split across reads" "len:10" "$RESP"
+
+# --- no headers at all ---
+RESP=$(send_pieces "GET /echo HTTP/1.0\r\n\r\n" | tail -c 7)
+assert_eq "request without headers" "/echo||-" "$RESP"
+
+# --- two pipelined requests in a single write ---
+RESP=$(send_pieces "GET /echo?n=1 HTTP/1.1\r\n\r\nGET /echo?n=2 HTTP/1.1\r\nConnection: close\r\n\r\n" \
+       | grep -ao '/echo|?n=[12]|-' | tr '\n' ' ')
+assert_eq "pipelined requests" "/echo|?n=1|- /echo|?n=2|- " "$RESP"
+
+# --- oversized head is refused ---
+BIG=$(head -c 70000 /dev/zero | tr '\0' 'a')
+CODE=$(curl -s --max-time 5 -o /dev/null -w '%{http_code}' -H "X-Big: $BIG" "$BASE/echo")
+assert_eq "oversized head is answered 431" "431" "$CODE"
+
+# --- too many header fields ---
+HDRS=()
+for i in $(seq 1 70); do
+    HDRS+=(-H "X-H$i: $i")
+done
+CODE=$(curl -s --max-time 5 -o /dev/null -w '%{http_code}' "${HDRS[@]}" "$BASE/echo")
+assert_eq "too many header fields are answered 431" "431" "$CODE"
+
+# --- malformed field names are refused, not skipped ---
+bad_field() {
+    send_pieces "POST /body HTTP/1.1\r\n$1\r\n\r\nhello" | grep -ao 'HTTP/1.1 [0-9]*' | tr '\n' ' '
+}
+assert_eq "space before the colon" "HTTP/1.1 400 " "$(bad_field 'Content-Length : 5')"
+assert_eq "tab before the colon" "HTTP/1.1 400 " "$(bad_field 'Transfer-Encoding\t: chunked')"
+assert_eq "line without a colon" "HTTP/1.1 400 " "$(bad_field 'Content-Length 5')"
+assert_eq "empty field name" "HTTP/1.1 400 " "$(bad_field ': 5')"
+assert_eq "non-token byte in a name" "HTTP/1.1 400 " "$(bad_field 'X(y): 1')"
+assert_eq "obs-fold continuation line" "HTTP/1.1 400 " "$(bad_field 'X-A: 1\r\n folded')"
+RESP=$(send_pieces "GET /echo HTTP/1.1\r\nX-a.b_c~!#\$%&'*+^\`|: t3\r\nX-Tag: t3\r\nConnection: close\r\n\r\n" \
+       | tail -c 9)
+assert_eq "token punctuation in a name" "/echo||t3" "$RESP"
+
+BODY=$(curl -s --max-time 5 "$BASE/echo")
+assert_eq "server still serving" "/echo||-" "$BODY"
+
+# --- Summary ---
+echo ""
+echo "test_parser: $PASS/$TESTS passed"
+[ "$FAIL" -eq 0 ] || exit 1
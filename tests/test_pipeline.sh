@@ -0,0 +1,101 @@
+#!/bin/bash
+# Test: pipelined requests - batches, order, async overlap, Connection: close
+
+JSMOCK="$(dirname "$0")/../jsmock"
+PASS=0
+FAIL=0
+TESTS=0
+
+assert_eq() {
+    local desc="$1" expected="$2" actual="$3"
+    TESTS=$((TESTS + 1))
+    if [ "$expected" = "$actual" ]; then
+        echo "  PASS: $desc"
+        PASS=$((PASS + 1))
+    else
+        echo "  FAIL: $desc (expected='$expected', got='$actual')"
+        FAIL=$((FAIL + 1))
+    fi
+}
+
+stop_server() {
+    if [ -n "$PID" ]; then
+        kill "$PID" 2>/dev/null
+        wait "$PID" 2>/dev/null || true
+        PID=
+    fi
+}
+trap stop_server EXIT
+
+# pipeline REQ... : send all requests in one write, print the reply
+pipeline() {
+    local all=""
+    for r in "$@"; do
+        all+="GET $r HTTP/1.1\r\nHost: x\r\n\r\n"
+    done
+    all+="GET /n?end HTTP/1.1\r\nConnection: close\r\n\r\n"
+    exec 3<>/dev/tcp/127.0.0.1/18108
+    printf '%b' "$all" >&3
+    timeout 5 cat <&3
+    exec 3<&-
+}
+
+# bodies ending in ';', in the order they came back
+bodies() {
+    grep -ao '[a-z0-9]*;' | tr -d '\n'
+}
+
+run_suite() {
+    local mode="$1" reqs=() want=""
+
+    # more than one batch, handlers, static and cached routes mixed
+    for i in $(seq 1 80); do
+        case $((i % 4)) in
+            0) reqs+=("/static"); want+="s;" ;;
+            1) reqs+=("/cached"); want+="c;" ;;
+            *) reqs+=("/n?$i"); want+="$i;" ;;
+        esac
+    done
+    GOT=$(pipeline "${reqs[@]}" | bodies)
+    assert_eq "80 pipelined responses in order ($mode)" "${want}end;" "$GOT"
+
+    # large responses end a batch early; nothing is lost
+    GOT=$(pipeline /n?1 /big /n?2 /big /n?3 | grep -ao '[0-9]*;\|HTTP/1.1 200' \
+          | tr '\n' ' ')
+    assert_eq "batches split by large bodies ($mode)" \
+        "HTTP/1.1 200 1; HTTP/1.1 200 HTTP/1.1 200 2; HTTP/1.1 200 HTTP/1.1 200 3; HTTP/1.1 200 end; " \
+        "$GOT"
+
+    # async handlers overlap; their replies still come back in order
+    local start=$(date +%s%N)
+    GOT=$(pipeline /delay?400 /delay?400 /delay?100 /n?1 /static /delay?400 | bodies)
+    local ms=$(( ($(date +%s%N) - start) / 1000000 ))
+    assert_eq "async replies in order ($mode)" "d400;d400;d100;1;s;d400;end;" "$GOT"
+    assert_eq "async handlers overlap ($mode)" "yes" \
+        "$([ "$ms" -lt 1000 ] && echo yes || echo "no (${ms}ms)")"
+
+    # requests after Connection: close are not answered
+    exec 3<>/dev/tcp/127.0.0.1/18108
+    printf 'GET /n?a HTTP/1.1\r\n\r\nGET /n?b HTTP/1.1\r\nConnection: close\r\n\r\nGET /n?c HTTP/1.1\r\n\r\n' >&3
+    GOT=$(timeout 5 cat <&3 | bodies)
+    exec 3<&-
+    assert_eq "close ends the batch ($mode)" "a;b;" "$GOT"
+}
+
+echo "=== test_pipeline ==="
+
+$JSMOCK "$(dirname "$0")/fixture_pipeline.js" 2>/dev/null &
+PID=$!
+sleep 1
+run_suite inline
+stop_server
+
+WORKERS=2 $JSMOCK "$(dirname "$0")/fixture_pipeline.js" 2>/dev/null &
+PID=$!
+sleep 1
+run_suite workers
+
+# --- Summary ---
+echo ""
+echo "test_pipeline: $PASS/$TESTS passed"
+[ "$FAIL" -eq 0 ] || exit 1
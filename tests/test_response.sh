@@ -56,6 +56,26 @@ assert_eq "custom Content-Type" "application/json" "$CT"
 XCUSTOM=$(curl -sf -D - -o /dev/null "$BASE/custom" 2>/dev/null | grep -i "X-Custom:" | tr -d '\r' | awk '{print $2}')
 assert_eq "custom X-Custom header" "test-value" "$XCUSTOM"
 
+# --- statuses outside 200..599 throw; a non-Response is a 500 ---
+for s in 0 NaN 99 600 200.5; do
+    BODY=$(curl -s --max-time 5 "$BASE/bad-status?$s")
+    assert_eq "status $s rejected" "RangeError" "$BODY"
+done
+BODY=$(curl -s --max-time 5 "$BASE/bad-status?599")
+assert_eq "status 599 kept" "kept" "$BODY"
+STATUS=$(curl -s --max-time 5 -o /dev/null -w '%{http_code}' "$BASE/not-response")
+assert_eq "non-Response answered 500" "500" "$STATUS"
+
+BODY=$(curl -s --max-time 5 "$BASE/bad-body")
+assert_eq "throwing body reaches the handler" "caught: no body" "$BODY"
+
+# pipelined behind it, the next request still gets its own answer
+exec 3<>/dev/tcp/127.0.0.1/18085
+printf 'GET /not-response HTTP/1.1\r\n\r\nGET /string HTTP/1.1\r\nConnection: close\r\n\r\n' >&3
+GOT=$(timeout 5 cat <&3 | grep -ao 'HTTP/1.1 [0-9]*\|hello world' | tr '\n' ' ')
+exec 3<&-
+assert_eq "pipelined after a non-Response" "HTTP/1.1 500 HTTP/1.1 200 hello world " "$GOT"
+
 # --- Summary ---
 echo ""
 echo "test_response: $PASS/$TESTS passed"
@@ -0,0 +1,92 @@
+#!/bin/bash
+# Test: response serialization - status lines, Date, long headers, large bodies
+
+JSMOCK="$(dirname "$0")/../jsmock"
+PASS=0
+FAIL=0
+TESTS=0
+
+assert_eq() {
+    local desc="$1" expected="$2" actual="$3"
+    TESTS=$((TESTS + 1))
+    if [ "$expected" = "$actual" ]; then
+        echo "  PASS: $desc"
+        PASS=$((PASS + 1))
+    else
+        echo "  FAIL: $desc (expected='$expected', got='$actual')"
+        FAIL=$((FAIL + 1))
+    fi
+}
+
+stop_server() {
+    if [ -n "$PID" ]; then
+        kill "$PID" 2>/dev/null
+        wait "$PID" 2>/dev/null || true
+        PID=
+    fi
+}
+trap stop_server EXIT
+
+echo "=== test_serialize ==="
+
+$JSMOCK "$(dirname "$0")/fixture_serialize.js" 2>/dev/null &
+PID=$!
+sleep 1
+
+BASE="http://127.0.0.1:18106"
+
+status_line() {
+    curl -s --max-time 5 -D - -o /dev/null "$BASE$1" | head -1 | tr -d '\r'
+}
+
+# --- status lines beyond the common codes ---
+assert_eq "418 status line" "HTTP/1.1 418 I'm a teapot" "$(status_line /teapot)"
+assert_eq "422 status line" "HTTP/1.1 422 Unprocessable Content" \
+    "$(status_line /unprocessable)"
+assert_eq "unregistered code" "HTTP/1.1 599 Unknown" "$(status_line /odd)"
+
+# --- headers are not cut at 256 bytes ---
+LEN=$(curl -s --max-time 5 -D - -o /dev/null "$BASE/long" \
+      | grep -i "^X-Long:" | tr -d '\r' | awk '{print length($2)}')
+assert_eq "1000-byte header value" "1000" "$LEN"
+
+# --- Date on dynamic, cached and static responses ---
+DATE_RE='^Date: [A-Z][a-z]{2}, [0-9]{2} [A-Z][a-z]{2} [0-9]{4} [0-9:]{8} GMT'
+for path in /long /cached /cached /static; do
+    N=$(curl -s --max-time 5 -D - -o /dev/null "$BASE$path" \
+        | tr -d '\r' | grep -cE "$DATE_RE")
+    assert_eq "Date header on $path" "1" "$N"
+done
+
+BODY=$(curl -s --max-time 5 "$BASE/static")
+assert_eq "static body after Date" "constant" "$BODY"
+
+# --- a large body is written from its own buffer ---
+SUM=$(curl -s --max-time 10 "$BASE/big" | md5sum | cut -d' ' -f1)
+WANT=$(for i in $(seq 65536); do printf 0123456789abcdef; done | md5sum | cut -d' ' -f1)
+assert_eq "1MB body intact" "$WANT" "$SUM"
+
+# --- keep-alive: a large body, then a small one on the same connection ---
+OUT=$(curl -s --max-time 10 -o /dev/null -o - -w '%{num_connects}\n' \
+      "$BASE/big" "$BASE/teapot" | tail -1)
+assert_eq "reused after a large body" "short and stout0" "$OUT"
+
+SUM=$(curl -s --max-time 10 "$BASE/kept" | md5sum | cut -d' ' -f1)
+assert_eq "body kept by JS intact" "$WANT" "$SUM"
+
+# --- with workers the body is released on another thread ---
+stop_server
+WORKERS=2 $JSMOCK "$(dirname "$0")/fixture_serialize.js" 2>/dev/null &
+PID=$!
+sleep 1
+
+GOOD=$(for i in 1 2 3 4 5 6 7 8; do
+           curl -s --max-time 10 "$BASE/kept" | md5sum | cut -d' ' -f1 &
+       done; wait)
+GOOD=$(echo "$GOOD" | grep -c "^$WANT$")
+assert_eq "8 parallel bodies intact (workers)" "8" "$GOOD"
+
+# --- Summary ---
+echo ""
+echo "test_serialize: $PASS/$TESTS passed"
+[ "$FAIL" -eq 0 ] || exit 1
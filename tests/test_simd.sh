@@ -0,0 +1,56 @@
+#!/bin/bash
+# Test: SIMD and scalar header scanners parse the same requests
+
+JSMOCK="$(dirname "$0")/../jsmock"
+PASS=0
+FAIL=0
+TESTS=0
+
+assert_eq() {
+    local desc="$1" expected="$2" actual="$3"
+    TESTS=$((TESTS + 1))
+    if [ "$expected" = "$actual" ]; then
+        echo "  PASS: $desc"
+        PASS=$((PASS + 1))
+    else
+        echo "  FAIL: $desc (expected='$expected', got='$actual')"
+        FAIL=$((FAIL + 1))
+    fi
+}
+
+stop_server() {
+    if [ -n "$PID" ]; then
+        kill "$PID" 2>/dev/null
+        wait "$PID" 2>/dev/null || true
+        PID=
+    fi
+}
+trap stop_server EXIT
+
+echo "=== test_simd ==="
+
+BASE="http://127.0.0.1:18102"
+COOKIE=$(head -c 6000 /dev/zero | tr '\0' 'c')
+TRACE="00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01"
+
+# JSMOCK_SIMD caps the scanner; unknown CPUs fall back to scalar anyway
+for impl in avx2 sse4.2 scalar; do
+    JSMOCK_SIMD=$impl $JSMOCK "$(dirname "$0")/fixture_simd.js" 2>/dev/null &
+    PID=$!
+    sleep 1
+
+    BODY=$(curl -s --max-time 5 -H "Cookie: $COOKIE" -H "traceparent: $TRACE" \
+           -H "X-Last: end" "$BASE/headers")
+    assert_eq "$impl: large headers" "6000|$TRACE|end" "$BODY"
+
+    BODY=$(curl -s --max-time 5 -H "CONTENT-type: text/x-test" -H "Connection: close" \
+           -d "a:b c?d" "$BASE/body")
+    assert_eq "$impl: mixed-case Content-Type and body" "text/x-test|a:b c?d" "$BODY"
+
+    stop_server
+done
+
+# --- Summary ---
+echo ""
+echo "test_simd: $PASS/$TESTS passed"
+[ "$FAIL" -eq 0 ] || exit 1
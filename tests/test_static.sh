@@ -0,0 +1,83 @@
+#!/bin/bash
+# Test: static responses served without running JS
+
+JSMOCK="$(dirname "$0")/../jsmock"
+PASS=0
+FAIL=0
+TESTS=0
+
+assert_eq() {
+    local desc="$1" expected="$2" actual="$3"
+    TESTS=$((TESTS + 1))
+    if [ "$expected" = "$actual" ]; then
+        echo "  PASS: $desc"
+        PASS=$((PASS + 1))
+    else
+        echo "  FAIL: $desc (expected='$expected', got='$actual')"
+        FAIL=$((FAIL + 1))
+    fi
+}
+
+stop_server() {
+    if [ -n "$PID" ]; then
+        kill "$PID" 2>/dev/null
+        wait "$PID" 2>/dev/null || true
+        PID=
+    fi
+}
+trap stop_server EXIT
+
+echo "=== test_static ==="
+
+$JSMOCK "$(dirname "$0")/fixture_static.js" 2>/dev/null &
+PID=$!
+sleep 1
+
+BASE="http://127.0.0.1:18096"
+
+# --- mock.static(method, path, body, init) ---
+BODY=$(curl -s "$BASE/static")
+assert_eq "static body" "hello static" "$BODY"
+
+STATUS=$(curl -s -o /dev/null -w '%{http_code}' "$BASE/static")
+assert_eq "static status" "201" "$STATUS"
+
+CT=$(curl -s -o /dev/null -w '%{content_type}' "$BASE/static")
+assert_eq "static Content-Type" "text/plain" "$CT"
+
+# --- mock.get(path, constantResponse) ---
+BODY=$(curl -sf "$BASE/health")
+assert_eq "module-level Response" "ok" "$BODY"
+
+KIND=$(curl -sf -D - -o /dev/null "$BASE/health" | grep -i "X-Kind:" | tr -d '\r' | awk '{print $2}')
+assert_eq "module-level Response header" "constant" "$KIND"
+
+# --- JS handlers still work alongside ---
+BODY=$(curl -sf "$BASE/dynamic")
+assert_eq "JS handler" "dynamic" "$BODY"
+
+# --- static routes are matched before JS routes ---
+BODY=$(curl -sf "$BASE/shadow")
+assert_eq "static wins over handler" "from static" "$BODY"
+
+# --- method and path parameters ---
+STATUS=$(curl -s -o /dev/null -w '%{http_code}' "$BASE/only-post")
+assert_eq "method mismatch falls through" "404" "$STATUS"
+
+BODY=$(curl -sf -X POST "$BASE/only-post")
+assert_eq "static POST" "posted" "$BODY"
+
+BODY=$(curl -sf "$BASE/users/42")
+assert_eq "static with path param" "any user" "$BODY"
+
+# --- keep-alive and Connection: close variants ---
+BODY=$(curl -sf "$BASE/static" "$BASE/health" "$BASE/static")
+assert_eq "static responses on one connection" "hello staticokhello static" "$BODY"
+
+CONN=$(curl -sf -D - -o /dev/null -H "Connection: close" "$BASE/static" | grep -i "^Connection:" | tr -d '\r' | awk '{print $2}')
+assert_eq "Connection: close honored" "close" "$CONN"
+
+# --- Summary ---
+echo ""
+echo "test_static: $PASS/$TESTS passed"
+[ "$FAIL" -eq 0 ] || exit 1
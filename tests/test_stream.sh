@@ -0,0 +1,96 @@
+#!/bin/bash
+# Test: streamed request bodies ({ stream } routes)
+
+JSMOCK="$(dirname "$0")/../jsmock"
+PASS=0
+FAIL=0
+TESTS=0
+
+assert_eq() {
+    local desc="$1" expected="$2" actual="$3"
+    TESTS=$((TESTS + 1))
+    if [ "$expected" = "$actual" ]; then
+        echo "  PASS: $desc"
+        PASS=$((PASS + 1))
+    else
+        echo "  FAIL: $desc (expected='$expected', got='$actual')"
+        FAIL=$((FAIL + 1))
+    fi
+}
+
+stop_server() {
+    if [ -n "$PID" ]; then
+        kill "$PID" 2>/dev/null
+        wait "$PID" 2>/dev/null || true
+        PID=
+    fi
+}
+TMP=$(mktemp -d)
+trap 'stop_server; rm -rf "$TMP"' EXIT
+
+# 3 MB of bytes 0..255 and its byte sum mod 65536
+head -c 3145728 /dev/urandom > "$TMP/big"
+SUM=$(od -An -v -tu1 "$TMP/big" | awk '{ for (i = 1; i <= NF; i++) s = (s + $i) % 65536 } END { print s }')
+
+BASE="http://127.0.0.1:18104"
+
+run_suite() {
+    local mode="$1"
+
+    BODY=$(curl -s --max-time 10 --data-binary @"$TMP/big" -H "Expect:" "$BASE/iter")
+    assert_eq "$mode: for await over a large body" "3145728:true" "$BODY"
+
+    BODY=$(curl -s --max-time 5 -H "Transfer-Encoding: chunked" -H "Expect:" \
+           -d "hello stream" "$BASE/text")
+    assert_eq "$mode: text() of a chunked stream" "hello stream" "$BODY"
+
+    BODY=$(curl -s --max-time 10 --data-binary @"$TMP/big" -H "Expect:" "$BASE/reader")
+    assert_eq "$mode: reader over a spilled body" "$SUM" "$BODY"
+
+    # past the route's own limit, not limits.body
+    CODE=$(head -c 5000000 /dev/zero | curl -s --max-time 10 -o /dev/null -w '%{http_code}' \
+           --data-binary @- -H "Expect:" "$BASE/reader")
+    assert_eq "$mode: stream limit" "413" "$CODE"
+
+    # under the route's limit but over limits.body, which the others keep
+    BODY=$(head -c 4000000 /dev/zero | curl -s --max-time 10 --data-binary @- \
+           -H "Expect:" "$BASE/reader")
+    assert_eq "$mode: route limit above limits.body" "0" "$BODY"
+    CODE=$(head -c 4000000 /dev/zero | curl -s --max-time 10 -o /dev/null -w '%{http_code}' \
+           --data-binary @- -H "Expect:" "$BASE/iter")
+    assert_eq "$mode: limits.body applies to streamed routes" "413" "$CODE"
+
+    BODY=$(curl -s --max-time 5 -d "abc" "$BASE/buffered")
+    assert_eq "$mode: buffered routes unchanged" "true:abc" "$BODY"
+
+    # pipelined behind an async reply: the stream waits for it, then runs
+    exec 3<>/dev/tcp/127.0.0.1/18104
+    printf 'GET /delay HTTP/1.1\r\n\r\nPOST /text HTTP/1.1\r\nContent-Length: 3\r\n\r\nabcGET /ping HTTP/1.1\r\nConnection: close\r\n\r\n' >&3
+    BODY=$(timeout 5 cat <&3 | grep -ao 'delayed\|abc\|pong' | tr '\n' ' ')
+    exec 3<&-
+    assert_eq "$mode: streamed request pipelined behind async" "delayed abc pong " "$BODY"
+
+    BODY=$(curl -s --max-time 5 "$BASE/ping")
+    assert_eq "$mode: server still serving" "pong" "$BODY"
+}
+
+echo "=== test_stream ==="
+
+$JSMOCK "$(dirname "$0")/fixture_stream.js" 2>/dev/null &
+PID=$!
+sleep 1
+
+run_suite "inline"
+
+stop_server
+
+WORKERS=2 $JSMOCK "$(dirname "$0")/fixture_stream.js" 2>/dev/null &
+PID=$!
+sleep 1
+
+run_suite "workers"
+
+# --- Summary ---
+echo ""
+echo "test_stream: $PASS/$TESTS passed"
+[ "$FAIL" -eq 0 ] || exit 1
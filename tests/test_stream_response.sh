@@ -0,0 +1,90 @@
+#!/bin/bash
+# Test: ReadableStream and async iterable response bodies
+
+JSMOCK="$(dirname "$0")/../jsmock"
+PASS=0
+FAIL=0
+TESTS=0
+
+assert_eq() {
+    local desc="$1" expected="$2" actual="$3"
+    TESTS=$((TESTS + 1))
+    if [ "$expected" = "$actual" ]; then
+        echo "  PASS: $desc"
+        PASS=$((PASS + 1))
+    else
+        echo "  FAIL: $desc (expected='$expected', got='$actual')"
+        FAIL=$((FAIL + 1))
+    fi
+}
+
+stop_server() {
+    if [ -n "$PID" ]; then
+        kill "$PID" 2>/dev/null
+        wait "$PID" 2>/dev/null || true
+        PID=
+    fi
+}
+trap stop_server EXIT
+
+BASE="http://127.0.0.1:18105"
+
+echo "=== test_stream_response ==="
+
+$JSMOCK "$(dirname "$0")/fixture_stream_response.js" 2>/dev/null &
+PID=$!
+sleep 1
+
+BODY=$(curl -s --max-time 5 "$BASE/gen")
+assert_eq "async generator body" "abc" "$BODY"
+
+TE=$(curl -s --max-time 5 -D - -o /dev/null "$BASE/gen" | grep -i '^transfer-encoding' | tr -d '\r')
+assert_eq "sent chunked" "Transfer-Encoding: chunked" "$TE"
+
+BODY=$(curl -s --max-time 5 "$BASE/enqueue")
+assert_eq "ReadableStream body" "hello stream" "$BODY"
+
+SIZE=$(curl -s --max-time 20 "$BASE/big" | wc -c | tr -d ' ')
+assert_eq "16 MB pulled stream" "16777216" "$SIZE"
+
+# the first chunk goes out before the stream is finished
+TIMES=$(curl -s --max-time 5 -o /dev/null -w '%{time_starttransfer} %{time_total}' "$BASE/slow")
+FIRST=$(echo "$TIMES" | awk '{ print ($1 < 0.3) ? "early" : "late" }')
+TOTAL=$(echo "$TIMES" | awk '{ print ($2 >= 0.35) ? "waited" : "short" }')
+assert_eq "first byte before the end" "early waited" "$FIRST $TOTAL"
+
+BODY=$(curl -s --max-time 5 "$BASE/slow")
+assert_eq "timer-fed stream" "first 1 2 " "$BODY"
+
+curl -s --max-time 5 "$BASE/broken" > /dev/null
+assert_eq "errored stream cuts the body short" "18" "$?"
+
+BODY=$(curl -s --max-time 5 "$BASE/gen" "$BASE/ping")
+assert_eq "keep-alive after a streamed body" "abcpong" "$BODY"
+
+stop_server
+
+# workers collect the stream and answer with a Content-Length
+WORKERS=2 $JSMOCK "$(dirname "$0")/fixture_stream_response.js" 2>/dev/null &
+PID=$!
+sleep 1
+
+BODY=$(curl -s --max-time 5 "$BASE/slow")
+assert_eq "workers: timer-fed stream" "first 1 2 " "$BODY"
+
+CL=$(curl -s --max-time 5 -D - -o /dev/null "$BASE/enqueue" | grep -i '^content-length' | tr -d '\r')
+assert_eq "workers: sent whole" "Content-Length: 12" "$CL"
+
+# strings and a Uint8Array from an async generator, collected in order
+OUT=$(curl -s --max-time 5 -D - "$BASE/gen" | tr -d '\r')
+CL=$(echo "$OUT" | grep -i '^content-length')
+assert_eq "workers: async generator body" "abc Content-Length: 3" \
+    "$(echo "$OUT" | tail -1) $CL"
+
+CODE=$(curl -s --max-time 5 -o /dev/null -w '%{http_code}' "$BASE/broken")
+assert_eq "workers: errored stream" "500" "$CODE"
+
+# --- Summary ---
+echo ""
+echo "test_stream_response: $PASS/$TESTS passed"
+[ "$FAIL" -eq 0 ] || exit 1
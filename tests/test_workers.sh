@@ -0,0 +1,72 @@
+#!/bin/bash
+# Test: JS handlers on worker threads, separate from the I/O event loop
+
+JSMOCK="$(dirname "$0")/../jsmock"
+PASS=0
+FAIL=0
+TESTS=0
+
+assert_eq() {
+    local desc="$1" expected="$2" actual="$3"
+    TESTS=$((TESTS + 1))
+    if [ "$expected" = "$actual" ]; then
+        echo "  PASS: $desc"
+        PASS=$((PASS + 1))
+    else
+        echo "  FAIL: $desc (expected='$expected', got='$actual')"
+        FAIL=$((FAIL + 1))
+    fi
+}
+
+stop_server() {
+    if [ -n "$PID" ]; then
+        kill "$PID" 2>/dev/null
+        wait "$PID" 2>/dev/null || true
+        PID=
+    fi
+}
+trap stop_server EXIT
+
+echo "=== test_workers ==="
+
+$JSMOCK "$(dirname "$0")/fixture_workers.js" 2>/dev/null &
+PID=$!
+sleep 1
+
+BASE="http://127.0.0.1:18100"
+
+# --- handlers run and reply through the I/O thread ---
+BODY=$(curl -s --max-time 5 "$BASE/users/42")
+assert_eq "sync handler on a worker" "user:42" "$BODY"
+
+BODY=$(curl -s --max-time 5 "$BASE/delayed")
+assert_eq "setTimeout on a worker" "delayed" "$BODY"
+
+CODE=$(curl -s --max-time 5 -o /dev/null -w '%{http_code}' "$BASE/missing")
+assert_eq "404 from a worker" "404" "$CODE"
+
+# --- keep-alive across worker replies ---
+BODY=$(curl -s --max-time 5 "$BASE/fast" "$BASE/users/7" "$BASE/fast")
+assert_eq "three requests on one connection" "fastuser:7fast" "$BODY"
+
+# --- a busy handler does not block the single I/O thread ---
+curl -s --max-time 5 "$BASE/slow" >/dev/null &
+SLOW=$!
+sleep 0.1
+START=$(date +%s%N)
+BODY=$(curl -s --max-time 5 "$BASE/fast")
+ELAPSED=$(( ($(date +%s%N) - START) / 1000000 ))
+wait $SLOW
+assert_eq "fast route answers during slow one" "fast" "$BODY"
+[ "$ELAPSED" -lt 300 ] && OK=yes || OK=no
+assert_eq "fast route not queued behind slow one (${ELAPSED}ms)" "yes" "$OK"
+
+# --- responses from workers are memoized ---
+A=$(curl -s --max-time 5 "$BASE/cached")
+B=$(curl -s --max-time 5 "$BASE/cached")
+assert_eq "cached response repeats" "$A" "$B"
+
+# --- Summary ---
+echo ""
+echo "test_workers: $PASS/$TESTS passed"
+[ "$FAIL" -eq 0 ] || exit 1